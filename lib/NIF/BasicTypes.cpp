@@ -89,6 +89,10 @@ void NiHeader::Clear() {
 	blockTypeIndices.clear();
 	blockSizes.clear();
 	strings.clear();
+	blockTypeIndex.clear();
+	stringIndex.clear();
+	numDeferredBlocks = 0;
+	blockIndex.Clear();
 }
 
 std::string NiHeader::GetCreatorInfo() {
@@ -134,8 +138,38 @@ void NiHeader::SetExportInfo(const std::string& exportInfo) {
 	}
 }
 
+void NiHeader::SetBlockReference(std::vector<std::unique_ptr<NiObject>>* blockRef) {
+	blocks = blockRef;
+
+	numDeferredBlocks = 0;
+	if (blocks) {
+		for (auto &b : (*blocks))
+			if (dynamic_cast<NiDeferredBlock*>(b.get()))
+				numDeferredBlocks++;
+
+		blockIndex.Rebuild(*blocks);
+	}
+	else
+		blockIndex.Clear();
+}
+
+void NiHeader::BlockRenamed(const int blockId, const std::string& oldName, const std::string& newName) {
+	blockIndex.Rename(blockId, oldName, newName);
+}
+
+void NiHeader::ReplaceDeferredBlock(const int blockId, NiObject* block) {
+	NiObject* deferred = (*blocks)[blockId].get();
+	if (!dynamic_cast<NiDeferredBlock*>(deferred))
+		return;
+
+	blockIndex.Erase(deferred, blockId);
+	(*blocks)[blockId].reset(block);
+	blockIndex.Insert(block, blockId);
+	numDeferredBlocks--;
+}
+
 void NiHeader::DeleteBlock(int blockId) {
-	if (blockId == 0xFFFFFFFF)
+	if (blockId < 0 || blockId >= (int)numBlocks || HasDeferredBlocks())
 		return;
 
 	ushort blockTypeId = blockTypeIndices[blockId];
@@ -150,34 +184,111 @@ void NiHeader::DeleteBlock(int blockId) {
 		for (int i = 0; i < blockTypeIndices.size(); i++)
 			if (blockTypeIndices[i] > blockTypeId)
 				blockTypeIndices[i]--;
+
+		UpdateBlockTypeIndex();
 	}
 
+	std::unique_ptr<NiObject> block = std::move((*blocks)[blockId]);
 	blocks->erase(blocks->begin() + blockId);
 	numBlocks--;
 	blockTypeIndices.erase(blockTypeIndices.begin() + blockId);
 	blockSizes.erase(blockSizes.begin() + blockId);
+	blockIndex.EraseShifted(block.get(), blockId, *blocks);
 
 	// Next tell all the blocks that the deletion happened
 	for (auto &b : (*blocks))
 		BlockDeleted(b.get(), blockId);
 }
 
-void NiHeader::DeleteBlockByType(const std::string& blockTypeStr) {
-	ushort blockTypeId;
-	for (blockTypeId = 0; blockTypeId < numBlockTypes; blockTypeId++)
-		if (blockTypes[blockTypeId].GetString() == blockTypeStr)
-			break;
+void NiHeader::DeleteBlocks(const std::vector<int>& blockIds) {
+	if (HasDeferredBlocks())
+		return;
+
+	std::vector<bool> deleted(numBlocks, false);
+	std::vector<bool> deletedType(blockTypes.size(), false);
+	int deleteCount = 0;
+	for (auto &id : blockIds) {
+		if (id < 0 || id >= (int)numBlocks || deleted[id])
+			continue;
+
+		deleted[id] = true;
+		deletedType[blockTypeIndices[id]] = true;
+		deleteCount++;
+	}
+
+	if (deleteCount == 0)
+		return;
+
+	// New index of every block, 0xFFFFFFFF for deleted ones
+	int oldNumBlocks = numBlocks;
+	std::vector<int> indexMap(oldNumBlocks);
+	int newIndex = 0;
+	for (int i = 0; i < oldNumBlocks; i++) {
+		if (deleted[i]) {
+			indexMap[i] = 0xFFFFFFFF;
+			continue;
+		}
+
+		indexMap[i] = newIndex;
+		if (newIndex != i) {
+			(*blocks)[newIndex] = std::move((*blocks)[i]);
+			blockTypeIndices[newIndex] = blockTypeIndices[i];
+			blockSizes[newIndex] = blockSizes[i];
+		}
+		newIndex++;
+	}
+
+	blocks->resize(newIndex);
+	blockTypeIndices.resize(newIndex);
+	blockSizes.resize(newIndex);
+	numBlocks = newIndex;
+
+	// Remove the types of the deleted blocks that are no longer used
+	std::vector<int> typeUsage(blockTypes.size(), 0);
+	for (auto &bt : blockTypeIndices)
+		typeUsage[bt]++;
+
+	std::vector<ushort> typeMap(blockTypes.size());
+	ushort newTypeId = 0;
+	for (int t = 0; t < blockTypes.size(); t++) {
+		typeMap[t] = newTypeId;
+		if (typeUsage[t] > 0 || !deletedType[t]) {
+			if (newTypeId != t)
+				blockTypes[newTypeId] = blockTypes[t];
+			newTypeId++;
+		}
+	}
+
+	if (newTypeId != blockTypes.size()) {
+		blockTypes.resize(newTypeId);
+		numBlockTypes = newTypeId;
+		for (auto &bt : blockTypeIndices)
+			bt = typeMap[bt];
+
+		UpdateBlockTypeIndex();
+	}
+
+	// Next tell all the blocks that the deletion happened
+	for (auto &b : (*blocks))
+		BlocksDeleted(b.get(), indexMap, deleteCount);
+
+	// Every block after the first deleted one moved
+	blockIndex.Rebuild(*blocks);
+}
 
-	if (blockTypeId == numBlockTypes)
+void NiHeader::DeleteBlockByType(const std::string& blockTypeStr) {
+	auto it = blockTypeIndex.find(blockTypeStr);
+	if (it == blockTypeIndex.end())
 		return;
 
+	ushort blockTypeId = it->second;
+
 	std::vector<int> indices;
 	for (int i = 0; i < numBlocks; i++)
 		if (blockTypeIndices[i] == blockTypeId)
 			indices.push_back(i);
 
-	for (int j = indices.size() - 1; j >= 0; j--)
-		DeleteBlock(indices[j]);
+	DeleteBlocks(indices);
 }
 
 int NiHeader::AddBlock(NiObject* newBlock) {
@@ -186,6 +297,7 @@ int NiHeader::AddBlock(NiObject* newBlock) {
 	blockSizes.push_back(0);
 	blocks->push_back(std::move(std::unique_ptr<NiObject>(newBlock)));
 	numBlocks = blocks->size();
+	blockIndex.Insert(newBlock, numBlocks - 1);
 	return numBlocks - 1;
 }
 
@@ -193,7 +305,20 @@ int NiHeader::ReplaceBlock(int oldBlockId, NiObject* newBlock) {
 	if (oldBlockId == 0xFFFFFFFF)
 		return 0xFFFFFFFF;
 
+	if (dynamic_cast<NiDeferredBlock*>((*blocks)[oldBlockId].get()))
+		numDeferredBlocks--;
+
 	ushort blockTypeId = blockTypeIndices[oldBlockId];
+	if (blockTypes[blockTypeId].GetString() == newBlock->GetBlockName()) {
+		// Same block type, keep the type table as it is
+		blockSizes[oldBlockId] = 0;
+		blockIndex.Erase((*blocks)[oldBlockId].get(), oldBlockId);
+		auto blockPtrSwap = std::unique_ptr<NiObject>(newBlock);
+		(*blocks)[oldBlockId].swap(blockPtrSwap);
+		blockIndex.Insert(newBlock, oldBlockId);
+		return oldBlockId;
+	}
+
 	int blockTypeRefCount = 0;
 	for (int i = 0; i < blockTypeIndices.size(); i++)
 		if (blockTypeIndices[i] == blockTypeId)
@@ -205,13 +330,17 @@ int NiHeader::ReplaceBlock(int oldBlockId, NiObject* newBlock) {
 		for (int i = 0; i < blockTypeIndices.size(); i++)
 			if (blockTypeIndices[i] > blockTypeId)
 				blockTypeIndices[i]--;
+
+		UpdateBlockTypeIndex();
 	}
 
 	ushort btID = AddOrFindBlockTypeId(newBlock->GetBlockName());
 	blockTypeIndices[oldBlockId] = btID;
 	blockSizes[oldBlockId] = 0;
+	blockIndex.Erase((*blocks)[oldBlockId].get(), oldBlockId);
 	auto blockPtrSwap = std::unique_ptr<NiObject>(newBlock);
 	(*blocks)[oldBlockId].swap(blockPtrSwap);
+	blockIndex.Insert(newBlock, oldBlockId);
 	return oldBlockId;
 }
 
@@ -219,11 +348,20 @@ void NiHeader::SwapBlocks(const int blockIndexLo, const int blockIndexHi) {
 	if (blockIndexLo == 0xFFFFFFFF || blockIndexHi == 0xFFFFFFFF)
 		return;
 
+	if (HasDeferredBlocks())
+		return;
+
+	blockIndex.Erase((*blocks)[blockIndexLo].get(), blockIndexLo);
+	blockIndex.Erase((*blocks)[blockIndexHi].get(), blockIndexHi);
+
 	// First swap data
 	iter_swap(blockTypeIndices.begin() + blockIndexLo, blockTypeIndices.begin() + blockIndexHi);
 	iter_swap(blockSizes.begin() + blockIndexLo, blockSizes.begin() + blockIndexHi);
 	iter_swap(blocks->begin() + blockIndexLo, blocks->begin() + blockIndexHi);
 
+	blockIndex.Insert((*blocks)[blockIndexLo].get(), blockIndexLo);
+	blockIndex.Insert((*blocks)[blockIndexHi].get(), blockIndexHi);
+
 	// Next tell all the blocks that the swap happened
 	for (auto &b : (*blocks))
 		BlockSwapped(b.get(), blockIndexLo, blockIndexHi);
@@ -233,6 +371,9 @@ bool NiHeader::IsBlockReferenced(const int blockId) {
 	if (blockId == 0xFFFFFFFF)
 		return false;
 
+	if (HasDeferredBlocks())
+		return true;
+
 	for (auto &block : (*blocks)) {
 		std::set<int*> references;
 		block->GetChildRefs(references);
@@ -246,35 +387,60 @@ bool NiHeader::IsBlockReferenced(const int blockId) {
 }
 
 void NiHeader::DeleteUnreferencedBlocks(bool* hadDeletions) {
-	for (int i = 1; i < numBlocks; i++) {
-		if (!IsBlockReferenced(i)) {
-			DeleteBlock(i);
+	if (numBlocks == 0 || HasDeferredBlocks())
+		return;
+
+	// Mark all blocks reachable from the root through child references
+	std::vector<bool> reachable(numBlocks, false);
+	std::vector<int> pending;
+	reachable[0] = true;
+	pending.push_back(0);
 
-			// Deleting a block can cause others to become unreferenced
-			if (hadDeletions)
-				(*hadDeletions) = true;
+	while (!pending.empty()) {
+		int blockId = pending.back();
+		pending.pop_back();
 
-			return DeleteUnreferencedBlocks();
+		std::set<int*> references;
+		(*blocks)[blockId]->GetChildRefs(references);
+
+		for (auto &ref : references) {
+			int refId = (*ref);
+			if (refId >= 0 && refId < (int)numBlocks && !reachable[refId]) {
+				reachable[refId] = true;
+				pending.push_back(refId);
+			}
 		}
 	}
+
+	// Sweep everything else at once
+	std::vector<int> unreferenced;
+	for (int i = 1; i < numBlocks; i++)
+		if (!reachable[i])
+			unreferenced.push_back(i);
+
+	if (unreferenced.empty())
+		return;
+
+	DeleteBlocks(unreferenced);
+
+	if (hadDeletions)
+		(*hadDeletions) = true;
 }
 
 ushort NiHeader::AddOrFindBlockTypeId(const std::string& blockTypeName) {
-	NiString niStr;
+	auto it = blockTypeIndex.find(blockTypeName);
+	if (it != blockTypeIndex.end())
+		return it->second;
+
+	// Block type not found, add it
 	ushort typeId = (ushort)blockTypes.size();
-	for (ushort i = 0; i < blockTypes.size(); i++) {
-		if (blockTypes[i].GetString() == blockTypeName) {
-			typeId = i;
-			break;
-		}
-	}
 
-	// Shader block type not found, add it
-	if (typeId == blockTypes.size()) {
-		niStr.SetString(blockTypeName);
-		blockTypes.push_back(niStr);
-		numBlockTypes++;
-	}
+	NiString niStr;
+	niStr.SetString(blockTypeName);
+	blockTypes.push_back(niStr);
+	numBlockTypes++;
+
+	blockTypeIndex.emplace(blockTypeName, typeId);
 	return typeId;
 }
 
@@ -287,9 +453,9 @@ ushort NiHeader::GetBlockTypeIndex(const int id) {
 }
 
 int NiHeader::FindStringId(const std::string& str) {
-	for (int i = 0; i < strings.size(); i++)
-		if (strings[i].GetString().compare(str) == 0)
-			return i;
+	auto it = stringIndex.find(str);
+	if (it != stringIndex.end())
+		return it->second;
 
 	return 0xFFFFFFFF;
 }
@@ -298,11 +464,9 @@ int NiHeader::AddOrFindStringId(const std::string& str) {
 	if (str.empty())
 		return 0xFFFFFFFF;
 
-	for (int i = 0; i < strings.size(); i++) {
-		if (strings[i].GetString().compare(str) == 0) {
-			return i;
-		}
-	}
+	auto it = stringIndex.find(str);
+	if (it != stringIndex.end())
+		return it->second;
 
 	int r = strings.size();
 
@@ -311,6 +475,7 @@ int NiHeader::AddOrFindStringId(const std::string& str) {
 	strings.push_back(niStr);
 	numStrings++;
 
+	stringIndex.emplace(str, r);
 	return r;
 }
 
@@ -322,16 +487,44 @@ std::string NiHeader::GetStringById(const int id) {
 }
 
 void NiHeader::SetStringById(const int id, const std::string& str) {
-	if (id >= 0 && id < numStrings)
+	if (id >= 0 && id < numStrings) {
+		auto it = stringIndex.find(strings[id].GetString());
+		if (it != stringIndex.end() && it->second == id)
+			stringIndex.erase(it);
+
 		strings[id].SetString(str);
+
+		// Keep the first entry for duplicate strings, like UpdateStringIndex
+		auto res = stringIndex.emplace(str, id);
+		if (!res.second && res.first->second > id)
+			res.first->second = id;
+	}
 }
 
 void NiHeader::ClearStrings() {
 	strings.clear();
+	stringIndex.clear();
 	numStrings = 0;
 	maxStringLen = 0;
 }
 
+void NiHeader::UpdateBlockTypeIndex() {
+	blockTypeIndex.clear();
+	blockTypeIndex.reserve(blockTypes.size());
+
+	// Keep the first entry for duplicate names, like the linear search did
+	for (ushort i = 0; i < blockTypes.size(); i++)
+		blockTypeIndex.emplace(blockTypes[i].GetString(), i);
+}
+
+void NiHeader::UpdateStringIndex() {
+	stringIndex.clear();
+	stringIndex.reserve(strings.size());
+
+	for (int i = 0; i < strings.size(); i++)
+		stringIndex.emplace(strings[i].GetString(), i);
+}
+
 void NiHeader::UpdateMaxStringLength() {
 	maxStringLen = 0;
 	for (auto &s : strings)
@@ -340,31 +533,40 @@ void NiHeader::UpdateMaxStringLength() {
 }
 
 void NiHeader::FillStringRefs() {
+	std::set<StringRef*> stringRefs;
 	for (auto &b : (*blocks)) {
-		std::set<StringRef*> stringRefs;
+		stringRefs.clear();
 		b->GetStringRefs(stringRefs);
 
-		for (auto &r : stringRefs) {
-			std::string str = GetStringById(r->GetIndex());
-			r->SetString(str);
-		}
+		for (auto &r : stringRefs)
+			r->SetString(GetStringById(r->GetIndex()));
 	}
+
+	// Names are only known now
+	blockIndex.Rebuild(*blocks);
 }
 
 void NiHeader::UpdateHeaderStrings(const bool hasUnknown) {
-	if (!hasUnknown)
-		ClearStrings();
-
+	// Gather the string refs of all blocks in block order first
+	std::vector<StringRef*> allRefs;
+	std::set<StringRef*> stringRefs;
 	for (auto &b : (*blocks)) {
-		std::set<StringRef*> stringRefs;
+		stringRefs.clear();
 		b->GetStringRefs(stringRefs);
+		allRefs.insert(allRefs.end(), stringRefs.begin(), stringRefs.end());
+	}
 
-		for (auto &r : stringRefs) {
-			int stringId = AddOrFindStringId(r->GetString());
-			r->SetIndex(stringId);
-		}
+	// Raw blocks still refer to the current string indices
+	if (!hasUnknown && numDeferredBlocks == 0) {
+		ClearStrings();
+		strings.reserve(allRefs.size());
+		stringIndex.reserve(allRefs.size());
 	}
 
+	// Then rewrite every ref in one pass, adding new strings as they come up
+	for (auto &r : allRefs)
+		r->SetIndex(AddOrFindStringId(r->GetString()));
+
 	UpdateMaxStringLength();
 }
 
@@ -382,6 +584,20 @@ void NiHeader::BlockDeleted(NiObject* o, int blockId) {
 	}
 }
 
+void NiHeader::BlocksDeleted(NiObject* o, const std::vector<int>& indexMap, int deleteCount) {
+	std::set<int*> refs;
+	o->GetChildRefs(refs);
+	o->GetPtrs(refs);
+
+	for (auto &r : refs) {
+		auto& index = (*r);
+		if (index >= 0 && index < (int)indexMap.size())
+			index = indexMap[index];
+		else if (index >= (int)indexMap.size())
+			index -= deleteCount;
+	}
+}
+
 void NiHeader::BlockSwapped(NiObject* o, int blockIndexLo, int blockIndexHi) {
 	std::set<int*> refs;
 	o->GetChildRefs(refs);
@@ -424,6 +640,8 @@ void NiHeader::Get(NiStream& stream) {
 	for (int i = 0; i < numBlockTypes; i++)
 		blockTypes[i].Get(stream, 4);
 
+	UpdateBlockTypeIndex();
+
 	blockTypeIndices.resize(numBlocks);
 	for (int i = 0; i < numBlocks; i++)
 		stream >> blockTypeIndices[i];
@@ -439,6 +657,8 @@ void NiHeader::Get(NiStream& stream) {
 	for (int i = 0; i < numStrings; i++)
 		strings[i].Get(stream, 4);
 
+	UpdateStringIndex();
+
 	stream >> unkInt2;
 	valid = true;
 }
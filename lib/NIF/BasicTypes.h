@@ -6,6 +6,7 @@ See the included LICENSE file
 
 #pragma once
 
+#include "BlockIndex.h"
 #include "utils/Object3d.h"
 
 #include <set>
@@ -13,6 +14,7 @@ See the included LICENSE file
 #include <string>
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
 
 #pragma warning (disable : 4100)
 
@@ -91,6 +93,35 @@ public:
 	NiVersion& GetVersion() { return *version; }
 };
 
+// Read-only stream buffer over memory that is owned elsewhere
+class NiMemoryBuf : public std::streambuf {
+public:
+	NiMemoryBuf(char* data, const size_t size) {
+		setg(data, data, data + size);
+	}
+
+protected:
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override {
+		char* pos = gptr();
+		if (dir == std::ios_base::beg)
+			pos = eback() + off;
+		else if (dir == std::ios_base::cur)
+			pos = gptr() + off;
+		else if (dir == std::ios_base::end)
+			pos = egptr() + off;
+
+		if (pos < eback() || pos > egptr())
+			return pos_type(off_type(-1));
+
+		setg(eback(), pos, egptr());
+		return pos_type(pos - eback());
+	}
+
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override {
+		return seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+};
+
 class StringRef {
 private:
 	// Temporary index storage for load/save
@@ -364,6 +395,19 @@ private:
 
 	uint unkInt2 = 0;
 
+	// Hash indexes kept alongside blockTypes and strings, mapping to the first matching entry
+	std::unordered_map<std::string, ushort> blockTypeIndex;
+	std::unordered_map<std::string, int> stringIndex;
+
+	void UpdateBlockTypeIndex();
+	void UpdateStringIndex();
+
+	// Name, ID and type lookups, updated by every operation on the block list
+	NiBlockIndex blockIndex;
+
+	// Number of blocks still kept as raw data (NiDeferredBlock)
+	uint numDeferredBlocks = 0;
+
 public:
 	NiHeader() {};
 
@@ -381,11 +425,12 @@ public:
 	std::string GetExportInfo();
 	void SetExportInfo(const std::string& exportInfo);
 
-	void SetBlockReference(std::vector<std::unique_ptr<NiObject>>* blockRef) {
-		blocks = blockRef;
-	};
+	void SetBlockReference(std::vector<std::unique_ptr<NiObject>>* blockRef);
 
 	uint GetNumBlocks() { return numBlocks; }
+	const NiBlockIndex& GetBlockIndex() { return blockIndex; }
+	// Keeps the index current after the NiAVObject with the ID was renamed
+	void BlockRenamed(const int blockId, const std::string& oldName, const std::string& newName);
 
 	template <class T>
 	T* GetBlock(const int blockId) {
@@ -395,13 +440,24 @@ public:
 		return nullptr;
 	}
 
+	// Puts the block parsed from the raw data of an NiDeferredBlock in its place, see NifFile::ParseDeferredBlocks
+	void ReplaceDeferredBlock(const int blockId, NiObject* block);
+	bool HasDeferredBlocks() { return numDeferredBlocks > 0; }
+
+	// Deleting, swapping and reference checks can't see into raw blocks, so they do nothing
+	// while HasDeferredBlocks is true. Use the NifFile methods, which call ParseDeferredBlocks first.
 	void DeleteBlock(int blockId);
+
+	// Deletes all given blocks with a single compaction and reference update pass.
+	// Block types are removed once none of the remaining blocks use them, like DeleteBlock does.
+	void DeleteBlocks(const std::vector<int>& blockIds);
 	void DeleteBlockByType(const std::string& blockTypeStr);
 	int AddBlock(NiObject* newBlock);
 	int ReplaceBlock(int oldBlockId, NiObject* newBlock);
 
 	// Swaps two blocks, updating references in other blocks that may refer to their old indices
 	void SwapBlocks(const int blockIndexLo, const int blockIndexHi);
+	// Always true while raw blocks could hold a reference to the block
 	bool IsBlockReferenced(const int blockId);
 	void DeleteUnreferencedBlocks(bool* hadDeletions = nullptr);
 
@@ -413,6 +469,10 @@ public:
 	std::streampos GetBlockSizeStreamPos() { return blockSizePos; }
 	void ResetBlockSizeStreamPos() { blockSizePos = std::streampos(); }
 
+	int GetBlockTypeCount() {
+		return blockTypes.size();
+	}
+
 	int GetStringCount() {
 		return strings.size();
 	}
@@ -428,6 +488,7 @@ public:
 	void UpdateHeaderStrings(const bool hasUnknown);
 
 	static void BlockDeleted(NiObject* o, int blockId);
+	static void BlocksDeleted(NiObject* o, const std::vector<int>& indexMap, int deleteCount);
 	static void BlockSwapped(NiObject* o, int blockIndexLo, int blockIndexHi);
 
 	void Get(NiStream& stream);
@@ -446,3 +507,12 @@ public:
 	void Put(NiStream& stream);
 	NiUnknown* Clone() { return new NiUnknown(*this); }
 };
+
+// Known block type kept as the raw data it was loaded from, until NifFile::ParseDeferredBlocks parses it.
+// Until then, the data is written back unchanged on save.
+class NiDeferredBlock : public NiUnknown {
+public:
+	NiDeferredBlock(NiStream& stream, const uint size) : NiUnknown(stream, size) {}
+
+	NiDeferredBlock* Clone() { return new NiDeferredBlock(*this); }
+};
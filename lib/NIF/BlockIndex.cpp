@@ -0,0 +1,140 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "BlockIndex.h"
+#include "Geometry.h"
+#include "Nodes.h"
+
+void NiBlockIndex::InsertID(std::vector<int>& ids, const int blockId) {
+	auto it = std::lower_bound(ids.begin(), ids.end(), blockId);
+	if (it == ids.end() || *it != blockId)
+		ids.insert(it, blockId);
+}
+
+void NiBlockIndex::EraseID(std::vector<int>& ids, const int blockId) {
+	auto it = std::lower_bound(ids.begin(), ids.end(), blockId);
+	if (it != ids.end() && *it == blockId)
+		ids.erase(it);
+}
+
+void NiBlockIndex::ShiftIDs(std::vector<int>& ids, const int blockId) {
+	for (auto it = std::upper_bound(ids.begin(), ids.end(), blockId); it != ids.end(); ++it)
+		(*it)--;
+}
+
+void NiBlockIndex::Clear() {
+	nameIndex.clear();
+	blockIDIndex.clear();
+	shapeIDs.clear();
+	nodeIDs.clear();
+}
+
+void NiBlockIndex::Rebuild(const std::vector<std::unique_ptr<NiObject>>& blocks) {
+	Clear();
+	blockIDIndex.reserve(blocks.size());
+
+	// Block order, so every list stays ascending without sorting
+	for (int i = 0; i < blocks.size(); i++) {
+		NiObject* block = blocks[i].get();
+		if (!block)
+			continue;
+
+		blockIDIndex.emplace(block, i);
+
+		auto avo = dynamic_cast<NiAVObject*>(block);
+		if (!avo)
+			continue;
+
+		nameIndex[avo->GetName()].push_back(i);
+
+		if (dynamic_cast<NiShape*>(avo))
+			shapeIDs.push_back(i);
+		else if (dynamic_cast<NiNode*>(avo))
+			nodeIDs.push_back(i);
+	}
+}
+
+void NiBlockIndex::Insert(NiObject* block, const int blockId) {
+	if (!block)
+		return;
+
+	blockIDIndex[block] = blockId;
+
+	auto avo = dynamic_cast<NiAVObject*>(block);
+	if (!avo)
+		return;
+
+	InsertID(nameIndex[avo->GetName()], blockId);
+
+	if (dynamic_cast<NiShape*>(avo))
+		InsertID(shapeIDs, blockId);
+	else if (dynamic_cast<NiNode*>(avo))
+		InsertID(nodeIDs, blockId);
+}
+
+void NiBlockIndex::Erase(NiObject* block, const int blockId) {
+	if (!block)
+		return;
+
+	blockIDIndex.erase(block);
+
+	auto avo = dynamic_cast<NiAVObject*>(block);
+	if (!avo)
+		return;
+
+	auto it = nameIndex.find(avo->GetName());
+	if (it != nameIndex.end()) {
+		EraseID(it->second, blockId);
+		if (it->second.empty())
+			nameIndex.erase(it);
+	}
+
+	EraseID(shapeIDs, blockId);
+	EraseID(nodeIDs, blockId);
+}
+
+void NiBlockIndex::EraseShifted(NiObject* block, const int blockId, const std::vector<std::unique_ptr<NiObject>>& blocks) {
+	Erase(block, blockId);
+
+	for (int i = blockId; i < blocks.size(); i++)
+		blockIDIndex[blocks[i].get()] = i;
+
+	for (auto &n : nameIndex)
+		ShiftIDs(n.second, blockId);
+
+	ShiftIDs(shapeIDs, blockId);
+	ShiftIDs(nodeIDs, blockId);
+}
+
+void NiBlockIndex::Rename(const int blockId, const std::string& oldName, const std::string& newName) {
+	if (oldName == newName)
+		return;
+
+	auto it = nameIndex.find(oldName);
+	if (it != nameIndex.end()) {
+		EraseID(it->second, blockId);
+		if (it->second.empty())
+			nameIndex.erase(it);
+	}
+
+	InsertID(nameIndex[newName], blockId);
+}
+
+const std::vector<int>* NiBlockIndex::FindName(const std::string& name) const {
+	auto it = nameIndex.find(name);
+	if (it == nameIndex.end())
+		return nullptr;
+
+	return &it->second;
+}
+
+int NiBlockIndex::GetBlockID(NiObject* block) const {
+	auto it = blockIDIndex.find(block);
+	if (it == blockIDIndex.end())
+		return 0xFFFFFFFF;
+
+	return it->second;
+}
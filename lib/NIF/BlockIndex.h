@@ -0,0 +1,53 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class NiObject;
+
+// Lookups over the block list of a header, kept current by the header's block operations.
+// Names are indexed for NiAVObjects only, renaming one has to go through NiHeader::BlockRenamed.
+class NiBlockIndex {
+private:
+	std::unordered_map<std::string, std::vector<int>> nameIndex;	// Object name to ascending NiAVObject block IDs
+	std::unordered_map<NiObject*, int> blockIDIndex;
+	std::vector<int> shapeIDs;
+	std::vector<int> nodeIDs;
+
+	static void InsertID(std::vector<int>& ids, const int blockId);
+	static void EraseID(std::vector<int>& ids, const int blockId);
+	static void ShiftIDs(std::vector<int>& ids, const int blockId);
+
+public:
+	void Clear();
+	void Rebuild(const std::vector<std::unique_ptr<NiObject>>& blocks);
+
+	void Insert(NiObject* block, const int blockId);
+	void Erase(NiObject* block, const int blockId);
+	// Erases a block that was removed from the list and moves the IDs after it down by one.
+	// Takes the list after the removal.
+	void EraseShifted(NiObject* block, const int blockId, const std::vector<std::unique_ptr<NiObject>>& blocks);
+	void Rename(const int blockId, const std::string& oldName, const std::string& newName);
+
+	// Ascending IDs of the NiAVObjects with the name, nullptr if there are none
+	const std::vector<int>* FindName(const std::string& name) const;
+
+	// 0xFFFFFFFF if the block isn't in the list
+	int GetBlockID(NiObject* block) const;
+
+	const std::vector<int>& GetShapeIDs() const {
+		return shapeIDs;
+	}
+
+	const std::vector<int>& GetNodeIDs() const {
+		return nodeIDs;
+	}
+};
@@ -8,7 +8,7 @@ See the included LICENSE file
 #include "Skin.h"
 #include "Nodes.h"
 
-#include "utils/KDMatcher.h"
+#include "utils/TangentSpace.h"
 
 NiAdditionalGeometryData::NiAdditionalGeometryData() : AdditionalGeomData() {
 }
@@ -977,44 +977,18 @@ void BSTriShape::RecalcNormals(const bool smooth, const float smoothThresh) {
 	SetNormals(true);
 
 	std::vector<Vector3> verts(numVertices);
-	std::vector<Vector3> norms(numVertices);
+	std::vector<Vector3> norms;
 	for (int i = 0; i < numVertices; i++) {
 		verts[i].x = rawVertices[i].x * -0.1f;
 		verts[i].z = rawVertices[i].y * 0.1f;
 		verts[i].y = rawVertices[i].z * 0.1f;
 	}
 
-	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < numTriangles; t++) {
-		triangles[t].trinormal(verts, &tn);
-		norms[triangles[t].p1] += tn;
-		norms[triangles[t].p2] += tn;
-		norms[triangles[t].p3] += tn;
-	}
-
-	for (auto &n : norms)
-		n.Normalize();
-
-	// Smooth normals
-	if (smooth) {
-		kd_matcher matcher(verts.data(), numVertices);
-		for (int i = 0; i < matcher.matches.size(); i++) {
-			std::pair<Vector3*, int>& a = matcher.matches[i].first;
-			std::pair<Vector3*, int>& b = matcher.matches[i].second;
-
-			Vector3& an = norms[a.second];
-			Vector3& bn = norms[b.second];
-			if (an.angle(bn) < smoothThresh * DEG2RAD) {
-				Vector3 anT = an;
-				an += bn;
-				bn += anT;
-			}
-		}
+	TangentSpace tangentSpace(numVertices, triangles, numTriangles);
+	tangentSpace.CalcNormals(verts, norms);
 
-		for (auto &n : norms)
-			n.Normalize();
-	}
+	if (smooth)
+		TangentSpace::SmoothNormals(verts, norms, smoothThresh);
 
 	rawNormals.resize(numVertices);
 	for (int i = 0; i < numVertices; i++) {
@@ -1031,83 +1005,15 @@ void BSTriShape::CalcTangentSpace() {
 	if (!HasNormals() || !HasUVs())
 		return;
 
+	GetRawVerts();
+	GetUVData();
 	GetNormalData(false);
 	SetTangents(true);
 
-	std::vector<Vector3> tan1;
-	std::vector<Vector3> tan2;
-	tan1.resize(numVertices);
-	tan2.resize(numVertices);
-
-	for (int i = 0; i < triangles.size(); i++) {
-		int i1 = triangles[i].p1;
-		int i2 = triangles[i].p2;
-		int i3 = triangles[i].p3;
-
-		Vector3 v1 = vertData[i1].vert;
-		Vector3 v2 = vertData[i2].vert;
-		Vector3 v3 = vertData[i3].vert;
-
-		Vector2 w1 = vertData[i1].uv;
-		Vector2 w2 = vertData[i2].uv;
-		Vector2 w3 = vertData[i3].uv;
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.u - w1.u;
-		float s2 = w3.u - w1.u;
-		float t1 = w2.v - w1.v;
-		float t2 = w3.v - w1.v;
-
-		float r = (s1 * t2 - s2 * t1);
-		r = (r >= 0.0f ? +1.0f : -1.0f);
-
-		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		sdir.Normalize();
-		tdir.Normalize();
-
-		tan1[i1] += tdir;
-		tan1[i2] += tdir;
-		tan1[i3] += tdir;
-
-		tan2[i1] += sdir;
-		tan2[i2] += sdir;
-		tan2[i3] += sdir;
-	}
-
-	rawBitangents.resize(numVertices);
-	rawTangents.resize(numVertices);
+	TangentSpace tangentSpace(numVertices, triangles, triangles.size());
+	tangentSpace.CalcTangents(rawVertices, rawUvs, rawNormals, rawTangents, rawBitangents);
 
 	for (int i = 0; i < numVertices; i++) {
-		rawTangents[i] = tan1[i];
-		rawBitangents[i] = tan2[i];
-
-		if (rawTangents[i].IsZero() || rawBitangents[i].IsZero()) {
-			rawTangents[i].x = rawNormals[i].y;
-			rawTangents[i].y = rawNormals[i].z;
-			rawTangents[i].z = rawNormals[i].x;
-			rawBitangents[i] = rawNormals[i].cross(rawTangents[i]);
-		}
-		else {
-			rawTangents[i].Normalize();
-			rawTangents[i] = (rawTangents[i] - rawNormals[i] * rawNormals[i].dot(rawTangents[i]));
-			rawTangents[i].Normalize();
-
-			rawBitangents[i].Normalize();
-
-			rawBitangents[i] = (rawBitangents[i] - rawNormals[i] * rawNormals[i].dot(rawBitangents[i]));
-			rawBitangents[i] = (rawBitangents[i] - rawTangents[i] * rawTangents[i].dot(rawBitangents[i]));
-
-			rawBitangents[i].Normalize();
-		}
-
 		vertData[i].tangent[0] = (unsigned char)round((((rawTangents[i].x + 1.0f) / 2.0f) * 255.0f));
 		vertData[i].tangent[1] = (unsigned char)round((((rawTangents[i].y + 1.0f) / 2.0f) * 255.0f));
 		vertData[i].tangent[2] = (unsigned char)round((((rawTangents[i].z + 1.0f) / 2.0f) * 255.0f));
@@ -1730,41 +1636,11 @@ void NiTriShapeData::RecalcNormals(const bool smooth, const float smoothThresh)
 
 	NiTriBasedGeomData::RecalcNormals();
 
-	// Zero out existing normals
-	for (auto &n : normals)
-		n.Zero();
-
-	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < numTriangles; t++) {
-		triangles[t].trinormal(vertices, &tn);
-		normals[triangles[t].p1] += tn;
-		normals[triangles[t].p2] += tn;
-		normals[triangles[t].p3] += tn;
-	}
-
-	for (auto &n : normals)
-		n.Normalize();
-
-	// Smooth normals
-	if (smooth) {
-		kd_matcher matcher(vertices.data(), numVertices);
-		for (int i = 0; i < matcher.matches.size(); i++) {
-			std::pair<Vector3*, int>& a = matcher.matches[i].first;
-			std::pair<Vector3*, int>& b = matcher.matches[i].second;
-
-			Vector3& an = normals[a.second];
-			Vector3& bn = normals[b.second];
-			if (an.angle(bn) < smoothThresh * DEG2RAD) {
-				Vector3 anT = an;
-				an += bn;
-				bn += anT;
-			}
-		}
+	TangentSpace tangentSpace(numVertices, triangles, numTriangles);
+	tangentSpace.CalcNormals(vertices, normals);
 
-		for (auto &n : normals)
-			n.Normalize();
-	}
+	if (smooth)
+		TangentSpace::SmoothNormals(vertices, normals, smoothThresh);
 }
 
 void NiTriShapeData::CalcTangentSpace() {
@@ -1773,77 +1649,8 @@ void NiTriShapeData::CalcTangentSpace() {
 
 	NiTriBasedGeomData::CalcTangentSpace();
 
-	std::vector<Vector3> tan1;
-	std::vector<Vector3> tan2;
-	tan1.resize(numVertices);
-	tan2.resize(numVertices);
-
-	for (int i = 0; i < numTriangles; i++) {
-		int i1 = triangles[i].p1;
-		int i2 = triangles[i].p2;
-		int i3 = triangles[i].p3;
-
-		Vector3 v1 = vertices[i1];
-		Vector3 v2 = vertices[i2];
-		Vector3 v3 = vertices[i3];
-
-		Vector2 w1 = uvSets[i1];
-		Vector2 w2 = uvSets[i2];
-		Vector2 w3 = uvSets[i3];
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.u - w1.u;
-		float s2 = w3.u - w1.u;
-		float t1 = w2.v - w1.v;
-		float t2 = w3.v - w1.v;
-
-		float r = (s1 * t2 - s2 * t1);
-		r = (r >= 0.0f ? +1.0f : -1.0f);
-
-		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		sdir.Normalize();
-		tdir.Normalize();
-
-		tan1[i1] += sdir;
-		tan1[i2] += sdir;
-		tan1[i3] += sdir;
-
-		tan2[i1] += tdir;
-		tan2[i2] += tdir;
-		tan2[i3] += tdir;
-	}
-
-	for (int i = 0; i < numVertices; i++) {
-		bitangents[i] = tan1[i];
-		tangents[i] = tan2[i];
-
-		if (tangents[i].IsZero() || bitangents[i].IsZero()) {
-			tangents[i].x = normals[i].y;
-			tangents[i].y = normals[i].z;
-			tangents[i].z = normals[i].x;
-			bitangents[i] = normals[i].cross(tangents[i]);
-		}
-		else {
-			tangents[i].Normalize();
-			tangents[i] = (tangents[i] - normals[i] * normals[i].dot(tangents[i]));
-			tangents[i].Normalize();
-
-			bitangents[i].Normalize();
-
-			bitangents[i] = (bitangents[i] - normals[i] * normals[i].dot(bitangents[i]));
-			bitangents[i] = (bitangents[i] - tangents[i] * tangents[i].dot(bitangents[i]));
-
-			bitangents[i].Normalize();
-		}
-	}
+	TangentSpace tangentSpace(numVertices, triangles, numTriangles);
+	tangentSpace.CalcTangents(vertices, uvSets, normals, tangents, bitangents);
 }
 
 
@@ -1948,41 +1755,11 @@ void NiTriStripsData::RecalcNormals(const bool smooth, const float smoothThresh)
 	std::vector<Triangle> tris;
 	StripsToTris(&tris);
 
-	// Zero out existing normals
-	for (auto &n : normals)
-		n.Zero();
-
-	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < tris.size(); t++) {
-		tris[t].trinormal(vertices, &tn);
-		normals[tris[t].p1] += tn;
-		normals[tris[t].p2] += tn;
-		normals[tris[t].p3] += tn;
-	}
-
-	for (auto &n : normals)
-		n.Normalize();
-
-	// Smooth normals
-	if (smooth) {
-		kd_matcher matcher(vertices.data(), numVertices);
-		for (int i = 0; i < matcher.matches.size(); i++) {
-			std::pair<Vector3*, int>& a = matcher.matches[i].first;
-			std::pair<Vector3*, int>& b = matcher.matches[i].second;
-
-			Vector3& an = normals[a.second];
-			Vector3& bn = normals[b.second];
-			if (an.angle(bn) < smoothThresh * DEG2RAD) {
-				Vector3 anT = an;
-				an += bn;
-				bn += anT;
-			}
-		}
+	TangentSpace tangentSpace(numVertices, tris, tris.size());
+	tangentSpace.CalcNormals(vertices, normals);
 
-		for (auto &n : normals)
-			n.Normalize();
-	}
+	if (smooth)
+		TangentSpace::SmoothNormals(vertices, normals, smoothThresh);
 }
 
 void NiTriStripsData::CalcTangentSpace() {
@@ -1991,80 +1768,11 @@ void NiTriStripsData::CalcTangentSpace() {
 
 	NiTriBasedGeomData::CalcTangentSpace();
 
-	std::vector<Vector3> tan1;
-	std::vector<Vector3> tan2;
-	tan1.resize(numVertices);
-	tan2.resize(numVertices);
-
 	std::vector<Triangle> tris;
 	StripsToTris(&tris);
 
-	for (int i = 0; i < tris.size(); i++) {
-		int i1 = tris[i].p1;
-		int i2 = tris[i].p2;
-		int i3 = tris[i].p3;
-
-		Vector3 v1 = vertices[i1];
-		Vector3 v2 = vertices[i2];
-		Vector3 v3 = vertices[i3];
-
-		Vector2 w1 = uvSets[i1];
-		Vector2 w2 = uvSets[i2];
-		Vector2 w3 = uvSets[i3];
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.u - w1.u;
-		float s2 = w3.u - w1.u;
-		float t1 = w2.v - w1.v;
-		float t2 = w3.v - w1.v;
-
-		float r = (s1 * t2 - s2 * t1);
-		r = (r >= 0.0f ? +1.0f : -1.0f);
-
-		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		sdir.Normalize();
-		tdir.Normalize();
-
-		tan1[i1] += sdir;
-		tan1[i2] += sdir;
-		tan1[i3] += sdir;
-
-		tan2[i1] += tdir;
-		tan2[i2] += tdir;
-		tan2[i3] += tdir;
-	}
-
-	for (int i = 0; i < numVertices; i++) {
-		bitangents[i] = tan1[i];
-		tangents[i] = tan2[i];
-
-		if (tangents[i].IsZero() || bitangents[i].IsZero()) {
-			tangents[i].x = normals[i].y;
-			tangents[i].y = normals[i].z;
-			tangents[i].z = normals[i].x;
-			bitangents[i] = normals[i].cross(tangents[i]);
-		}
-		else {
-			tangents[i].Normalize();
-			tangents[i] = (tangents[i] - normals[i] * normals[i].dot(tangents[i]));
-			tangents[i].Normalize();
-
-			bitangents[i].Normalize();
-
-			bitangents[i] = (bitangents[i] - normals[i] * normals[i].dot(bitangents[i]));
-			bitangents[i] = (bitangents[i] - tangents[i] * tangents[i].dot(bitangents[i]));
-
-			bitangents[i].Normalize();
-		}
-	}
+	TangentSpace tangentSpace(numVertices, tris, tris.size());
+	tangentSpace.CalcTangents(vertices, uvSets, normals, tangents, bitangents);
 }
 
 
@@ -11,6 +11,12 @@ See the included LICENSE file
 #include <regex>
 #include <fstream>
 
+#ifdef WIN64
+	#include <ppl.h>
+#else
+	#undef _PPL_H
+#endif
+
 
 NiFactoryRegister& NiFactoryRegister::GetNiFactoryRegister() {
 	static NiFactoryRegister instance;
@@ -312,11 +318,24 @@ NiFactoryRegister::NiFactoryRegister() {
 }
 
 
+void NifFile::SetObjectName(NiAVObject* obj, const std::string& newName) {
+	int blockID = GetBlockID(obj);
+	std::string oldName = obj->GetName();
+	obj->SetName(newName);
+
+	if (blockID != 0xFFFFFFFF)
+		hdr.BlockRenamed(blockID, oldName, newName);
+}
+
 NiShape* NifFile::FindShapeByName(const std::string& name, int dupIndex) {
+	auto ids = hdr.GetBlockIndex().FindName(name);
+	if (!ids)
+		return nullptr;
+
 	int numFound = 0;
-	for (auto& block : blocks) {
-		auto geom = dynamic_cast<NiShape*>(block.get());
-		if (geom && !name.compare(geom->GetName())) {
+	for (auto &id : *ids) {
+		auto geom = dynamic_cast<NiShape*>(blocks[id].get());
+		if (geom) {
 			if (numFound >= dupIndex)
 				return geom;
 
@@ -327,40 +346,29 @@ NiShape* NifFile::FindShapeByName(const std::string& name, int dupIndex) {
 }
 
 NiAVObject* NifFile::FindAVObjectByName(const std::string& name, int dupIndex) {
-	int numFound = 0;
-	for (auto& block : blocks) {
-		auto avo = dynamic_cast<NiAVObject*>(block.get());
-		if (avo && !name.compare(avo->GetName())) {
-			if (numFound >= dupIndex)
-				return avo;
+	auto ids = hdr.GetBlockIndex().FindName(name);
+	if (!ids || dupIndex >= ids->size())
+		return nullptr;
 
-			numFound++;
-		}
-	}
-	return nullptr;
+	return dynamic_cast<NiAVObject*>(blocks[(*ids)[dupIndex]].get());
 }
 
 NiNode* NifFile::FindNodeByName(const std::string& name) {
-	for (auto& block : blocks) {
-		auto node = dynamic_cast<NiNode*>(block.get());
-		if (node && !name.compare(node->GetName()))
+	auto ids = hdr.GetBlockIndex().FindName(name);
+	if (!ids)
+		return nullptr;
+
+	for (auto &id : *ids) {
+		auto node = dynamic_cast<NiNode*>(blocks[id].get());
+		if (node)
 			return node;
 	}
 	return nullptr;
 }
 
 int NifFile::GetBlockID(NiObject* block) {
-	if (block != nullptr) {
-		auto it = std::find_if(blocks.begin(), blocks.end(), [&block] (const auto& ptr) {
-			if (ptr.get() == block)
-				return true;
-			else
-				return false;
-		});
-
-		if (it != blocks.end())
-			return std::distance(blocks.begin(), it);
-	}
+	if (block != nullptr)
+		return hdr.GetBlockIndex().GetBlockID(block);
 
 	return 0xFFFFFFFF;
 }
@@ -368,14 +376,12 @@ int NifFile::GetBlockID(NiObject* block) {
 NiNode* NifFile::GetParentNode(NiObject* childBlock) {
 	if (childBlock != nullptr) {
 		int childId = GetBlockID(childBlock);
-		for (auto &block : blocks) {
-			auto node = dynamic_cast<NiNode*>(block.get());
-			if (node) {
-				auto children = node->GetChildren();
-				for (auto it = children.begin(); it < children.end(); ++it) {
-					if (childId == it->index)
-						return node;
-				}
+		for (auto &id : hdr.GetBlockIndex().GetNodeIDs()) {
+			auto node = static_cast<NiNode*>(blocks[id].get());
+			auto& children = node->GetChildren();
+			for (auto it = children.begin(); it < children.end(); ++it) {
+				if (childId == it->index)
+					return node;
 			}
 		}
 	}
@@ -399,8 +405,58 @@ void NifFile::CopyFrom(const NifFile& other) {
 	for (int i = 0; i < nBlocks; i++)
 		blocks[i] = std::move(std::unique_ptr<NiObject>(other.blocks[i]->Clone()));
 
-	LinkGeomData();
+	// Reference the new blocks before linking, otherwise geometry would link to the other file's data
 	hdr.SetBlockReference(&blocks);
+	LinkGeomData();
+}
+
+bool NifFile::RestoreShapeFrom(NifFile& base, const std::string& shapeName) {
+	NiShape* shape = FindShapeByName(shapeName);
+	NiShape* baseShape = base.FindShapeByName(shapeName);
+	if (!shape || !baseShape)
+		return false;
+
+	int shapeId = GetBlockID(shape);
+	if (shapeId != base.GetBlockID(baseShape) || hdr.GetNumBlocks() != base.hdr.GetNumBlocks())
+		return false;
+
+	// Blocks that vertex edits and deletions write to
+	std::vector<int> ids;
+	ids.push_back(shapeId);
+	ids.push_back(baseShape->GetDataRef());
+
+	int skinRef = baseShape->GetSkinInstanceRef();
+	auto baseSkinInst = base.hdr.GetBlock<NiSkinInstance>(skinRef);
+	if (baseSkinInst) {
+		ids.push_back(skinRef);
+		ids.push_back(baseSkinInst->GetDataRef());
+		ids.push_back(baseSkinInst->GetSkinPartitionRef());
+	}
+
+	for (auto &id : ids) {
+		auto block = hdr.GetBlock<NiObject>(id);
+		auto baseBlock = base.hdr.GetBlock<NiObject>(id);
+		if (!block && !baseBlock)
+			continue;
+
+		if (!block || !baseBlock || std::string(block->GetBlockName()) != baseBlock->GetBlockName())
+			return false;
+	}
+
+	for (auto &id : ids) {
+		auto baseBlock = base.hdr.GetBlock<NiObject>(id);
+		if (baseBlock)
+			hdr.ReplaceBlock(id, baseBlock->Clone());
+	}
+
+	auto geom = hdr.GetBlock<NiGeometry>(shapeId);
+	if (geom) {
+		auto geomData = hdr.GetBlock<NiGeometryData>(geom->GetDataRef());
+		if (geomData)
+			geom->SetGeomData(geomData);
+	}
+
+	return true;
 }
 
 void NifFile::LinkGeomData() {
@@ -422,58 +478,154 @@ void NifFile::Clear() {
 	hdr.Clear();
 }
 
-int NifFile::Load(const std::string& filename) {
-	Clear();
+bool NifFile::IsDeferrableBlockType(const std::string& blockTypeStr) {
+	static const std::string prefixes[] = { "bhk", "NiPSys", "BSCloth" };
+	for (auto &prefix : prefixes)
+		if (blockTypeStr.compare(0, prefix.length(), prefix) == 0)
+			return true;
+
+	if (blockTypeStr.find("Controller") != std::string::npos || blockTypeStr.find("Interpolator") != std::string::npos)
+		return true;
+
+	static const std::string animData[] = { "NiTransformData", "NiKeyframeData", "NiFloatData", "NiBoolData", "NiPosData", "NiColorData", "NiTextKeyExtraData" };
+	for (auto &type : animData)
+		if (blockTypeStr == type)
+			return true;
+
+	return false;
+}
 
+void NifFile::ParseDeferredBlocks() {
+	if (!hdr.HasDeferredBlocks())
+		return;
+
+	auto& nifactories = NiFactoryRegister::GetNiFactoryRegister();
+	for (int i = 0; i < hdr.GetNumBlocks() && hdr.HasDeferredBlocks(); i++) {
+		auto deferred = dynamic_cast<NiDeferredBlock*>(blocks[i].get());
+		if (!deferred)
+			continue;
+
+		auto nifactory = nifactories.GetFactoryByName(hdr.GetBlockTypeStringById(i));
+		if (!nifactory)
+			continue;
+
+		NiMemoryBuf dataBuf(deferred->data.data(), deferred->data.size());
+		std::iostream data(&dataBuf);
+		NiStream stream(&data, &hdr.GetVersion());
+
+		NiObject* block = nifactory->Load(stream);
+		if (!block)
+			continue;
+
+		// Resolve strings the same way as on load
+		std::set<StringRef*> stringRefs;
+		block->GetStringRefs(stringRefs);
+
+		for (auto &r : stringRefs)
+			r->SetString(hdr.GetStringById(r->GetIndex()));
+
+		hdr.ReplaceDeferredBlock(i, block);
+	}
+}
+
+int NifFile::Load(const std::string& filename, const bool partial) {
 	std::fstream file(filename.c_str(), std::ios::in | std::ios::binary);
-	if (file.is_open()) {
-		NiStream stream(&file, &hdr.GetVersion());
-		if (filename.rfind('\\') != std::string::npos)
-			fileName = filename.substr(filename.rfind('\\'));
-		else
-			fileName = filename;
+	if (!file.is_open()) {
+		Clear();
+		return 1;
+	}
 
-		hdr.Get(stream);
-		if (!hdr.IsValid()) {
-			Clear();
-			return 1;
-		}
+	return Load(file, filename, partial);
+}
 
-		NiVersion& version = stream.GetVersion();
-		if (!(version.File() >= NiVersion::Get(20, 2, 0, 7) && (version.User() == 11 || version.User() == 12))) {
-			Clear();
-			return 2;
-		}
+int NifFile::Load(std::iostream& file, const std::string& filename, const bool partial) {
+	Clear();
 
-		uint nBlocks = hdr.GetNumBlocks();
-		blocks.resize(nBlocks);
+	NiStream stream(&file, &hdr.GetVersion());
+	if (filename.rfind('\\') != std::string::npos)
+		fileName = filename.substr(filename.rfind('\\'));
+	else
+		fileName = filename;
 
-		auto& nifactories = NiFactoryRegister::GetNiFactoryRegister();
-		for (int i = 0; i < nBlocks; i++) {
-			NiObject* block = nullptr;
-			std::string blockTypeStr = hdr.GetBlockTypeStringById(i);
+	hdr.Get(stream);
+	if (!hdr.IsValid()) {
+		Clear();
+		return 1;
+	}
 
-			auto nifactory = nifactories.GetFactoryByName(blockTypeStr);
-			if (nifactory) {
-				block = nifactory->Load(stream);
-			}
-			else {
-				hasUnknown = true;
-				block = new NiUnknown(stream, hdr.GetBlockSize(i));
-			}
+	NiVersion& version = stream.GetVersion();
+	if (!(version.File() >= NiVersion::Get(20, 2, 0, 7) && (version.User() == 11 || version.User() == 12))) {
+		Clear();
+		return 2;
+	}
 
-			if (block)
-				blocks[i] = std::move(std::unique_ptr<NiObject>(block));
-		}
+	uint nBlocks = hdr.GetNumBlocks();
+	blocks.resize(nBlocks);
 
-		hdr.SetBlockReference(&blocks);
-		file.close();
+	// Read all block data at once. The block sizes in the header give the range of each block.
+	std::streampos dataStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	size_t dataSize = file.tellg() - dataStart;
+	file.seekg(dataStart);
+
+	std::vector<char> data(dataSize);
+	if (dataSize > 0)
+		file.read(&data[0], dataSize);
+
+	std::vector<size_t> offsets(nBlocks);
+	size_t dataEnd = 0;
+	for (int i = 0; i < nBlocks; i++) {
+		offsets[i] = dataEnd;
+		dataEnd += hdr.GetBlockSize(i);
 	}
-	else {
+
+	if (dataEnd > dataSize) {
 		Clear();
 		return 1;
 	}
 
+	// Look up factories up front, the blocks themselves are independent of each other
+	auto& nifactories = NiFactoryRegister::GetNiFactoryRegister();
+	std::vector<std::shared_ptr<IFactory>> factories(nBlocks);
+	std::vector<bool> deferred(nBlocks, false);
+	for (int i = 0; i < nBlocks; i++) {
+		std::string blockTypeStr = hdr.GetBlockTypeStringById(i);
+
+		factories[i] = nifactories.GetFactoryByName(blockTypeStr);
+		if (!factories[i])
+			hasUnknown = true;
+		else if (partial)
+			deferred[i] = IsDeferrableBlockType(blockTypeStr);
+	}
+
+	NiVersion& blockVersion = hdr.GetVersion();
+	auto loadBlock = [&](int i) {
+		uint blockSize = hdr.GetBlockSize(i);
+		NiMemoryBuf blockBuf(data.data() + offsets[i], blockSize);
+		std::iostream blockData(&blockBuf);
+		NiStream blockStream(&blockData, &blockVersion);
+
+		NiObject* block = nullptr;
+		if (!factories[i])
+			block = new NiUnknown(blockStream, blockSize);
+		else if (deferred[i])
+			block = new NiDeferredBlock(blockStream, blockSize);
+		else
+			block = factories[i]->Load(blockStream);
+
+		if (block)
+			blocks[i] = std::move(std::unique_ptr<NiObject>(block));
+	};
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, (int)nBlocks, loadBlock);
+#else
+	for (int i = 0; i < nBlocks; i++)
+		loadBlock(i);
+#endif
+
+	hdr.SetBlockReference(&blocks);
+
 	PrepareData();
 	isValid = true;
 	return 0;
@@ -483,6 +635,8 @@ void NifFile::SetShapeOrder(const std::vector<std::string>& order) {
 	if (hasUnknown)
 		return;
 
+	ParseDeferredBlocks();
+
 	std::vector<int> delta;
 	bool hadoffset = false;
 
@@ -568,6 +722,8 @@ bool NifFile::DeleteUnreferencedBlocks() {
 	if (hasUnknown)
 		return false;
 
+	ParseDeferredBlocks();
+
 	bool hadDeletions = false;
 	hdr.DeleteUnreferencedBlocks(&hadDeletions);
 	return hadDeletions;
@@ -593,7 +749,18 @@ int NifFile::AddNode(const std::string& nodeName, std::vector<Vector3>& rot, Vec
 	return newNodeId;
 }
 
+void NifFile::DeleteBlock(const int blockId) {
+	ParseDeferredBlocks();
+	hdr.DeleteBlock(blockId);
+}
+
+void NifFile::DeleteBlockByType(const std::string& blockTypeStr) {
+	ParseDeferredBlocks();
+	hdr.DeleteBlockByType(blockTypeStr);
+}
+
 void NifFile::DeleteNode(const std::string& nodeName) {
+	ParseDeferredBlocks();
 	hdr.DeleteBlock(GetBlockID(FindNodeByName(nodeName)));
 }
 
@@ -615,7 +782,7 @@ void NifFile::SetNodeName(const int blockID, const std::string& newName) {
 	if (!node)
 		return;
 
-	node->SetName(newName);
+	SetObjectName(node, newName);
 }
 
 int NifFile::AssignExtraData(const std::string& blockName, const int extraDataId, bool isNode) {
@@ -1292,6 +1459,8 @@ OptResultSSE NifFile::OptimizeForSSE(const OptOptionsSSE& options) {
 		return result;
 	}
 
+	ParseDeferredBlocks();
+
 	bool isBTO = fileName.rfind(".bto") != std::string::npos;
 	bool isBTR = fileName.rfind(".btr") != std::string::npos;
 
@@ -1663,19 +1832,20 @@ void NifFile::FinalizeData() {
 }
 
 int NifFile::GetShapeList(std::vector<std::string>& outList) {
+	auto& shapeIDs = hdr.GetBlockIndex().GetShapeIDs();
+
 	outList.clear();
-	for (auto& block : blocks) {
-		auto shape = dynamic_cast<NiShape*>(block.get());
-		if (shape)
-			outList.push_back(shape->GetName());
-	}
+	outList.reserve(shapeIDs.size());
+	for (auto &id : shapeIDs)
+		outList.push_back(static_cast<NiShape*>(blocks[id].get())->GetName());
+
 	return outList.size();
 }
 
 void NifFile::RenameShape(const std::string& oldName, const std::string& newName) {
 	NiAVObject* geom = FindAVObjectByName(oldName);
 	if (geom)
-		geom->SetName(newName);
+		SetObjectName(geom, newName);
 }
 
 bool NifFile::RenameDuplicateShapes() {
@@ -1720,7 +1890,7 @@ bool NifFile::RenameDuplicateShapes() {
 						dup = "_" + std::to_string(dupCount);
 					}
 
-					shape->SetName(shape->GetName() + dup);
+					SetObjectName(shape, shape->GetName() + dup);
 					dupCount++;
 					renamed = true;
 				}
@@ -1739,19 +1909,17 @@ int NifFile::GetRootNodeID() {
 }
 
 bool NifFile::GetNodeTransform(const std::string& nodeName, std::vector<Vector3>& outRot, Vector3& outTrans, float& outScale) {
-	for (auto& block : blocks) {
-		auto node = dynamic_cast<NiNode*>(block.get());
-		if (node && !node->GetName().compare(nodeName)) {
-			outRot.clear();
-			outRot.push_back(node->rotation[0]);
-			outRot.push_back(node->rotation[1]);
-			outRot.push_back(node->rotation[2]);
-			outTrans = node->translation;
-			outScale = node->scale;
-			return true;
-		}
-	}
-	return false;
+	auto node = FindNodeByName(nodeName);
+	if (!node)
+		return false;
+
+	outRot.clear();
+	outRot.push_back(node->rotation[0]);
+	outRot.push_back(node->rotation[1]);
+	outRot.push_back(node->rotation[2]);
+	outTrans = node->translation;
+	outScale = node->scale;
+	return true;
 }
 
 bool NifFile::SetNodeTransform(const std::string& nodeName, SkinTransform& inXform, const bool rootChildrenOnly) {
@@ -1774,16 +1942,14 @@ bool NifFile::SetNodeTransform(const std::string& nodeName, SkinTransform& inXfo
 		}
 	}
 	else {
-		for (auto& block : blocks) {
-			auto node = dynamic_cast<NiNode*>(block.get());
-			if (node && !node->GetName().compare(nodeName)) {
-				node->rotation[0] = inXform.rotation[0];
-				node->rotation[1] = inXform.rotation[1];
-				node->rotation[2] = inXform.rotation[2];
-				node->translation = inXform.translation;
-				node->scale = inXform.scale;
-				return true;
-			}
+		auto node = FindNodeByName(nodeName);
+		if (node) {
+			node->rotation[0] = inXform.rotation[0];
+			node->rotation[1] = inXform.rotation[1];
+			node->rotation[2] = inXform.rotation[2];
+			node->translation = inXform.translation;
+			node->scale = inXform.scale;
+			return true;
 		}
 	}
 
@@ -3047,18 +3213,51 @@ void NifFile::DeleteShape(const std::string& shapeName) {
 	if (!shape)
 		return;
 
-	hdr.DeleteBlock(shape->GetDataRef());
-	DeleteShader(shapeName);
-	DeleteSkinning(shapeName);
+	ParseDeferredBlocks();
 
-	for (int i = shape->propertyRefs.GetSize() - 1; i >= 0; --i)
-		hdr.DeleteBlock(shape->propertyRefs.GetBlockRef(i));
+	// Gather the shape and everything owned by it, then delete them in one pass
+	std::vector<int> deleteIDs;
+	deleteIDs.push_back(shape->GetDataRef());
+
+	auto shader = hdr.GetBlock<NiShader>(shape->GetShaderPropertyRef());
+	if (shader) {
+		deleteIDs.push_back(shader->GetTextureSetRef());
+		deleteIDs.push_back(shader->GetControllerRef());
+		deleteIDs.push_back(shape->GetShaderPropertyRef());
+	}
 
-	for (int i = shape->GetNumExtraData() - 1; i >= 0; --i)
-		hdr.DeleteBlock(shape->GetExtraDataRef(i));
+	deleteIDs.push_back(shape->GetAlphaPropertyRef());
 
-	int shapeID = GetBlockID(shape);
-	hdr.DeleteBlock(shapeID);
+	auto skinInst = hdr.GetBlock<NiSkinInstance>(shape->GetSkinInstanceRef());
+	if (skinInst) {
+		deleteIDs.push_back(skinInst->GetDataRef());
+		deleteIDs.push_back(skinInst->GetSkinPartitionRef());
+	}
+
+	auto bsSkinInst = hdr.GetBlock<BSSkinInstance>(shape->GetSkinInstanceRef());
+	if (bsSkinInst)
+		deleteIDs.push_back(bsSkinInst->GetDataRef());
+
+	deleteIDs.push_back(shape->GetSkinInstanceRef());
+
+	for (int i = 0; i < shape->propertyRefs.GetSize(); i++) {
+		int propRef = shape->propertyRefs.GetBlockRef(i);
+		auto propShader = hdr.GetBlock<NiShader>(propRef);
+		if (propShader) {
+			if (propShader->HasType<BSShaderPPLightingProperty>() || propShader->HasType<NiMaterialProperty>()) {
+				deleteIDs.push_back(propShader->GetTextureSetRef());
+				deleteIDs.push_back(propShader->GetControllerRef());
+			}
+		}
+
+		deleteIDs.push_back(propRef);
+	}
+
+	for (int i = 0; i < shape->GetNumExtraData(); i++)
+		deleteIDs.push_back(shape->GetExtraDataRef(i));
+
+	deleteIDs.push_back(GetBlockID(shape));
+	hdr.DeleteBlocks(deleteIDs);
 }
 
 void NifFile::DeleteShader(const std::string& shapeName) {
@@ -3066,6 +3265,8 @@ void NifFile::DeleteShader(const std::string& shapeName) {
 	if (!shape)
 		return;
 
+	ParseDeferredBlocks();
+
 	if (shape->GetShaderPropertyRef() != 0xFFFFFFFF) {
 		auto shader = hdr.GetBlock<NiShader>(shape->GetShaderPropertyRef());
 		if (shader) {
@@ -3097,6 +3298,8 @@ void NifFile::DeleteAlpha(const std::string& shapeName) {
 	if (!shape)
 		return;
 
+	ParseDeferredBlocks();
+
 	auto alpha = hdr.GetBlock<NiAlphaProperty>(shape->GetAlphaPropertyRef());
 	if (alpha) {
 		hdr.DeleteBlock(shape->GetAlphaPropertyRef());
@@ -3118,6 +3321,8 @@ void NifFile::DeleteSkinning(const std::string& shapeName) {
 	if (!shape)
 		return;
 
+	ParseDeferredBlocks();
+
 	auto skinInst = hdr.GetBlock<NiSkinInstance>(shape->GetSkinInstanceRef());
 	if (skinInst) {
 		hdr.DeleteBlock(skinInst->GetDataRef());
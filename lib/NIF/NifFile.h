@@ -102,6 +102,9 @@ private:
 
 	NiHeader hdr;
 
+	// Renames through the header, so its name index stays current
+	void SetObjectName(NiAVObject* obj, const std::string& newName);
+
 public:
 	NifFile() {}
 
@@ -116,9 +119,18 @@ public:
 	NiHeader& GetHeader() { return hdr; }
 	void CopyFrom(const NifFile& other);
 
+	// Replaces the geometry and skinning blocks of a shape with copies of the same blocks in base,
+	// undoing vertex edits without copying the whole file. Requires both files to have the same block layout.
+	bool RestoreShapeFrom(NifFile& base, const std::string& shapeName);
+
 	// Link NiGeometryData to NiGeometry
 	void LinkGeomData();
 
+	// Block types that a partial load keeps as raw data
+	static bool IsDeferrableBlockType(const std::string& blockTypeStr);
+	// Parses the blocks a partial load kept as raw data. Deleting or reordering blocks does this first.
+	void ParseDeferredBlocks();
+
 	int AddNode(const std::string& nodeName, std::vector<Vector3>& rot, Vector3& trans, float scale);
 	void DeleteNode(const std::string& nodeName);
 	std::string GetNodeName(const int blockID);
@@ -128,7 +140,11 @@ public:
 	int AddStringExtraData(const std::string& blockName, const std::string& name, const std::string& stringData, bool isNode = false);
 	int AddIntegerExtraData(const std::string& blockName, const std::string& name, const int integerData, bool isNode = false);
 
-	int Load(const std::string& filename);
+	// With partial set, animation, collision, particle and cloth blocks are kept as raw data until ParseDeferredBlocks,
+	// GetBlock doesn't return them as their own types. Blocks that were never parsed are saved back unchanged.
+	int Load(const std::string& filename, const bool partial = false);
+	// Loads from a stream positioned at the start of the file, e.g. a file in memory. The name is only used for its extension.
+	int Load(std::iostream& file, const std::string& filename = "", const bool partial = false);
 	int Save(const std::string& filename, bool optimize = true, bool sortBlocks = true);
 	void Optimize();
 	OptResultSSE OptimizeForSSE(const OptOptionsSSE& options = OptOptionsSSE());
@@ -148,6 +164,8 @@ public:
 	// Sorts children block references under the root node so shapes appear first in the list, emulating the order created by nifskope.
 	void PrettySortBlocks();
 	bool DeleteUnreferencedBlocks();
+	void DeleteBlock(const int blockId);
+	void DeleteBlockByType(const std::string& blockTypeStr);
 
 	NiShape* FindShapeByName(const std::string& name, int dupIndex = 0);
 	NiAVObject* FindAVObjectByName(const std::string& name, int dupIndex = 0);
@@ -0,0 +1,177 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TangentSpace.h"
+#include "KDMatcher.h"
+
+#ifdef WIN64
+	#include <ppl.h>
+#else
+	#undef _PPL_H
+#endif
+
+template<typename Func>
+static void ParallelFor(const int count, const Func& func) {
+#ifdef _PPL_H
+	concurrency::parallel_for(0, count, func);
+#else
+	for (int i = 0; i < count; i++)
+		func(i);
+#endif
+}
+
+TangentSpace::TangentSpace(const int numVertices, const std::vector<Triangle>& tris, const int numTris) : tris(tris) {
+	this->numVertices = numVertices;
+	this->numTris = std::min(numTris, (int)tris.size());
+
+	auto validTri = [&](const Triangle& t) {
+		return t.p1 < numVertices && t.p2 < numVertices && t.p3 < numVertices;
+	};
+
+	// Count corners per vertex, then fill in ascending triangle order
+	vertTriStart.assign(numVertices + 1, 0);
+	for (int t = 0; t < this->numTris; t++) {
+		const Triangle& tri = tris[t];
+		if (!validTri(tri))
+			continue;
+
+		vertTriStart[tri.p1 + 1]++;
+		vertTriStart[tri.p2 + 1]++;
+		vertTriStart[tri.p3 + 1]++;
+	}
+
+	for (int v = 0; v < numVertices; v++)
+		vertTriStart[v + 1] += vertTriStart[v];
+
+	vertTris.resize(vertTriStart[numVertices]);
+	std::vector<int> fill(vertTriStart.begin(), vertTriStart.end() - 1);
+	for (int t = 0; t < this->numTris; t++) {
+		const Triangle& tri = tris[t];
+		if (!validTri(tri))
+			continue;
+
+		vertTris[fill[tri.p1]++] = t;
+		vertTris[fill[tri.p2]++] = t;
+		vertTris[fill[tri.p3]++] = t;
+	}
+}
+
+void TangentSpace::CalcNormals(const std::vector<Vector3>& verts, std::vector<Vector3>& outNorms) const {
+	std::vector<Vector3> faceNorms(numTris);
+	ParallelFor(numTris, [&](int t) {
+		Triangle tri = tris[t];
+		if (tri.p1 < numVertices && tri.p2 < numVertices && tri.p3 < numVertices)
+			tri.trinormal(verts, &faceNorms[t]);
+	});
+
+	outNorms.resize(numVertices);
+	ParallelFor(numVertices, [&](int v) {
+		Vector3 n;
+		for (int i = vertTriStart[v]; i < vertTriStart[v + 1]; i++)
+			n += faceNorms[vertTris[i]];
+
+		n.Normalize();
+		outNorms[v] = n;
+	});
+}
+
+void TangentSpace::SmoothNormals(std::vector<Vector3>& verts, std::vector<Vector3>& norms, const float smoothThresh) {
+	kd_matcher matcher(verts.data(), verts.size());
+	for (int i = 0; i < matcher.matches.size(); i++) {
+		std::pair<Vector3*, int>& a = matcher.matches[i].first;
+		std::pair<Vector3*, int>& b = matcher.matches[i].second;
+
+		Vector3& an = norms[a.second];
+		Vector3& bn = norms[b.second];
+		if (an.angle(bn) < smoothThresh * DEG2RAD) {
+			Vector3 anT = an;
+			an += bn;
+			bn += anT;
+		}
+	}
+
+	for (auto &n : norms)
+		n.Normalize();
+}
+
+void TangentSpace::CalcTangents(const std::vector<Vector3>& verts, const std::vector<Vector2>& uvs, const std::vector<Vector3>& norms,
+	std::vector<Vector3>& outTangents, std::vector<Vector3>& outBitangents) const {
+	std::vector<Vector3> faceTangents(numTris);
+	std::vector<Vector3> faceBitangents(numTris);
+
+	ParallelFor(numTris, [&](int t) {
+		const Triangle& tri = tris[t];
+		if (tri.p1 >= numVertices || tri.p2 >= numVertices || tri.p3 >= numVertices)
+			return;
+
+		const Vector3& v1 = verts[tri.p1];
+		const Vector3& v2 = verts[tri.p2];
+		const Vector3& v3 = verts[tri.p3];
+
+		const Vector2& w1 = uvs[tri.p1];
+		const Vector2& w2 = uvs[tri.p2];
+		const Vector2& w3 = uvs[tri.p3];
+
+		float x1 = v2.x - v1.x;
+		float x2 = v3.x - v1.x;
+		float y1 = v2.y - v1.y;
+		float y2 = v3.y - v1.y;
+		float z1 = v2.z - v1.z;
+		float z2 = v3.z - v1.z;
+
+		float s1 = w2.u - w1.u;
+		float s2 = w3.u - w1.u;
+		float t1 = w2.v - w1.v;
+		float t2 = w3.v - w1.v;
+
+		float r = (s1 * t2 - s2 * t1);
+		r = (r >= 0.0f ? +1.0f : -1.0f);
+
+		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+
+		sdir.Normalize();
+		tdir.Normalize();
+
+		faceTangents[t] = tdir;
+		faceBitangents[t] = sdir;
+	});
+
+	outTangents.resize(numVertices);
+	outBitangents.resize(numVertices);
+
+	ParallelFor(numVertices, [&](int v) {
+		Vector3 tangent;
+		Vector3 bitangent;
+		for (int i = vertTriStart[v]; i < vertTriStart[v + 1]; i++) {
+			tangent += faceTangents[vertTris[i]];
+			bitangent += faceBitangents[vertTris[i]];
+		}
+
+		const Vector3& normal = norms[v];
+		if (tangent.IsZero() || bitangent.IsZero()) {
+			tangent.x = normal.y;
+			tangent.y = normal.z;
+			tangent.z = normal.x;
+			bitangent = normal.cross(tangent);
+		}
+		else {
+			tangent.Normalize();
+			tangent = (tangent - normal * normal.dot(tangent));
+			tangent.Normalize();
+
+			bitangent.Normalize();
+
+			bitangent = (bitangent - normal * normal.dot(bitangent));
+			bitangent = (bitangent - tangent * tangent.dot(bitangent));
+
+			bitangent.Normalize();
+		}
+
+		outTangents[v] = tangent;
+		outBitangents[v] = bitangent;
+	});
+}
@@ -0,0 +1,36 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "Object3d.h"
+
+// Normal and tangent computation shared by the geometry blocks, working on separate position, uv and normal arrays.
+// Per-triangle terms are calculated in parallel and then gathered per vertex through a vertex to triangle adjacency.
+// Each vertex adds its triangles in triangle order, so the sums are the same as with a serial accumulation.
+class TangentSpace {
+private:
+	const std::vector<Triangle>& tris;
+	int numVertices = 0;
+	int numTris = 0;
+
+	// Triangles around vertex v are vertTris[vertTriStart[v]] to vertTris[vertTriStart[v + 1] - 1]
+	std::vector<int> vertTriStart;
+	std::vector<int> vertTris;
+
+public:
+	TangentSpace(const int numVertices, const std::vector<Triangle>& tris, const int numTris);
+
+	// Sums the face normals around each vertex and normalizes them.
+	void CalcNormals(const std::vector<Vector3>& verts, std::vector<Vector3>& outNorms) const;
+
+	// Adds up the normals of vertices at the same position if the angle between them is below the threshold (in degrees).
+	static void SmoothNormals(std::vector<Vector3>& verts, std::vector<Vector3>& norms, const float smoothThresh);
+
+	// Tangents and bitangents from the uv gradients around each vertex, orthogonalized against the normals.
+	void CalcTangents(const std::vector<Vector3>& verts, const std::vector<Vector2>& uvs, const std::vector<Vector3>& norms,
+		std::vector<Vector3>& outTangents, std::vector<Vector3>& outBitangents) const;
+};
@@ -73,7 +73,7 @@ void main(void)
 	segmentColor = vec4(1.0, 1.0, 1.0, 1.0);
 	vColor = vec4(1.0, 1.0, 1.0, 1.0);
 	vUV = vertexUV;
-	vNormal = vertexNormal;
+	vNormal = normalize(vertexNormal);
 	
 	// Eye-coordinate position of vertex
 	vPos = vec3(matModelView * vec4(vertexPosition, 1.0));
@@ -25,7 +25,7 @@ out vec2 uv;
 
 void main(void)
 { 
-	N = vertexNormal;   
+	N = normalize(vertexNormal);
 	vPos =  vec3(matModelView * vec4(vertexPosition, 1.0));   	
 	v = vec3(matModelView * vec4(vertexUV, 0.0, 1.0));
 		   
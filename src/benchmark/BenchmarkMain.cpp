@@ -0,0 +1,182 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "NifBenchmark.h"
+#include "StrokeBenchmark.h"
+#include "LookupBenchmarks.h"
+
+#include <wx/init.h>
+#include <wx/cmdline.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+ConfigurationManager Config;
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+	{ wxCMD_LINE_OPTION, "nb", "nifbench", "benchmarks the NIF library on all files in the specified directory", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "nbo", "nifbenchout", "JSON report file of the benchmark, defaults to NifBenchmark.json", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "nbi", "nifbenchiter", "number of runs per file and stage, defaults to 1", wxCMD_LINE_VAL_NUMBER },
+	{ wxCMD_LINE_SWITCH, "nbp", "nifbenchpartial", "uses partial loading for the benchmark" },
+	{ wxCMD_LINE_SWITCH, "cb", "configbench", "compares the configuration lookup paths on Config.xml" },
+	{ wxCMD_LINE_SWITCH, "slb", "sliderbench", "compares the slider name lookups on a generated set of 300 sliders" },
+	{ wxCMD_LINE_SWITCH, "grb", "groupbench", "times loading and outfit lookups of 500 generated groups with 5000 outfits" },
+	{ wxCMD_LINE_OPTION, "sb", "strokebench", "replays a brush stroke over all shapes of the specified NIF file or directory", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "sbs", "strokebenchstroke", "stroke file to replay, the recorded stroke is saved to it if it doesn't exist yet", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "sbo", "strokebenchout", "JSON report file of the benchmark, defaults to StrokeBenchmark.json", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "sbd", "strokebenchdabs", "number of dabs of a recorded stroke, defaults to 100", wxCMD_LINE_VAL_NUMBER },
+	{ wxCMD_LINE_NONE }
+};
+
+static bool RunNifBenchmark(wxCmdLineParser& parser, const wxString& dir) {
+	wxString reportFile = "NifBenchmark.json";
+	long iterations = 1;
+	parser.Found("nbo", &reportFile);
+	parser.Found("nbi", &iterations);
+
+	wxArrayString files;
+	wxDir::GetAllFiles(dir, &files, "*.nif");
+	files.Sort();
+
+	wxString tempFile = wxFileName::CreateTempFileName("nifbench");
+
+	wxLogMessage("Benchmarking %zu NIF files in '%s'...", files.size(), dir);
+
+	NifBenchmark benchmark(tempFile.ToStdString(), iterations, parser.Found("nbp"));
+	for (auto &f : files) {
+		auto& result = benchmark.RunFile(f.ToStdString());
+		if (result.error)
+			wxLogWarning("Failed to load '%s' (%d).", f, result.error);
+		else if (!result.roundTripIdentical)
+			wxLogWarning("Saving '%s' changed its contents at byte %lld.", f, result.firstDifference);
+	}
+
+	wxRemoveFile(tempFile);
+
+	if (!benchmark.WriteReport(reportFile.ToStdString())) {
+		wxLogError("Failed to write benchmark report '%s'.", reportFile);
+		return false;
+	}
+
+	wxLogMessage("Benchmark finished with %d failed file(s), report written to '%s'.", benchmark.GetFailureCount(), reportFile);
+	return benchmark.GetFailureCount() == 0;
+}
+
+static bool RunStrokeBenchmark(wxCmdLineParser& parser, const wxString& input) {
+	wxString strokeFile;
+	wxString reportFile = "StrokeBenchmark.json";
+	long dabs = 100;
+	parser.Found("sbs", &strokeFile);
+	parser.Found("sbo", &reportFile);
+	parser.Found("sbd", &dabs);
+
+	wxArrayString files;
+	if (wxFileName::FileExists(input))
+		files.Add(input);
+	else
+		wxDir::GetAllFiles(input, &files, "*.nif");
+
+	files.Sort();
+
+	StrokeBenchmark benchmark;
+	for (auto &f : files)
+		if (benchmark.AddMeshes(f.ToStdString()) < 0)
+			wxLogWarning("Failed to load '%s'.", f);
+
+	if (benchmark.GetMeshCount() == 0) {
+		wxLogError("No meshes found in '%s'.", input);
+		return false;
+	}
+
+	// A stroke file that exists is replayed, otherwise the recorded stroke is saved to it
+	if (!strokeFile.IsEmpty() && wxFileName::FileExists(strokeFile)) {
+		if (!benchmark.LoadStroke(strokeFile.ToStdString())) {
+			wxLogError("Failed to load stroke '%s'.", strokeFile);
+			return false;
+		}
+	}
+	else {
+		benchmark.RecordStroke(dabs);
+		if (!strokeFile.IsEmpty() && !benchmark.SaveStroke(strokeFile.ToStdString()))
+			wxLogWarning("Failed to save stroke '%s'.", strokeFile);
+	}
+
+	wxLogMessage("Replaying a stroke of %d dabs over %d meshes...", benchmark.GetDabCount(), benchmark.GetMeshCount());
+
+	TweakBrush standardBrush;
+	TB_Deflate deflateBrush;
+	TB_Smooth smoothBrush;
+	TB_Mask maskBrush;
+	TB_Move moveBrush;
+
+	benchmark.Run(&standardBrush);
+	benchmark.Run(&standardBrush, true);
+	benchmark.Run(&deflateBrush);
+	benchmark.Run(&smoothBrush);
+	benchmark.Run(&maskBrush);
+	benchmark.Run(&moveBrush);
+
+	if (!benchmark.WriteReport(reportFile.ToStdString())) {
+		wxLogError("Failed to write benchmark report '%s'.", reportFile);
+		return false;
+	}
+
+	wxLogMessage("Stroke benchmark finished, report written to '%s'.", reportFile);
+	return true;
+}
+
+// Runs every benchmark given on the command line, exits with 1 if any of them failed.
+int main(int argc, char** argv) {
+	wxInitializer initializer(argc, argv);
+	if (!initializer.IsOk())
+		return 1;
+
+	wxCmdLineParser parser(g_cmdLineDesc, argc, argv);
+	if (parser.Parse() != 0)
+		return 1;
+
+	bool success = true;
+	bool ran = false;
+
+	wxString input;
+	if (parser.Found("nb", &input)) {
+		success &= RunNifBenchmark(parser, input);
+		ran = true;
+	}
+
+	if (parser.Found("cb")) {
+		if (Config.LoadConfig() == 0) {
+			RunConfigBenchmark(Config);
+		}
+		else {
+			wxLogError("Failed to load 'Config.xml'.");
+			success = false;
+		}
+		ran = true;
+	}
+
+	if (parser.Found("slb")) {
+		RunSliderBenchmark();
+		ran = true;
+	}
+
+	if (parser.Found("grb")) {
+		RunGroupBenchmark();
+		ran = true;
+	}
+
+	if (parser.Found("sb", &input)) {
+		success &= RunStrokeBenchmark(parser, input);
+		ran = true;
+	}
+
+	if (!ran) {
+		parser.Usage();
+		return 1;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "BenchmarkTiming.h"
+
+#include <algorithm>
+#include <cmath>
+
+double Median(std::vector<double> values) {
+	if (values.empty())
+		return 0.0;
+
+	std::sort(values.begin(), values.end());
+	size_t mid = values.size() / 2;
+	if (values.size() % 2 == 0)
+		return (values[mid - 1] + values[mid]) / 2.0;
+
+	return values[mid];
+}
+
+double Percentile(const std::vector<double>& sorted, const double p) {
+	if (sorted.empty())
+		return 0.0;
+
+	size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+	rank = std::max<size_t>(1, std::min(rank, sorted.size()));
+	return sorted[rank - 1];
+}
@@ -0,0 +1,24 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// Milliseconds it takes to run func once
+template<typename Func>
+double MeasureMs(Func func) {
+	auto start = std::chrono::high_resolution_clock::now();
+	func();
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+double Median(std::vector<double> values);
+
+// Nearest-rank percentile of sorted values
+double Percentile(const std::vector<double>& sorted, const double p);
@@ -0,0 +1,170 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "LookupBenchmarks.h"
+#include "BenchmarkTiming.h"
+#include "../components/SliderManager.h"
+#include "../components/SliderGroup.h"
+
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+void RunConfigBenchmark(ConfigurationManager& config) {
+	std::vector<ConfigurationItem*> items;
+	config.EnumerateCIs(items);
+
+	std::vector<std::string> names;
+	for (auto &ci : items)
+		if (!ci->isComment && !ci->path.empty())
+			names.push_back(ci->path);
+
+	std::vector<ConfigurationKey> keys;
+	for (auto &name : names)
+		keys.emplace_back(name);
+
+	const int rounds = 10000;
+	size_t found = 0;
+	auto timeLookups = [&](const std::function<void()>& lookup) {
+		double ms = MeasureMs([&]() {
+			for (int r = 0; r < rounds; r++)
+				lookup();
+		});
+		return ms * 1e6 / (rounds * std::max<size_t>(1, names.size()));
+	};
+
+	double treeTime = timeLookups([&]() {
+		for (auto &name : names) {
+			ConfigurationItem* ci = config.FindCIByTree(name);
+			found += ci && !_stricmp(ci->value.c_str(), "true");
+		}
+	});
+
+	double indexTime = timeLookups([&]() {
+		for (auto &name : names)
+			found += config.MatchValue(name, "true");
+	});
+
+	double keyTime = timeLookups([&]() {
+		for (auto &key : keys)
+			found += config.MatchValue(key, "true");
+	});
+
+	wxLogMessage("Configuration lookups of %zu keys (%zu hits): tree %.1f ns, index %.1f ns, key %.1f ns per lookup.",
+		names.size(), found, treeTime, indexTime, keyTime);
+}
+
+void RunSliderBenchmark() {
+	const int sliderCount = 300;
+	const int shapeCount = 20;
+	const int rounds = 100;
+
+	SliderSet set;
+	std::vector<std::string> names;
+	for (int i = 0; i < sliderCount; i++) {
+		std::string name = wxString::Format("BenchSlider%03d", i).ToStdString();
+		int index = set.CreateSlider(name);
+		set[index].defBigValue = 100.0f;
+		set[index].AddDataFile("Body", "Body" + name, "Body" + name + ".bsd");
+		names.push_back(name);
+	}
+
+	SliderManager manager;
+	double setupTime = MeasureMs([&]() {
+		manager.AddSlidersInSet(set);
+		manager.InitializeSliders();
+	});
+
+	// Lookups like those of a batch build, once per slider and shape of each outfit
+	size_t found = 0;
+	auto timeLookups = [&](const std::function<void(const std::string&)>& lookup) {
+		double ms = MeasureMs([&]() {
+			for (int r = 0; r < rounds; r++)
+				for (int shape = 0; shape < shapeCount; shape++)
+					for (auto &name : names)
+						lookup(name);
+		});
+		return ms * 1e6 / (rounds * shapeCount * sliderCount);
+	};
+
+	double scanTime = timeLookups([&](const std::string& name) {
+		for (auto &slider : manager.slidersBig) {
+			if (slider.name == name) {
+				found += slider.value > 0.0f;
+				break;
+			}
+		}
+	});
+
+	double managerTime = timeLookups([&](const std::string& name) {
+		int index = manager.GetSliderIndex(name);
+		if (index != -1)
+			found += manager.slidersBig[index].value > 0.0f;
+	});
+
+	double setTime = timeLookups([&](const std::string& name) {
+		found += set[name].defBigValue > 0.0f;
+	});
+
+	wxLogMessage("Slider lookups of %d sliders (%zu hits): scan %.1f ns, manager index %.1f ns, set index %.1f ns per lookup. Manager setup took %.0f us.",
+		sliderCount, found, scanTime, managerTime, setTime, setupTime * 1000.0);
+}
+
+void RunGroupBenchmark() {
+	const int outfitCount = 5000;
+	const int groupCount = 500;
+	const int groupsPerFile = 10;
+	const int membersPerGroup = 50;
+
+	wxString benchDir = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "BodySlideGroupBench";
+	wxFileName::Mkdir(benchDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	// Fixed seed, so that runs are comparable
+	std::mt19937 rng(5000);
+	std::uniform_int_distribution<int> pickOutfit(0, outfitCount - 1);
+	for (int f = 0; f < groupCount / groupsPerFile; f++) {
+		SliderSetGroupFile groupFile;
+		groupFile.New(wxString::Format("%s%cGroups%03d.xml", benchDir, wxFileName::GetPathSeparator(), f).ToStdString());
+
+		for (int g = 0; g < groupsPerFile; g++) {
+			std::vector<std::string> members;
+			for (int m = 0; m < membersPerGroup; m++)
+				members.push_back(wxString::Format("Outfit%04d", pickOutfit(rng)).ToStdString());
+
+			SliderSetGroup group;
+			group.SetName(wxString::Format("Group%03d", f * groupsPerFile + g).ToStdString());
+			group.AddMembers(members);
+			groupFile.UpdateGroup(group);
+		}
+
+		groupFile.Save();
+	}
+
+	SliderSetGroupCollection collection;
+	double loadTime = MeasureMs([&]() {
+		collection.LoadGroups(benchDir.ToStdString());
+	});
+
+	std::vector<std::string> outfits;
+	for (int i = 0; i < outfitCount; i++)
+		outfits.push_back(wxString::Format("Outfit%04d", i).ToStdString());
+
+	// Lookups like those of the ungrouped list, the group filter and the build list
+	size_t memberships = 0;
+	std::vector<std::string> groups;
+	double lookupTime = MeasureMs([&]() {
+		for (auto &outfit : outfits)
+			memberships += collection.GetOutfitGroups(outfit, groups);
+	});
+
+	wxFileName::Rmdir(benchDir, wxPATH_RMDIR_RECURSIVE);
+
+	wxLogMessage("Groups of %d outfits in %d groups (%zu memberships): loading took %.1f ms, looking up all outfits took %.2f ms.",
+		outfitCount, groupCount, memberships, loadTime, lookupTime);
+}
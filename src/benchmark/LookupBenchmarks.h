@@ -0,0 +1,20 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../utils/ConfigurationManager.h"
+
+// Compares the lookup paths of the configuration, sliders and groups and logs the results.
+
+// Looks up every value of the loaded configuration by tree, by name and by prepared key.
+void RunConfigBenchmark(ConfigurationManager& config);
+
+// Lookups of a generated set of 300 sliders, like those of a batch build.
+void RunSliderBenchmark();
+
+// Loading and outfit lookups of 500 generated groups with 5000 outfits.
+void RunGroupBenchmark();
@@ -0,0 +1,260 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "NifBenchmark.h"
+#include "BenchmarkTiming.h"
+#include "../NIF/NifFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+const std::vector<std::string> NifBenchmark::stageNames = { "load", "save", "optimize_sse", "skin_partitions", "tangents" };
+
+static std::string JsonString(const std::string& str) {
+	std::string out = "\"";
+	for (auto &c : str) {
+		switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+					out += buf;
+				}
+				else
+					out += c;
+		}
+	}
+	out += "\"";
+	return out;
+}
+
+static std::string JsonNumber(const double value) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%.4f", value);
+	return buf;
+}
+
+NifBenchmark::NifBenchmark(const std::string& tempFile, const int iterations, const bool partialLoad) {
+	this->tempFile = tempFile;
+	this->iterations = std::max(1, iterations);
+	this->partialLoad = partialLoad;
+}
+
+bool NifBenchmark::CompareFiles(const std::string& fileA, const std::string& fileB, long long& firstDifference) {
+	firstDifference = -1;
+
+	std::ifstream a(fileA, std::ios::binary);
+	std::ifstream b(fileB, std::ios::binary);
+	if (!a.is_open() || !b.is_open())
+		return false;
+
+	std::vector<char> dataA((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+	std::vector<char> dataB((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+
+	auto diff = std::mismatch(dataA.begin(), dataA.end(), dataB.begin(), dataB.end());
+	if (diff.first == dataA.end() && diff.second == dataB.end())
+		return true;
+
+	firstDifference = diff.first - dataA.begin();
+	return false;
+}
+
+const NifBenchmark::FileResult& NifBenchmark::RunFile(const std::string& fileName) {
+	results.emplace_back();
+	FileResult& result = results.back();
+	result.fileName = fileName;
+
+	std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+	if (file.is_open())
+		result.fileSize = file.tellg();
+	file.close();
+
+	std::map<std::string, std::vector<double>> times;
+
+	NifFile base;
+	for (int i = 0; i < iterations; i++) {
+		NifFile nif;
+		times["load"].push_back(MeasureMs([&]() { result.error = nif.Load(fileName, partialLoad); }));
+		if (result.error)
+			return result;
+
+		if (i == iterations - 1)
+			base.CopyFrom(nif);
+	}
+
+	std::vector<std::string> shapes;
+	base.GetShapeList(shapes);
+	result.numBlocks = base.GetHeader().GetNumBlocks();
+	result.numShapes = shapes.size();
+
+	// Saved without optimizing or sorting, so the output should match the input
+	for (int i = 0; i < iterations; i++) {
+		NifFile nif(base);
+		times["save"].push_back(MeasureMs([&]() { nif.Save(tempFile, false, false); }));
+	}
+
+	result.roundTripChecked = true;
+	result.roundTripIdentical = CompareFiles(fileName, tempFile, result.firstDifference);
+	std::remove(tempFile.c_str());
+
+	NiVersion& version = base.GetHeader().GetVersion();
+	if (version.User() == 12 && version.User2() == 83) {
+		for (int i = 0; i < iterations; i++) {
+			NifFile nif(base);
+			times["optimize_sse"].push_back(MeasureMs([&]() { nif.OptimizeForSSE(); }));
+		}
+	}
+
+	if (!shapes.empty()) {
+		for (int i = 0; i < iterations; i++) {
+			NifFile nif(base);
+			times["skin_partitions"].push_back(MeasureMs([&]() {
+				for (auto &s : shapes)
+					nif.UpdateSkinPartitions(s);
+			}));
+		}
+
+		for (int i = 0; i < iterations; i++) {
+			NifFile nif(base);
+			times["tangents"].push_back(MeasureMs([&]() {
+				for (auto &s : shapes)
+					nif.CalcTangentsForShape(s);
+			}));
+		}
+	}
+
+	for (auto &t : times)
+		result.stageTimes[t.first] = Median(t.second);
+
+	return result;
+}
+
+int NifBenchmark::GetFailureCount() {
+	int failures = 0;
+	for (auto &r : results)
+		if (r.error || (r.roundTripChecked && !r.roundTripIdentical))
+			failures++;
+
+	return failures;
+}
+
+bool NifBenchmark::WriteReport(const std::string& fileName) {
+	std::ofstream out(fileName, std::ios::binary);
+	if (!out.is_open())
+		return false;
+
+	int loadErrors = 0;
+	int mismatches = 0;
+	unsigned long long totalBytes = 0;
+	unsigned long long totalBlocks = 0;
+	for (auto &r : results) {
+		if (r.error) {
+			loadErrors++;
+			continue;
+		}
+
+		if (r.roundTripChecked && !r.roundTripIdentical)
+			mismatches++;
+
+		totalBytes += r.fileSize;
+		totalBlocks += r.numBlocks;
+	}
+
+	out << "{\n";
+	out << "\t\"iterations\": " << iterations << ",\n";
+	out << "\t\"partialLoad\": " << (partialLoad ? "true" : "false") << ",\n";
+	out << "\t\"summary\": {\n";
+	out << "\t\t\"files\": " << results.size() << ",\n";
+	out << "\t\t\"loadErrors\": " << loadErrors << ",\n";
+	out << "\t\t\"roundTripMismatches\": " << mismatches << ",\n";
+	out << "\t\t\"totalBytes\": " << totalBytes << ",\n";
+	out << "\t\t\"totalBlocks\": " << totalBlocks << ",\n";
+	out << "\t\t\"stages\": {";
+
+	bool firstStage = true;
+	for (auto &stage : stageNames) {
+		std::vector<double> stageTimes;
+		double totalMs = 0.0;
+		unsigned long long stageBytes = 0;
+		unsigned long long stageBlocks = 0;
+		for (auto &r : results) {
+			auto it = r.stageTimes.find(stage);
+			if (it == r.stageTimes.end())
+				continue;
+
+			stageTimes.push_back(it->second);
+			totalMs += it->second;
+			stageBytes += r.fileSize;
+			stageBlocks += r.numBlocks;
+		}
+
+		if (stageTimes.empty())
+			continue;
+
+		std::sort(stageTimes.begin(), stageTimes.end());
+		double seconds = totalMs / 1000.0;
+
+		out << (firstStage ? "\n" : ",\n");
+		out << "\t\t\t" << JsonString(stage) << ": {\n";
+		out << "\t\t\t\t\"files\": " << stageTimes.size() << ",\n";
+		out << "\t\t\t\t\"totalMs\": " << JsonNumber(totalMs) << ",\n";
+		out << "\t\t\t\t\"minMs\": " << JsonNumber(stageTimes.front()) << ",\n";
+		out << "\t\t\t\t\"p50Ms\": " << JsonNumber(Percentile(stageTimes, 50.0)) << ",\n";
+		out << "\t\t\t\t\"p90Ms\": " << JsonNumber(Percentile(stageTimes, 90.0)) << ",\n";
+		out << "\t\t\t\t\"p99Ms\": " << JsonNumber(Percentile(stageTimes, 99.0)) << ",\n";
+		out << "\t\t\t\t\"maxMs\": " << JsonNumber(stageTimes.back()) << ",\n";
+		out << "\t\t\t\t\"blocksPerSecond\": " << JsonNumber(seconds > 0.0 ? stageBlocks / seconds : 0.0) << ",\n";
+		out << "\t\t\t\t\"megabytesPerSecond\": " << JsonNumber(seconds > 0.0 ? stageBytes / (1024.0 * 1024.0) / seconds : 0.0) << "\n";
+		out << "\t\t\t}";
+		firstStage = false;
+	}
+
+	out << "\n\t\t}\n";
+	out << "\t},\n";
+	out << "\t\"files\": [";
+
+	for (int i = 0; i < results.size(); i++) {
+		const FileResult& r = results[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\n";
+		out << "\t\t\t\"file\": " << JsonString(r.fileName) << ",\n";
+		out << "\t\t\t\"bytes\": " << r.fileSize << ",\n";
+		out << "\t\t\t\"error\": " << r.error;
+
+		if (!r.error) {
+			out << ",\n";
+			out << "\t\t\t\"blocks\": " << r.numBlocks << ",\n";
+			out << "\t\t\t\"shapes\": " << r.numShapes << ",\n";
+			out << "\t\t\t\"roundTripIdentical\": " << (r.roundTripIdentical ? "true" : "false") << ",\n";
+			out << "\t\t\t\"firstDifference\": " << r.firstDifference << ",\n";
+			out << "\t\t\t\"stagesMs\": {";
+
+			bool firstTime = true;
+			for (auto &stage : stageNames) {
+				auto it = r.stageTimes.find(stage);
+				if (it == r.stageTimes.end())
+					continue;
+
+				out << (firstTime ? " " : ", ") << JsonString(stage) << ": " << JsonNumber(it->second);
+				firstTime = false;
+			}
+
+			out << " }";
+		}
+
+		out << "\n\t\t}";
+	}
+
+	out << "\n\t]\n";
+	out << "}\n";
+	return true;
+}
@@ -0,0 +1,54 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Times the stages of the NIF library on a set of files and checks that loading and saving a file
+// without any changes gives back the same bytes. Results are written as a JSON report that can be
+// compared between versions.
+class NifBenchmark {
+public:
+	struct FileResult {
+		std::string fileName;
+		unsigned long long fileSize = 0;
+		unsigned int numBlocks = 0;
+		unsigned int numShapes = 0;
+		int error = 0;
+
+		// Median time of each stage in milliseconds. Stages that don't apply to the file are left out.
+		std::map<std::string, double> stageTimes;
+
+		bool roundTripChecked = false;
+		bool roundTripIdentical = false;
+		long long firstDifference = -1;
+	};
+
+private:
+	int iterations = 1;
+	bool partialLoad = false;
+	std::string tempFile;
+	std::vector<FileResult> results;
+
+	bool CompareFiles(const std::string& fileA, const std::string& fileB, long long& firstDifference);
+
+public:
+	// Stage names used in the report, in the order they're run.
+	static const std::vector<std::string> stageNames;
+
+	NifBenchmark(const std::string& tempFile, const int iterations = 1, const bool partialLoad = false);
+
+	// Runs all stages on one file. Every stage works on a fresh copy of the loaded file.
+	const FileResult& RunFile(const std::string& fileName);
+
+	const std::vector<FileResult>& GetResults() { return results; }
+	int GetFailureCount();
+
+	bool WriteReport(const std::string& fileName);
+};
@@ -0,0 +1,273 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "StrokeBenchmark.h"
+#include "BenchmarkTiming.h"
+#include "../NIF/NifFile.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <locale>
+
+int StrokeBenchmark::AddMeshes(const std::string& nifFile) {
+	NifFile nif;
+	if (nif.Load(nifFile))
+		return -1;
+
+	std::vector<std::string> shapes;
+	nif.GetShapeList(shapes);
+
+	int added = 0;
+	for (auto &s : shapes) {
+		std::vector<Vector3> nifVerts;
+		std::vector<Triangle> nifTris;
+		nif.GetVertsForShape(s, nifVerts);
+		nif.GetTrisForShape(s, &nifTris);
+		if (nifVerts.empty() || nifTris.empty())
+			continue;
+
+		auto m = std::make_unique<mesh>();
+		m->shapeName = s;
+		m->nVerts = nifVerts.size();
+		m->nTris = nifTris.size();
+		m->verts = std::make_unique<Vector3[]>(m->nVerts);
+		m->norms = std::make_unique<Vector3[]>(m->nVerts);
+		m->vcolors = std::make_unique<Vector3[]>(m->nVerts);
+		m->tris = std::make_unique<Triangle[]>(m->nTris);
+
+		// Same conversion to the editor space as for the meshes in Outfit Studio
+		for (int i = 0; i < m->nVerts; i++) {
+			m->verts[i].x = nifVerts[i].x / -10.0f;
+			m->verts[i].z = nifVerts[i].y / 10.0f;
+			m->verts[i].y = nifVerts[i].z / 10.0f;
+		}
+
+		for (int t = 0; t < m->nTris; t++)
+			m->tris[t] = nifTris[t];
+
+		kd_matcher matcher(m->verts.get(), m->nVerts);
+		for (int i = 0; i < matcher.matches.size(); i++) {
+			std::pair<Vector3*, int>& a = matcher.matches[i].first;
+			std::pair<Vector3*, int>& b = matcher.matches[i].second;
+			m->weldVerts[a.second].push_back(b.second);
+			m->weldVerts[b.second].push_back(a.second);
+		}
+
+		m->FacetNormals();
+		m->BuildTriAdjacency();
+		m->BuildEdgeList();
+		m->CreateBVH();
+
+		meshes.push_back(std::move(m));
+		added++;
+	}
+
+	return added;
+}
+
+bool StrokeBenchmark::CastRay(Vector3 origin, Vector3 direction, Vector3& outHit, Vector3& outNormal, int& outFacet) {
+	bool hit = false;
+	float nearest = FLT_MAX;
+	for (auto &m : meshes) {
+		std::vector<IntersectResult> hits;
+		if (!m->bvh->IntersectRay(origin, direction, &hits))
+			continue;
+
+		for (auto &h : hits) {
+			if (h.HitDistance >= nearest)
+				continue;
+
+			nearest = h.HitDistance;
+			outHit = h.HitCoord;
+			outFacet = h.HitFacet;
+			m->tris[h.HitFacet].trinormal(m->verts.get(), &outNormal);
+			hit = true;
+		}
+	}
+
+	if (hit)
+		outNormal.Normalize();
+
+	return hit;
+}
+
+int StrokeBenchmark::RecordStroke(const int numDabs) {
+	stroke.clear();
+	if (meshes.empty())
+		return 0;
+
+	Vector3 minBounds(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 maxBounds(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (auto &m : meshes) {
+		for (int i = 0; i < m->nVerts; i++) {
+			Vector3& v = m->verts[i];
+			minBounds.x = std::min(minBounds.x, v.x);
+			minBounds.y = std::min(minBounds.y, v.y);
+			minBounds.z = std::min(minBounds.z, v.z);
+			maxBounds.x = std::max(maxBounds.x, v.x);
+			maxBounds.y = std::max(maxBounds.y, v.y);
+			maxBounds.z = std::max(maxBounds.z, v.z);
+		}
+	}
+
+	// Horizontal line through the middle of the meshes, with the mirrored rays for the X-axis mirror
+	float y = (minBounds.y + maxBounds.y) / 2.0f;
+	float z = maxBounds.z + 1.0f;
+	Vector3 direction(0.0f, 0.0f, -1.0f);
+
+	for (int i = 0; i < numDabs; i++) {
+		float x = minBounds.x + (maxBounds.x - minBounds.x) * (i + 0.5f) / numDabs;
+
+		Dab dab;
+		dab.view = direction * -1.0f;
+		if (!CastRay(Vector3(x, y, z), direction, dab.origin, dab.normal, dab.facet))
+			continue;
+
+		Vector3 mirrorHit;
+		Vector3 mirrorNormal;
+		if (!CastRay(Vector3(-x, y, z), direction, mirrorHit, mirrorNormal, dab.facetM))
+			dab.facetM = -1;
+
+		stroke.push_back(dab);
+	}
+
+	return stroke.size();
+}
+
+bool StrokeBenchmark::LoadStroke(const std::string& fileName) {
+	std::ifstream file(fileName);
+	if (!file.is_open())
+		return false;
+
+	file.imbue(std::locale::classic());
+
+	stroke.clear();
+
+	Dab dab;
+	while (file >> dab.origin.x >> dab.origin.y >> dab.origin.z
+		>> dab.normal.x >> dab.normal.y >> dab.normal.z
+		>> dab.view.x >> dab.view.y >> dab.view.z
+		>> dab.facet >> dab.facetM)
+		stroke.push_back(dab);
+
+	return !stroke.empty();
+}
+
+bool StrokeBenchmark::SaveStroke(const std::string& fileName) {
+	std::ofstream file(fileName);
+	if (!file.is_open())
+		return false;
+
+	file.imbue(std::locale::classic());
+	file.precision(9);
+
+	for (auto &dab : stroke) {
+		file << dab.origin.x << " " << dab.origin.y << " " << dab.origin.z << " "
+			<< dab.normal.x << " " << dab.normal.y << " " << dab.normal.z << " "
+			<< dab.view.x << " " << dab.view.y << " " << dab.view.z << " "
+			<< dab.facet << " " << dab.facetM << "\n";
+	}
+
+	return true;
+}
+
+const StrokeBenchmark::BrushResult& StrokeBenchmark::Run(TweakBrush* brush, const bool mirror) {
+	results.emplace_back();
+	BrushResult& result = results.back();
+	result.brushName = brush->Name();
+	if (mirror)
+		result.brushName += " (Mirrored)";
+
+	if (stroke.empty())
+		return result;
+
+	std::vector<mesh*> refMeshes;
+	for (auto &m : meshes)
+		refMeshes.push_back(m.get());
+
+	// The recorded facets only belong to the mesh that was hit, so the points are found by distance
+	brush->setConnected(false);
+	brush->setMirror(mirror);
+	brush->setSpacing(0.0f);
+
+	auto pickInfo = [](const Dab& dab) {
+		TweakPickInfo tpi;
+		tpi.origin = dab.origin;
+		tpi.normal = dab.normal;
+		tpi.view = dab.view;
+		tpi.facet = dab.facet;
+		tpi.facetM = dab.facetM;
+		return tpi;
+	};
+
+	TweakStroke tweakStroke(refMeshes, brush);
+	TweakPickInfo startPick = pickInfo(stroke.front());
+	tweakStroke.beginStroke(startPick);
+
+	for (auto &dab : stroke) {
+		TweakPickInfo tpi = pickInfo(dab);
+		result.dabTimes.push_back(MeasureMs([&]() { tweakStroke.updateStroke(tpi); }));
+	}
+
+	result.strokeEndMs = MeasureMs([&]() { tweakStroke.endStroke(); });
+
+	for (auto &m : refMeshes)
+		tweakStroke.RestoreStartState(m);
+
+	return result;
+}
+
+bool StrokeBenchmark::WriteReport(const std::string& fileName) {
+	std::ofstream out(fileName, std::ios::binary);
+	if (!out.is_open())
+		return false;
+
+	out.imbue(std::locale::classic());
+	out.setf(std::ios::fixed);
+	out.precision(4);
+
+	unsigned long long totalVerts = 0;
+	unsigned long long totalTris = 0;
+	for (auto &m : meshes) {
+		totalVerts += m->nVerts;
+		totalTris += m->nTris;
+	}
+
+	out << "{\n";
+	out << "\t\"meshes\": " << meshes.size() << ",\n";
+	out << "\t\"vertices\": " << totalVerts << ",\n";
+	out << "\t\"triangles\": " << totalTris << ",\n";
+	out << "\t\"dabs\": " << stroke.size() << ",\n";
+	out << "\t\"brushes\": [";
+
+	for (int i = 0; i < results.size(); i++) {
+		const BrushResult& r = results[i];
+
+		std::vector<double> sorted = r.dabTimes;
+		std::sort(sorted.begin(), sorted.end());
+
+		double totalMs = 0.0;
+		for (auto &t : sorted)
+			totalMs += t;
+
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\n";
+		out << "\t\t\t\"brush\": \"" << r.brushName << "\",\n";
+		out << "\t\t\t\"dabs\": " << sorted.size() << ",\n";
+		out << "\t\t\t\"totalMs\": " << totalMs << ",\n";
+		out << "\t\t\t\"p50Ms\": " << Percentile(sorted, 50.0) << ",\n";
+		out << "\t\t\t\"p90Ms\": " << Percentile(sorted, 90.0) << ",\n";
+		out << "\t\t\t\"p99Ms\": " << Percentile(sorted, 99.0) << ",\n";
+		out << "\t\t\t\"maxMs\": " << (sorted.empty() ? 0.0 : sorted.back()) << ",\n";
+		out << "\t\t\t\"strokeEndMs\": " << r.strokeEndMs << "\n";
+		out << "\t\t}";
+	}
+
+	out << "\n\t]\n";
+	out << "}\n";
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../components/TweakBrush.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Replays one brush stroke over all shapes of a set of NIF files and times every dab of it.
+// The stroke is recorded by casting rays across the meshes and can be saved, so that the same
+// stroke is replayed when comparing versions.
+class StrokeBenchmark {
+public:
+	struct Dab {
+		Vector3 origin;
+		Vector3 normal;
+		Vector3 view;
+		int facet = -1;
+		int facetM = -1;
+	};
+
+	struct BrushResult {
+		std::string brushName;
+		std::vector<double> dabTimes;	// Milliseconds per dab, in stroke order.
+		double strokeEndMs = 0.0;		// Waiting for the normals and refitting after the last dab.
+	};
+
+private:
+	std::vector<std::unique_ptr<mesh>> meshes;
+	std::vector<Dab> stroke;
+	std::vector<BrushResult> results;
+
+	bool CastRay(Vector3 origin, Vector3 direction, Vector3& outHit, Vector3& outNormal, int& outFacet);
+
+public:
+	// Adds every shape of the file as a mesh, set up the same way as for editing in Outfit Studio.
+	// Returns the number of shapes added, or -1 if the file can't be loaded.
+	int AddMeshes(const std::string& nifFile);
+
+	// Records a stroke of up to numDabs dabs across the middle of the meshes, seen from the front.
+	// Returns the number of dabs that hit a mesh.
+	int RecordStroke(const int numDabs);
+
+	bool LoadStroke(const std::string& fileName);
+	bool SaveStroke(const std::string& fileName);
+
+	int GetMeshCount() { return meshes.size(); }
+	int GetDabCount() { return stroke.size(); }
+
+	// Runs the stroke with the brush and puts the meshes back to their state from before the stroke.
+	const BrushResult& Run(TweakBrush* brush, const bool mirror = false);
+
+	bool WriteReport(const std::string& fileName);
+};
@@ -280,7 +280,7 @@ void DiffDataSets::OffsetDiff(const std::string& name, const std::string& target
 		resultIt->second += offset;
 }
 
-void DiffDataSets::ApplyUVDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector2>* inOutResult) {
+void DiffDataSets::ApplyUVDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector2>* inOutResult, std::vector<ushort>* outTouched) {
 	if (percent == 0.0f)
 		return;
 
@@ -296,10 +296,13 @@ void DiffDataSets::ApplyUVDiff(const std::string& set, const std::string& target
 
 		(*inOutResult)[resultIt->first].u += resultIt->second.x * percent;
 		(*inOutResult)[resultIt->first].v += resultIt->second.y * percent;
+
+		if (outTouched)
+			outTouched->push_back(resultIt->first);
 	}
 }
 
-void DiffDataSets::ApplyDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector3>* inOutResult) {
+void DiffDataSets::ApplyDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector3>* inOutResult, std::vector<ushort>* outTouched) {
 	if (percent == 0.0f)
 		return;
 
@@ -316,6 +319,9 @@ void DiffDataSets::ApplyDiff(const std::string& set, const std::string& target,
 		(*inOutResult)[resultIt->first].x += resultIt->second.x * percent;
 		(*inOutResult)[resultIt->first].y += resultIt->second.y * percent;
 		(*inOutResult)[resultIt->first].z += resultIt->second.z * percent;
+
+		if (outTouched)
+			outTouched->push_back(resultIt->first);
 	}
 }
 
@@ -343,6 +349,17 @@ std::unordered_map<ushort, Vector3>* DiffDataSets::GetDiffSet(const std::string&
 	return &namedSet[targetDataName];
 }
 
+std::unordered_map<ushort, Vector3>* DiffDataSets::GetDiffSet(const std::string& set, const std::string& target) {
+	if (!TargetMatch(set, target))
+		return nullptr;
+
+	auto it = namedSet.find(set);
+	if (it == namedSet.end())
+		return nullptr;
+
+	return &it->second;
+}
+
 void DiffDataSets::GetDiffIndices(const std::string& set, const std::string& target, std::vector<ushort>& outIndices, float threshold) {
 	if (!TargetMatch(set, target))
 		return;
@@ -47,10 +47,11 @@ public:
 	void SumDiff(const std::string& name, const std::string& target, ushort index, Vector3& newdiff);
 	void ScaleDiff(const std::string& name, const std::string& target, float scalevalue);
 	void OffsetDiff(const std::string& name, const std::string& target, Vector3 &offset);
-	void ApplyDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector3>* inOutResult);
-	void ApplyUVDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector2>* inOutResult);
+	void ApplyDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector3>* inOutResult, std::vector<ushort>* outTouched = nullptr);
+	void ApplyUVDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector2>* inOutResult, std::vector<ushort>* outTouched = nullptr);
 	void ApplyClamp(const std::string& set, const std::string& target, std::vector<Vector3>* inOutResult);
 	std::unordered_map<ushort, Vector3>* GetDiffSet(const std::string& targetDataName);
+	std::unordered_map<ushort, Vector3>* GetDiffSet(const std::string& set, const std::string& target);
 	void GetDiffIndices(const std::string& set, const std::string& target, std::vector<ushort>& outIndices, float threshold = 0.0f);
 
 	void DeleteVerts(const std::string& target, const std::vector<ushort>& indices);
@@ -6,9 +6,13 @@ See the included LICENSE file
 
 #include "Mesh.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 mesh::mesh() {
 	vbo.resize(4, 0);
-	queueUpdate.resize(vbo.size() + 1, false);
+	queueUpdate.resize(vbo.size() + 1);
 }
 
 mesh::~mesh() {
@@ -28,6 +32,13 @@ std::shared_ptr<AABBTree> mesh::CreateBVH() {
 	return bvh;
 }
 
+void mesh::UpdateBVH() {
+	if (bvh && bvh->IsBuiltFor(verts.get(), tris.get(), nTris))
+		bvh->Refit();
+	else
+		CreateBVH();
+}
+
 void mesh::BuildTriAdjacency() {
 	if (!tris)
 		return;
@@ -86,19 +97,42 @@ void mesh::CreateBuffers() {
 	glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
 	glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector3), verts.get(), GL_DYNAMIC_DRAW);
 
-	if (norms) {
-		glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
-		glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector3), norms.get(), GL_DYNAMIC_DRAW);
-	}
+	if (packedVertices) {
+		std::vector<uint> packed;
+
+		if (norms) {
+			PackAttribute(UpdateType::Normals, 0, nVerts, packed);
+			glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+			glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(uint), packed.data(), GL_DYNAMIC_DRAW);
+		}
+
+		if (vcolors) {
+			PackAttribute(UpdateType::VertexColors, 0, nVerts, packed);
+			glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
+			glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(uint), packed.data(), GL_DYNAMIC_DRAW);
+		}
 
-	if (vcolors) {
-		glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
-		glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector3), vcolors.get(), GL_DYNAMIC_DRAW);
+		if (texcoord) {
+			PackAttribute(UpdateType::TextureCoordinates, 0, nVerts, packed);
+			glBindBuffer(GL_ARRAY_BUFFER, vbo[3]);
+			glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(uint), packed.data(), GL_DYNAMIC_DRAW);
+		}
 	}
+	else {
+		if (norms) {
+			glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+			glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector3), norms.get(), GL_DYNAMIC_DRAW);
+		}
 
-	if (texcoord) {
-		glBindBuffer(GL_ARRAY_BUFFER, vbo[3]);
-		glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector2), texcoord.get(), GL_DYNAMIC_DRAW);
+		if (vcolors) {
+			glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
+			glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector3), vcolors.get(), GL_DYNAMIC_DRAW);
+		}
+
+		if (texcoord) {
+			glBindBuffer(GL_ARRAY_BUFFER, vbo[3]);
+			glBufferData(GL_ARRAY_BUFFER, nVerts * sizeof(Vector2), texcoord.get(), GL_DYNAMIC_DRAW);
+		}
 	}
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -119,48 +153,181 @@ void mesh::CreateBuffers() {
 	genBuffers = true;
 }
 
+// Calls func(start, end) for every dirty range of an array with count elements
+template<typename Func>
+static void ForEachDirtyRange(const DirtyRanges& dirty, int count, Func func) {
+	if (dirty.IsAll()) {
+		if (count > 0)
+			func(0, count);
+		return;
+	}
+
+	for (auto &r : dirty.GetRanges()) {
+		int start = std::max(r.start, 0);
+		int end = std::min(r.end, count);
+		if (end > start)
+			func(start, end);
+	}
+}
+
+// Uploads the dirty parts of an array to the currently bound buffer
+static void UploadDirtyRanges(GLenum target, DirtyRanges& dirty, const void* data, int count, size_t stride) {
+	const char* bytes = static_cast<const char*>(data);
+	ForEachDirtyRange(dirty, count, [&](int start, int end) {
+		glBufferSubData(target, start * stride, (end - start) * stride, bytes + start * stride);
+	});
+
+	dirty.Clear();
+}
+
+static uint PackNormal(const Vector3& n) {
+	auto snorm10 = [](float v) -> uint {
+		v = std::max(-1.0f, std::min(1.0f, v));
+		return static_cast<uint>(static_cast<int>(std::round(v * 511.0f))) & 0x3FF;
+	};
+
+	return snorm10(n.x) | (snorm10(n.y) << 10) | (snorm10(n.z) << 20);
+}
+
+static uint PackColor(const Vector3& c) {
+	auto unorm8 = [](float v) -> uint {
+		v = std::max(0.0f, std::min(1.0f, v));
+		uint q = static_cast<uint>(std::round(v * 255.0f));
+
+		// Shaders test mask and weight values against zero, keep tiny values visible
+		if (q == 0 && v > 0.0f)
+			q = 1;
+
+		return q;
+	};
+
+	return unorm8(c.x) | (unorm8(c.y) << 8) | (unorm8(c.z) << 16) | (0xFFu << 24);
+}
+
+static ushort FloatToHalf(float value) {
+	uint bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint sign = (bits >> 16) & 0x8000;
+	int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+	uint mantissa = bits & 0x7FFFFF;
+
+	// NaN and infinity
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+	// Overflow
+	if (exponent >= 31)
+		return sign | 0x7C00;
+
+	// Subnormal or zero
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return sign;
+
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint half = mantissa >> shift;
+		uint rest = mantissa & ((1u << shift) - 1);
+		uint halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+
+		return sign | half;
+	}
+
+	// Round to nearest even, a carry into the exponent is still correct
+	uint half = sign | (exponent << 10) | (mantissa >> 13);
+	if ((mantissa & 0x1000) && (mantissa & 0x2FFF))
+		half++;
+
+	return half;
+}
+
+void mesh::PackAttribute(const UpdateType& type, int start, int end, std::vector<uint>& outPacked) {
+	outPacked.resize(end - start);
+
+	switch (type) {
+	case UpdateType::Normals:
+		for (int i = start; i < end; i++)
+			outPacked[i - start] = PackNormal(norms[i]);
+		break;
+	case UpdateType::VertexColors:
+		for (int i = start; i < end; i++)
+			outPacked[i - start] = PackColor(vcolors[i]);
+		break;
+	case UpdateType::TextureCoordinates:
+		for (int i = start; i < end; i++)
+			outPacked[i - start] = FloatToHalf(texcoord[i].u) | (static_cast<uint>(FloatToHalf(texcoord[i].v)) << 16);
+		break;
+	default:
+		outPacked.clear();
+		break;
+	}
+}
+
 void mesh::UpdateBuffers() {
 	if (genBuffers) {
+		std::lock_guard<std::mutex> lock(queueMutex);
 		glBindVertexArray(vao);
 
-		if (queueUpdate[UpdateType::Position]) {
+		if (queueUpdate[UpdateType::Position].IsDirty()) {
 			glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::Position]);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, nVerts * sizeof(Vector3), verts.get());
-			queueUpdate[UpdateType::Position] = false;
+			UploadDirtyRanges(GL_ARRAY_BUFFER, queueUpdate[UpdateType::Position], verts.get(), nVerts, sizeof(Vector3));
 		}
 
-		if (norms && queueUpdate[UpdateType::Normals]) {
-			glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::Normals]);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, nVerts * sizeof(Vector3), norms.get());
-			queueUpdate[UpdateType::Normals] = false;
-		}
+		if (packedVertices) {
+			std::vector<uint> packed;
+			for (auto type : { UpdateType::Normals, UpdateType::VertexColors, UpdateType::TextureCoordinates }) {
+				DirtyRanges& dirty = queueUpdate[type];
+				if (!dirty.IsDirty())
+					continue;
 
-		if (vcolors && queueUpdate[UpdateType::VertexColors]) {
-			glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::VertexColors]);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, nVerts * sizeof(Vector3), vcolors.get());
-			queueUpdate[UpdateType::VertexColors] = false;
+				bool hasData = (type == UpdateType::Normals && norms) ||
+					(type == UpdateType::VertexColors && vcolors) ||
+					(type == UpdateType::TextureCoordinates && texcoord);
+
+				if (hasData) {
+					glBindBuffer(GL_ARRAY_BUFFER, vbo[type]);
+					ForEachDirtyRange(dirty, nVerts, [&](int start, int end) {
+						PackAttribute(type, start, end, packed);
+						glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(uint), (end - start) * sizeof(uint), packed.data());
+					});
+					dirty.Clear();
+				}
+			}
 		}
+		else {
+			if (norms && queueUpdate[UpdateType::Normals].IsDirty()) {
+				glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::Normals]);
+				UploadDirtyRanges(GL_ARRAY_BUFFER, queueUpdate[UpdateType::Normals], norms.get(), nVerts, sizeof(Vector3));
+			}
+
+			if (vcolors && queueUpdate[UpdateType::VertexColors].IsDirty()) {
+				glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::VertexColors]);
+				UploadDirtyRanges(GL_ARRAY_BUFFER, queueUpdate[UpdateType::VertexColors], vcolors.get(), nVerts, sizeof(Vector3));
+			}
 
-		if (texcoord && queueUpdate[UpdateType::TextureCoordinates]) {
-			glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::TextureCoordinates]);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, nVerts * sizeof(Vector2), texcoord.get());
-			queueUpdate[UpdateType::TextureCoordinates] = false;
+			if (texcoord && queueUpdate[UpdateType::TextureCoordinates].IsDirty()) {
+				glBindBuffer(GL_ARRAY_BUFFER, vbo[UpdateType::TextureCoordinates]);
+				UploadDirtyRanges(GL_ARRAY_BUFFER, queueUpdate[UpdateType::TextureCoordinates], texcoord.get(), nVerts, sizeof(Vector2));
+			}
 		}
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		if (queueUpdate[UpdateType::Indices]) {
+		if (queueUpdate[UpdateType::Indices].IsDirty()) {
 			if (tris) {
 				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-				glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, nTris * sizeof(Triangle), tris.get());
+				UploadDirtyRanges(GL_ELEMENT_ARRAY_BUFFER, queueUpdate[UpdateType::Indices], tris.get(), nTris, sizeof(Triangle));
 				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 			}
 			else if (edges) {
 				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-				glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, nEdges * sizeof(Edge), edges.get());
+				UploadDirtyRanges(GL_ELEMENT_ARRAY_BUFFER, queueUpdate[UpdateType::Indices], edges.get(), nEdges, sizeof(Edge));
 				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 			}
-			queueUpdate[UpdateType::Indices] = false;
+			queueUpdate[UpdateType::Indices].Clear();
 		}
 
 		glBindVertexArray(0);
@@ -168,7 +335,29 @@ void mesh::UpdateBuffers() {
 }
 
 void mesh::QueueUpdate(const UpdateType& type) {
-	queueUpdate[type] = true;
+	std::lock_guard<std::mutex> lock(queueMutex);
+	queueUpdate[type].AddAll();
+}
+
+void mesh::QueueUpdate(const UpdateType& type, int index) {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	queueUpdate[type].Add(index);
+}
+
+void mesh::QueueUpdate(const UpdateType& type, int start, int end) {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	queueUpdate[type].Add(start, end);
+}
+
+void mesh::QueueUpdate(const UpdateType& type, const int* points, int nPoints) {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (!points) {
+		queueUpdate[type].AddAll();
+		return;
+	}
+
+	for (int i = 0; i < nPoints; i++)
+		queueUpdate[type].Add(points[i]);
 }
 
 void mesh::UpdateFromMaterialFile(const MaterialFile& matFile) {
@@ -193,7 +382,7 @@ void mesh::ScaleVertices(const Vector3& center, const float& factor) {
 		verts[i] = center + (verts[i] - center) * factor;
 
 	CreateBVH();
-	queueUpdate[UpdateType::Position] = true;
+	QueueUpdate(UpdateType::Position);
 }
 
 void mesh::GetAdjacentPoints(int querypoint, std::set<int>& outPoints) {
@@ -397,7 +586,111 @@ void mesh::SmoothNormals(const std::set<int>& vertices) {
 		}
 	}
 
-	queueUpdate[UpdateType::Normals] = true;
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (vertices.empty()) {
+		queueUpdate[UpdateType::Normals].AddAll();
+	}
+	else {
+		for (auto &v : vertices)
+			queueUpdate[UpdateType::Normals].Add(v);
+	}
+}
+
+void mesh::BuildSeamGroups() {
+	seamGroups.clear();
+	seamGroupOf.assign(nVerts, -1);
+
+	// Every match pairs a vertex with the first one in the same position
+	kd_matcher matcher(verts.get(), nVerts);
+	for (int i = 0; i < matcher.matches.size(); i++) {
+		int a = matcher.matches[i].first.second;
+		int b = matcher.matches[i].second.second;
+
+		if (seamGroupOf[b] == -1) {
+			seamGroupOf[b] = seamGroups.size();
+			seamGroups.emplace_back();
+		}
+
+		seamGroupOf[a] = seamGroupOf[b];
+		seamGroups[seamGroupOf[b]].emplace_back(a, b);
+	}
+}
+
+void mesh::SmoothNormalsLocal(const std::vector<int>& vertices) {
+	if (!vertTris) {
+		SmoothNormals(std::set<int>(vertices.begin(), vertices.end()));
+		return;
+	}
+
+	if (smoothSeamNormals && seamGroupOf.size() != nVerts)
+		BuildSeamGroups();
+
+	BeginVisit();
+
+	std::vector<int> affected;
+	for (auto &v : vertices)
+		if (v >= 0 && v < nVerts && VisitPoint(v))
+			affected.push_back(v);
+
+	// Moving a vertex changes the faces of its one-ring
+	auto vtris = vertTris.get();
+	int nMoved = affected.size();
+	for (int i = 0; i < nMoved; i++) {
+		for (auto &t : vtris[affected[i]]) {
+			for (int p : { tris[t].p1, tris[t].p2, tris[t].p3 })
+				if (VisitPoint(p))
+					affected.push_back(p);
+		}
+	}
+
+	// Seams are smoothed as a whole group
+	std::vector<int> groups;
+	if (smoothSeamNormals) {
+		for (auto &v : affected)
+			if (seamGroupOf[v] != -1)
+				groups.push_back(seamGroupOf[v]);
+
+		std::sort(groups.begin(), groups.end());
+		groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+
+		for (auto &g : groups) {
+			for (auto &match : seamGroups[g]) {
+				if (VisitPoint(match.first))
+					affected.push_back(match.first);
+				if (VisitPoint(match.second))
+					affected.push_back(match.second);
+			}
+		}
+	}
+
+	// Face normals, summed in the same order as SmoothNormals does
+	Vector3 tn;
+	for (auto &v : affected) {
+		Vector3& pn = norms[v];
+		pn.Zero();
+		for (auto &t : vtris[v]) {
+			tris[t].trinormal(verts.get(), &tn);
+			pn += tn;
+		}
+		pn.Normalize();
+	}
+
+	for (auto &g : groups) {
+		for (auto &match : seamGroups[g]) {
+			Vector3& an = norms[match.first];
+			Vector3& bn = norms[match.second];
+			if (an.angle(bn) < smoothThresh) {
+				Vector3 anT = an;
+				an += bn;
+				bn += anT;
+			}
+		}
+	}
+
+	for (auto &v : affected)
+		norms[v].Normalize();
+
+	QueueUpdate(UpdateType::Normals, affected.data(), affected.size());
 }
 
 void mesh::FacetNormals() {
@@ -423,14 +716,14 @@ void mesh::FacetNormals() {
 		pn.Normalize();
 	}
 
-	queueUpdate[UpdateType::Normals] = true;
+	QueueUpdate(UpdateType::Normals);
 }
 
 void mesh::ColorFill(const Vector3& vcolor) {
 	for (int i = 0; i < nVerts; i++)
 		vcolors[i] = vcolor;
 
-	queueUpdate[UpdateType::VertexColors] = true;
+	QueueUpdate(UpdateType::VertexColors);
 }
 
 void mesh::ColorChannelFill(int channel, float value) {
@@ -443,10 +736,24 @@ void mesh::ColorChannelFill(int channel, float value) {
 			vcolors[i].z = value;
 	}
 
-	queueUpdate[UpdateType::VertexColors] = true;
+	QueueUpdate(UpdateType::VertexColors);
 }
 
-bool mesh::ConnectedPointsInSphere(Vector3 center, float sqradius, int startTri, bool* trivisit, bool* pointvisit, int outPoints[], int& nOutPoints, std::vector<int>& outFacets) {
+void mesh::BeginVisit() {
+	if (visitScratch.pointMarks.size() < (size_t)nVerts)
+		visitScratch.pointMarks.resize(nVerts, 0);
+	if (visitScratch.triMarks.size() < (size_t)nTris)
+		visitScratch.triMarks.resize(nTris, 0);
+
+	// Clear the marks only when the generation wraps around
+	if (++visitScratch.generation == 0) {
+		std::fill(visitScratch.pointMarks.begin(), visitScratch.pointMarks.end(), 0);
+		std::fill(visitScratch.triMarks.begin(), visitScratch.triMarks.end(), 0);
+		visitScratch.generation = 1;
+	}
+}
+
+bool mesh::ConnectedPointsInSphere(Vector3 center, float sqradius, int startTri, int outPoints[], int& nOutPoints, std::vector<int>& outFacets) {
 	if (!vertTris)
 		return false;
 	if (!vertEdges)
@@ -454,141 +761,38 @@ bool mesh::ConnectedPointsInSphere(Vector3 center, float sqradius, int startTri,
 	if (startTri < 0)
 		return false;
 
+	BeginVisit();
+	VisitTri(startTri);
 	outFacets.push_back(startTri);
 
-	if (trivisit)
-		trivisit[startTri] = true;
-
-	if (verts[tris[startTri].p1].DistanceSquaredTo(center) <= sqradius) {
-		outPoints[nOutPoints++] = tris[startTri].p1;
-		pointvisit[tris[startTri].p1] = true;
-		auto wv = weldVerts.find(tris[startTri].p1);
-		if (wv != weldVerts.end()) {
-			for (auto &w : wv->second) {
-				if (pointvisit[w])
-					continue;
-				outPoints[nOutPoints++] = w;
-				pointvisit[w] = true;
-			}
-		}
-	}
+	const Triangle& t = tris[startTri];
+	for (int p : { t.p1, t.p2, t.p3 }) {
+		if (verts[p].DistanceSquaredTo(center) > sqradius)
+			continue;
 
-	if (verts[tris[startTri].p2].DistanceSquaredTo(center) <= sqradius) {
-		outPoints[nOutPoints++] = tris[startTri].p2;
-		pointvisit[tris[startTri].p2] = true;
-		auto wv = weldVerts.find(tris[startTri].p2);
-		if (wv != weldVerts.end()) {
-			for (auto &w : wv->second) {
-				if (pointvisit[w])
-					continue;
-				outPoints[nOutPoints++] = w;
-				pointvisit[w] = true;
-			}
-		}
-	}
+		if (VisitPoint(p))
+			outPoints[nOutPoints++] = p;
 
-	if (verts[tris[startTri].p3].DistanceSquaredTo(center) <= sqradius) {
-		outPoints[nOutPoints++] = tris[startTri].p3;
-		pointvisit[tris[startTri].p3] = true;
-		auto wv = weldVerts.find(tris[startTri].p3);
+		auto wv = weldVerts.find(p);
 		if (wv != weldVerts.end()) {
-			for (auto &w : wv->second) {
-				if (pointvisit[w])
-					continue;
-				outPoints[nOutPoints++] = w;
-				pointvisit[w] = true;
-			}
+			for (auto &w : wv->second)
+				if (VisitPoint(w))
+					outPoints[nOutPoints++] = w;
 		}
 	}
 
+	// The output doubles as the queue of points whose neighbors are still to be checked
 	int adjCursor = 0;
 	while (adjCursor < nOutPoints) {
 		int pointBuf[100];
 		int tp = outPoints[adjCursor++];
 		int n = GetAdjacentPoints(tp, pointBuf, 100);
 		for (int i = 0; i < n; i++) {
-			if (!pointvisit[pointBuf[i]] && verts[pointBuf[i]].DistanceSquaredTo(center) <= sqradius) {
-				pointvisit[pointBuf[i]] = true;
+			if (!IsPointVisited(pointBuf[i]) && verts[pointBuf[i]].DistanceSquaredTo(center) <= sqradius) {
+				VisitPoint(pointBuf[i]);
 				outPoints[nOutPoints++] = pointBuf[i];
 			}
 		}
 	}
 	return true;
 }
-
-bool mesh::ConnectedPointsInSphere2(Vector3 center, float sqradius, int startTri, bool* trivisit, bool* pointvisit, int outPoints[], int& nOutPoints, std::vector<int>& outFacets) {
-	if (!vertTris)
-		return false;
-	if (startTri < 0)
-		return false;
-
-	outFacets.push_back(startTri);
-	trivisit[startTri] = true;
-
-	auto vtris = vertTris.get();
-	if (verts[tris[startTri].p1].DistanceSquaredTo(center) <= sqradius) {
-		if (!pointvisit[tris[startTri].p1]) {
-			pointvisit[tris[startTri].p1] = true;
-			outPoints[nOutPoints++] = tris[startTri].p1;
-		}
-		for (auto &t : vtris[tris[startTri].p1]) {
-			if (trivisit[t])
-				continue;
-			ConnectedPointsInSphere(center, sqradius, t, trivisit, pointvisit, outPoints, nOutPoints, outFacets);
-		}
-		auto wv = weldVerts.find(tris[startTri].p1);
-		if (wv != weldVerts.end()) {
-			for (auto &w : wv->second) {
-				for (auto &t : vtris[w]) {
-					if (trivisit[t])
-						continue;
-					ConnectedPointsInSphere(center, sqradius, t, trivisit, pointvisit, outPoints, nOutPoints, outFacets);
-				}
-			}
-		}
-	}
-
-	if (verts[tris[startTri].p2].DistanceSquaredTo(center) <= sqradius) {
-		if (!pointvisit[tris[startTri].p2]) {
-			pointvisit[tris[startTri].p2] = true;
-			outPoints[nOutPoints++] = tris[startTri].p2;
-		}		
-		for (auto &t : vtris[tris[startTri].p2]) {
-			if (trivisit[t])
-				continue;
-			ConnectedPointsInSphere(center, sqradius, t, trivisit, pointvisit, outPoints, nOutPoints, outFacets);
-		}
-		auto wv = weldVerts.find(tris[startTri].p2);
-		if (wv != weldVerts.end()) {
-			for (auto &w : wv->second) {
-				for (auto &t : vtris[w]) {
-					if (trivisit[t])
-						continue;
-					ConnectedPointsInSphere(center, sqradius, t, trivisit, pointvisit, outPoints, nOutPoints, outFacets);
-				}
-			}
-		}
-	}
-	if (verts[tris[startTri].p3].DistanceSquaredTo(center) <= sqradius) {
-		if (!pointvisit[tris[startTri].p3]) {
-			pointvisit[tris[startTri].p3] = true;
-			outPoints[nOutPoints++] = tris[startTri].p3;
-		}
-		for (auto &t : vtris[tris[startTri].p3]) {
-			if (trivisit[t])
-				continue;
-			ConnectedPointsInSphere(center, sqradius, t, trivisit, pointvisit, outPoints, nOutPoints, outFacets);
-		}
-		auto wv = weldVerts.find(tris[startTri].p3);
-		if (wv != weldVerts.end()) {
-			for (auto &w : wv->second) {
-				for (auto &t : vtris[w]) {
-					if (trivisit[t])
-						continue;
-					ConnectedPointsInSphere(center, sqradius, t, trivisit, pointvisit, outPoints, nOutPoints, outFacets);
-				}
-			}
-		}
-	}
-	return true;
-}
@@ -8,6 +8,7 @@ See the included LICENSE file
 
 #include "../NIF/utils/KDMatcher.h"
 #include "../utils/AABBTree.h"
+#include "../utils/DirtyRanges.h"
 #include "../render/GLExtensions.h"
 #include "../files/MaterialFile.h"
 
@@ -15,6 +16,7 @@ See the included LICENSE file
 #include <unordered_set>
 #include <set>
 #include <memory>
+#include <mutex>
 
 enum RenderMode {
 	Normal,
@@ -28,7 +30,23 @@ class GLMaterial;
 
 class mesh {
 private:
-	std::vector<bool> queueUpdate;
+	std::vector<DirtyRanges> queueUpdate;
+	std::mutex queueMutex;	// Normals are smoothed in async tasks while the main thread uploads the queued ranges
+
+	// Visit marks reused by every query on the mesh. A point or triangle counts as visited when its mark
+	// equals the current generation, so starting a new query doesn't need to clear anything.
+	struct VisitScratch {
+		std::vector<uint> pointMarks;
+		std::vector<uint> triMarks;
+		uint generation = 0;
+	} visitScratch;
+
+	// Seam matches of SmoothNormalsLocal, grouped by the vertex the other positions matched with.
+	// Matched once, in the order of the kd matcher, so replaying a group gives the result of SmoothNormals.
+	std::vector<std::vector<std::pair<int, int>>> seamGroups;
+	std::vector<int> seamGroupOf;	// Seam group of each vertex, -1 if it has none
+
+	void BuildSeamGroups();
 
 public:
 	enum UpdateType {
@@ -64,6 +82,7 @@ public:
 	int nEdges = 0;
 
 	bool genBuffers = false;
+	bool packedVertices = false;					// Normals, colors and texture coordinates are uploaded in packed formats.
 	GLuint vao = 0;
 	std::vector<GLuint> vbo;
 	GLuint ibo = 0;
@@ -104,6 +123,9 @@ public:
 	// Creates a new bvh tree for the mesh.
 	std::shared_ptr<AABBTree> CreateBVH();
 
+	// Refits the bvh tree to moved vertices, only rebuilding it if the geometry changed.
+	void UpdateBVH();
+
 	void MakeEdges();			// Creates the list of edges from the list of triangles.
 
 	void BuildTriAdjacency();	// Triangle adjacency optional to reduce overhead when it's not needed.
@@ -111,7 +133,15 @@ public:
 
 	void CreateBuffers();
 	void UpdateBuffers();
+
+	// Packs normals (10_10_10_2), colors (RGBA8) or texture coordinates (2x half) of the vertices [start, end).
+	// GL normalizes the packed values, so the shaders read the same vec3/vec2 inputs as with floats.
+	// They renormalize the normal, as 10 bits per component don't keep its length exactly.
+	void PackAttribute(const UpdateType& type, int start, int end, std::vector<uint>& outPacked);
 	void QueueUpdate(const UpdateType& type);
+	void QueueUpdate(const UpdateType& type, int index);
+	void QueueUpdate(const UpdateType& type, int start, int end);
+	void QueueUpdate(const UpdateType& type, const int* points, int nPoints);
 	void UpdateFromMaterialFile(const MaterialFile& matFile);
 
 	void ScaleVertices(const Vector3& center, const float& factor);
@@ -121,6 +151,10 @@ public:
 
 	void FacetNormals();
 	void SmoothNormals(const std::set<int>& vertices = std::set<int>());
+	// Recalculates the normals changed by moving only the given vertices, which are theirs, those of their
+	// one-ring and of the seam vertices matching either. Requires the tri adjacency, the cost follows the
+	// number of vertices rather than the mesh size. Seams are matched on the first call and kept after that.
+	void SmoothNormalsLocal(const std::vector<int>& vertices);
 	static void SmoothNormalsStatic(mesh* m) {
 		m->SmoothNormals();
 	}
@@ -140,14 +174,32 @@ public:
 	}
 
 
-	// Retrieve connected points in a sphere's radius (squared, requires tri adjacency to be set up).
-	// Also requires pointvisit to be allocated by the caller.
-	// Recursive - large query will overflow the stack!
-	bool ConnectedPointsInSphere(Vector3 center, float sqradius, int startTri, bool* trivisit, bool* pointvisit, int outPoints[], int& nOutPoints, std::vector<int>& outFacets);
+	// Starts a new query on the visit marks, after which no point or triangle is visited.
+	void BeginVisit();
+	// Marks the point as visited. Returns false if it already was visited in the current query.
+	bool VisitPoint(int point) {
+		uint& mark = visitScratch.pointMarks[point];
+		if (mark == visitScratch.generation)
+			return false;
+		mark = visitScratch.generation;
+		return true;
+	}
+	bool IsPointVisited(int point) {
+		return visitScratch.pointMarks[point] == visitScratch.generation;
+	}
+	// Marks the triangle as visited. Returns false if it already was visited in the current query.
+	bool VisitTri(int tri) {
+		uint& mark = visitScratch.triMarks[tri];
+		if (mark == visitScratch.generation)
+			return false;
+		mark = visitScratch.generation;
+		return true;
+	}
 
-	// Similar to above, but uses an edge list to determine adjacency, with less risk of stack problems.
-	// Also requires trivisit and pointvisit to be allocated by the caller.
-	bool ConnectedPointsInSphere2(Vector3 center, float sqradius, int startTri, bool* trivisit, bool* pointvisit, int outPoints[], int& nOutPoints, std::vector<int>& outFacets);
+	// Retrieve connected points in a sphere's radius (squared, requires tri adjacency and the edge list to be set up).
+	// Starts at the points of startTri and walks the edges between points inside the sphere.
+	// Begins a new visit query, the visit marks of the results stay set until the next one.
+	bool ConnectedPointsInSphere(Vector3 center, float sqradius, int startTri, int outPoints[], int& nOutPoints, std::vector<int>& outFacets);
 
 	// Convenience function to gather connected points, taking into account "welded" vertices.
 	// Optionally sorts the results by distance. Does not clear the output set.
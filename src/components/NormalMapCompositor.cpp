@@ -0,0 +1,529 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "NormalMapCompositor.h"
+#include "../NIF/NifFile.h"
+
+#include <wx/filename.h>
+#include <wx/image.h>
+#include <wx/log.h>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef WIN64
+#include <ppl.h>
+#else
+#undef _PPL_H
+#endif
+
+static int WrapIndex(int i, const int n) {
+	i %= n;
+	return i < 0 ? i + n : i;
+}
+
+// Linear filtering with wrapping, like sampling the texture in the preview shader
+static void SampleLinear(const NormalMapCompositor::Image& image, const float u, const float v, float outColor[3]) {
+	float fx = u * image.width - 0.5f;
+	float fy = v * image.height - 0.5f;
+	float floorX = std::floor(fx);
+	float floorY = std::floor(fy);
+	float ax = fx - floorX;
+	float ay = fy - floorY;
+
+	int x0 = (int)floorX;
+	int y0 = (int)floorY;
+	int x1 = x0 + 1;
+	int y1 = y0 + 1;
+	if (x0 < 0 || x1 >= image.width) {
+		x0 = WrapIndex(x0, image.width);
+		x1 = WrapIndex(x1, image.width);
+	}
+	if (y0 < 0 || y1 >= image.height) {
+		y0 = WrapIndex(y0, image.height);
+		y1 = WrapIndex(y1, image.height);
+	}
+
+	const unsigned char* p00 = &image.pixels[(y0 * image.width + x0) * 3];
+	const unsigned char* p10 = &image.pixels[(y0 * image.width + x1) * 3];
+	const unsigned char* p01 = &image.pixels[(y1 * image.width + x0) * 3];
+	const unsigned char* p11 = &image.pixels[(y1 * image.width + x1) * 3];
+
+	for (int c = 0; c < 3; c++) {
+		float top = p00[c] + (p10[c] - p00[c]) * ax;
+		float bottom = p01[c] + (p11[c] - p01[c]) * ax;
+		outColor[c] = top + (bottom - top) * ay;
+	}
+}
+
+// Samples a layer image for an output texel. Unscaled images are placed 1:1 at the offset and don't repeat.
+static bool SampleLayer(const NormalMapCompositor::Image& image, const NormalGenLayer& layer, const int resolution,
+	const int x, const int y, const int xOffset, const int yOffset, float outColor[3]) {
+	if (layer.scaleToResolution) {
+		float u = (x + 0.5f - xOffset) / resolution;
+		float v = (y + 0.5f - yOffset) / resolution;
+		SampleLinear(image, u, v, outColor);
+		return true;
+	}
+
+	int sx = x - xOffset;
+	int sy = y - yOffset;
+	if (sx < 0 || sy < 0 || sx >= image.width || sy >= image.height)
+		return false;
+
+	const unsigned char* p = &image.pixels[(sy * image.width + sx) * 3];
+	outColor[0] = p[0];
+	outColor[1] = p[1];
+	outColor[2] = p[2];
+	return true;
+}
+
+static void ApplyChannelOptions(const NormalGenLayer& layer, float color[3]) {
+	if (layer.swapRG)
+		std::swap(color[0], color[1]);
+	if (layer.invertRed)
+		color[0] = 255.0f - color[0];
+	if (layer.invertGreen)
+		color[1] = 255.0f - color[1];
+	if (layer.invertBlue)
+		color[2] = 255.0f - color[2];
+}
+
+// Model space normal of a layer color. Tangent space colors perturb the base normal in the cotangent frame
+// of the triangle, see perturb_normal in normalshade.frag.
+static Vector3 DecodeNormal(const NormalGenLayer& layer, const float color[3], const Vector3& base, const Vector3& dPdu, const Vector3& dPdv) {
+	Vector3 n;
+	if (layer.isTangentSpace) {
+		Vector3 t = base.cross(dPdv);
+		Vector3 b = dPdu.cross(base);
+		float maxLenSq = std::max(t.dot(t), b.dot(b));
+		if (maxLenSq > 0.0f) {
+			float invMax = 1.0f / std::sqrt(maxLenSq);
+			t *= invMax;
+			b *= invMax;
+		}
+
+		float mx = (color[0] - 128.0f) / 127.0f;
+		float my = (color[1] - 128.0f) / 127.0f;
+		float mz = (color[2] - 128.0f) / 127.0f;
+		n = t * mx + b * my + base * mz;
+	}
+	else {
+		n.x = color[0] / 255.0f * 2.0f - 1.0f;
+		n.y = color[1] / 255.0f * 2.0f - 1.0f;
+		n.z = color[2] / 255.0f * 2.0f - 1.0f;
+	}
+
+	n.Normalize();
+
+	if (!layer.isTangentSpace)
+		n.x = -n.x;
+
+	return n;
+}
+
+static unsigned char EncodeChannel(const float value) {
+	float c = value * 255.0f + 0.5f;
+	return (unsigned char)std::max(0.0f, std::min(255.0f, c));
+}
+
+NormalMapCompositor::NormalMapCompositor(const std::vector<NormalGenLayer>& layers) {
+	this->layers = layers;
+
+	for (auto &l : this->layers) {
+		if (l.IsBackground() && l.resolution > 0) {
+			resolution = l.resolution;
+			break;
+		}
+	}
+}
+
+void NormalMapCompositor::AddMesh(mesh* m) {
+	meshes.push_back(m);
+}
+
+int NormalMapCompositor::AddMeshes(NifFile& nif, const std::vector<std::string>& shapes) {
+	int added = 0;
+	for (auto &s : shapes) {
+		std::vector<Vector3> nifVerts;
+		std::vector<Triangle> nifTris;
+		nif.GetVertsForShape(s, nifVerts);
+		nif.GetTrisForShape(s, &nifTris);
+
+		const std::vector<Vector3>* nifNorms = nif.GetNormalsForShape(s, false);
+		const std::vector<Vector2>* nifUvs = nif.GetUvsForShape(s);
+		if (nifVerts.empty() || nifTris.empty() || !nifUvs || nifUvs->size() != nifVerts.size())
+			continue;
+
+		auto m = std::make_unique<mesh>();
+		m->shapeName = s;
+		m->nVerts = nifVerts.size();
+		m->nTris = nifTris.size();
+		m->verts = std::make_unique<Vector3[]>(m->nVerts);
+		m->norms = std::make_unique<Vector3[]>(m->nVerts);
+		m->texcoord = std::make_unique<Vector2[]>(m->nVerts);
+		m->tris = std::make_unique<Triangle[]>(m->nTris);
+
+		// Same conversion to the editor space as in GLSurface::AddMeshFromNif
+		for (int i = 0; i < m->nVerts; i++) {
+			m->verts[i].x = nifVerts[i].x / -10.0f;
+			m->verts[i].z = nifVerts[i].y / 10.0f;
+			m->verts[i].y = nifVerts[i].z / 10.0f;
+			m->texcoord[i] = (*nifUvs)[i];
+		}
+
+		for (int t = 0; t < m->nTris; t++)
+			m->tris[t] = nifTris[t];
+
+		if (nifNorms && nifNorms->size() == nifVerts.size()) {
+			for (int i = 0; i < m->nVerts; i++) {
+				m->norms[i].x = -(*nifNorms)[i].x;
+				m->norms[i].z = (*nifNorms)[i].y;
+				m->norms[i].y = (*nifNorms)[i].z;
+			}
+		}
+		else
+			m->FacetNormals();
+
+		meshes.push_back(m.get());
+		ownedMeshes.push_back(std::move(m));
+		added++;
+	}
+
+	return added;
+}
+
+void NormalMapCompositor::ShadeTile(const int tileX, const int tileY, const std::vector<TriRef>& bin, const std::vector<std::vector<TriFrame>>& frames,
+	const std::vector<LayerImages>& images, TileScratch& scratch, std::vector<unsigned char>& coverage) {
+	int x0 = tileX * TileSize;
+	int y0 = tileY * TileSize;
+	int x1 = std::min(x0 + TileSize, resolution);
+	int y1 = std::min(y0 + TileSize, resolution);
+
+	// The last triangle drawn wins, like the depth-less render of the preview
+	std::vector<int>& texelTri = scratch.texelTri;
+	std::vector<float>& texelBary = scratch.texelBary;
+	texelTri.assign(TileSize * TileSize, -1);
+	texelBary.resize(TileSize * TileSize * 3);
+
+	for (int b = 0; b < bin.size(); b++) {
+		mesh* m = meshes[bin[b].mesh];
+		const Triangle& t = m->tris[bin[b].tri];
+		float ax = m->texcoord[t.p1].u * resolution;
+		float ay = m->texcoord[t.p1].v * resolution;
+		float bx = m->texcoord[t.p2].u * resolution;
+		float by = m->texcoord[t.p2].v * resolution;
+		float cx = m->texcoord[t.p3].u * resolution;
+		float cy = m->texcoord[t.p3].v * resolution;
+
+		float area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+		if (area == 0.0f)
+			continue;
+
+		// Texels whose centers are inside of the bounds
+		int minX = std::max(x0, (int)std::ceil(std::min(ax, std::min(bx, cx)) - 0.5f));
+		int minY = std::max(y0, (int)std::ceil(std::min(ay, std::min(by, cy)) - 0.5f));
+		int maxX = std::min(x1 - 1, (int)std::floor(std::max(ax, std::max(bx, cx)) - 0.5f));
+		int maxY = std::min(y1 - 1, (int)std::floor(std::max(ay, std::max(by, cy)) - 0.5f));
+
+		float invArea = 1.0f / area;
+		for (int y = minY; y <= maxY; y++) {
+			float py = y + 0.5f;
+			for (int x = minX; x <= maxX; x++) {
+				float px = x + 0.5f;
+				float l0 = ((cx - bx) * (py - by) - (cy - by) * (px - bx)) * invArea;
+				float l1 = ((ax - cx) * (py - cy) - (ay - cy) * (px - cx)) * invArea;
+				float l2 = 1.0f - l0 - l1;
+				if (l0 < 0.0f || l1 < 0.0f || l2 < 0.0f)
+					continue;
+
+				int i = (y - y0) * TileSize + (x - x0);
+				texelTri[i] = b;
+				texelBary[i * 3] = l0;
+				texelBary[i * 3 + 1] = l1;
+				texelBary[i * 3 + 2] = l2;
+			}
+		}
+	}
+
+	NormalGenLayer defaultLayer;
+	const NormalGenLayer* background = &defaultLayer;
+	const Image* backgroundImage = nullptr;
+	for (int l = 0; l < layers.size(); l++) {
+		if (layers[l].IsBackground()) {
+			background = &layers[l];
+			if (images[l].source.IsOk())
+				backgroundImage = &images[l].source;
+			break;
+		}
+	}
+
+	for (int y = y0; y < y1; y++) {
+		for (int x = x0; x < x1; x++) {
+			unsigned char* out = &output.pixels[(y * resolution + x) * 3];
+
+			float bgColor[3] = { (float)background->fillColor[0], (float)background->fillColor[1], (float)background->fillColor[2] };
+			if (backgroundImage) {
+				SampleLinear(*backgroundImage, (x + 0.5f) / resolution, (y + 0.5f) / resolution, bgColor);
+				ApplyChannelOptions(*background, bgColor);
+			}
+
+			int i = (y - y0) * TileSize + (x - x0);
+			if (texelTri[i] < 0) {
+				out[0] = EncodeChannel(bgColor[0] / 255.0f);
+				out[1] = EncodeChannel(bgColor[1] / 255.0f);
+				out[2] = EncodeChannel(bgColor[2] / 255.0f);
+				continue;
+			}
+
+			const TriRef& ref = bin[texelTri[i]];
+			mesh* m = meshes[ref.mesh];
+			const Triangle& t = m->tris[ref.tri];
+			const TriFrame& frame = frames[ref.mesh][ref.tri];
+
+			const float* bary = &texelBary[i * 3];
+			Vector3 meshNormal = m->norms[t.p1] * bary[0] + m->norms[t.p2] * bary[1] + m->norms[t.p3] * bary[2];
+			meshNormal.Normalize();
+
+			Vector3 normal = DecodeNormal(*background, bgColor, meshNormal, frame.dPdu, frame.dPdv);
+
+			for (int l = 0; l < layers.size(); l++) {
+				const NormalGenLayer& layer = layers[l];
+				if (layers[l].IsBackground() || !images[l].source.IsOk())
+					continue;
+
+				float color[3];
+				if (!SampleLayer(images[l].source, layer, resolution, x, y, layer.xOffset, layer.yOffset, color))
+					continue;
+
+				ApplyChannelOptions(layer, color);
+
+				// Masks select the area on the mesh, so they aren't offset with the layer
+				float weight = 1.0f;
+				if (images[l].mask.IsOk()) {
+					float maskColor[3];
+					if (!SampleLayer(images[l].mask, layer, resolution, x, y, 0, 0, maskColor))
+						continue;
+
+					weight = maskColor[0] / 255.0f;
+					if (weight <= 0.0f)
+						continue;
+				}
+
+				const Vector3& base = layer.useMeshNormalsSource ? meshNormal : normal;
+				Vector3 layerNormal = DecodeNormal(layer, color, base, frame.dPdu, frame.dPdv);
+				if (weight < 1.0f) {
+					layerNormal = normal * (1.0f - weight) + layerNormal * weight;
+					layerNormal.Normalize();
+				}
+
+				normal = layerNormal;
+			}
+
+			// NormalColor in normalshade.frag
+			out[0] = EncodeChannel(1.0f - (normal.x + 1.0f) / 2.0f);
+			out[1] = EncodeChannel((normal.y + 1.0f) / 2.0f);
+			out[2] = EncodeChannel((normal.z + 1.0f) / 2.0f);
+			coverage[y * resolution + x] = 1;
+		}
+	}
+}
+
+void NormalMapCompositor::FillBorders(const std::vector<unsigned char>& coverage, const std::vector<unsigned char>& tilesDrawn) {
+	// Nearest covered sample within 10 steps of 1/1024 in eight directions, see minDistSample in fullscreentri.frag.
+	// Only uncovered texels are written and only covered ones are read, so rows don't depend on each other.
+	static const int dirs[8][2] = { { -1, 0 }, { 1, 0 }, { 0, 1 }, { 0, -1 }, { -1, 1 }, { 1, 1 }, { 1, -1 }, { -1, -1 } };
+	const int range = 10;
+
+	int steps[range];
+	for (int r = 0; r < range; r++)
+		steps[r] = (int)(r * resolution / 1024.0f + 0.5f);
+
+	// Tiles with no triangles around them in reach of the search are skipped
+	int tilesPerSide = (resolution + TileSize - 1) / TileSize;
+	int tileReach = (steps[range - 1] + TileSize - 1) / TileSize;
+	std::vector<unsigned char> tilesNear(tilesDrawn.size(), 0);
+	for (int ty = 0; ty < tilesPerSide; ty++) {
+		for (int tx = 0; tx < tilesPerSide; tx++) {
+			if (!tilesDrawn[ty * tilesPerSide + tx])
+				continue;
+
+			for (int ny = ty - tileReach; ny <= ty + tileReach; ny++)
+				for (int nx = tx - tileReach; nx <= tx + tileReach; nx++)
+					tilesNear[WrapIndex(ny, tilesPerSide) * tilesPerSide + WrapIndex(nx, tilesPerSide)] = 1;
+		}
+	}
+
+	auto fillRow = [&](int y) {
+		const unsigned char* rowTiles = &tilesNear[(y / TileSize) * tilesPerSide];
+		for (int x = 0; x < resolution; x++) {
+			if (!rowTiles[x / TileSize]) {
+				x = (x / TileSize + 1) * TileSize - 1;
+				continue;
+			}
+
+			if (coverage[y * resolution + x])
+				continue;
+
+			bool found = false;
+			for (int r = 1; r < range && !found; r++) {
+				for (int d = 0; d < 8; d++) {
+					int sx = x + dirs[d][0] * steps[r];
+					int sy = y + dirs[d][1] * steps[r];
+					if (sx < 0)
+						sx += resolution;
+					else if (sx >= resolution)
+						sx -= resolution;
+					if (sy < 0)
+						sy += resolution;
+					else if (sy >= resolution)
+						sy -= resolution;
+
+					if (!coverage[sy * resolution + sx])
+						continue;
+
+					unsigned char* out = &output.pixels[(y * resolution + x) * 3];
+					const unsigned char* in = &output.pixels[(sy * resolution + sx) * 3];
+					out[0] = in[0];
+					out[1] = in[1];
+					out[2] = in[2];
+					found = true;
+					break;
+				}
+			}
+		}
+	};
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, resolution, fillRow);
+#else
+	for (int y = 0; y < resolution; y++)
+		fillRow(y);
+#endif
+}
+
+bool NormalMapCompositor::Composite() {
+	if (meshes.empty())
+		return false;
+
+	output.width = resolution;
+	output.height = resolution;
+	output.pixels.assign(resolution * resolution * 3, 0);
+
+	std::vector<LayerImages> images(layers.size());
+	auto loadImages = [&](int l) {
+		LoadLayerImage(layers[l].sourceFileName, images[l].source);
+		if (!layers[l].IsBackground())
+			LoadLayerImage(layers[l].maskFileName, images[l].mask);
+	};
+
+	std::vector<std::vector<TriFrame>> frames(meshes.size());
+	auto buildFrames = [&](int mi) {
+		mesh* m = meshes[mi];
+		frames[mi].resize(m->nTris);
+		for (int t = 0; t < m->nTris; t++) {
+			const Triangle& tri = m->tris[t];
+			Vector3 e1 = m->verts[tri.p2] - m->verts[tri.p1];
+			Vector3 e2 = m->verts[tri.p3] - m->verts[tri.p1];
+			Vector2 uv1 = m->texcoord[tri.p2] - m->texcoord[tri.p1];
+			Vector2 uv2 = m->texcoord[tri.p3] - m->texcoord[tri.p1];
+
+			float det = uv1.u * uv2.v - uv2.u * uv1.v;
+			if (det == 0.0f)
+				continue;
+
+			frames[mi][t].dPdu = (e1 * uv2.v - e2 * uv1.v) / det;
+			frames[mi][t].dPdv = (e2 * uv1.u - e1 * uv2.u) / det;
+		}
+	};
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, (int)layers.size(), loadImages);
+	concurrency::parallel_for(0, (int)meshes.size(), buildFrames);
+#else
+	for (int l = 0; l < layers.size(); l++)
+		loadImages(l);
+	for (int mi = 0; mi < meshes.size(); mi++)
+		buildFrames(mi);
+#endif
+
+	// Bin the triangles by the tiles their UV bounds touch, keeping the draw order in each bin
+	int tilesPerSide = (resolution + TileSize - 1) / TileSize;
+	std::vector<std::vector<TriRef>> bins(tilesPerSide * tilesPerSide);
+	for (int mi = 0; mi < meshes.size(); mi++) {
+		mesh* m = meshes[mi];
+		if (!m->texcoord)
+			continue;
+
+		for (int t = 0; t < m->nTris; t++) {
+			const Triangle& tri = m->tris[t];
+			const Vector2& a = m->texcoord[tri.p1];
+			const Vector2& b = m->texcoord[tri.p2];
+			const Vector2& c = m->texcoord[tri.p3];
+
+			float minU = std::min(a.u, std::min(b.u, c.u)) * resolution;
+			float minV = std::min(a.v, std::min(b.v, c.v)) * resolution;
+			float maxU = std::max(a.u, std::max(b.u, c.u)) * resolution;
+			float maxV = std::max(a.v, std::max(b.v, c.v)) * resolution;
+			if (maxU < 0.0f || maxV < 0.0f || minU >= resolution || minV >= resolution)
+				continue;
+
+			int tx0 = std::max(0, (int)minU / TileSize);
+			int ty0 = std::max(0, (int)minV / TileSize);
+			int tx1 = std::min(tilesPerSide - 1, (int)maxU / TileSize);
+			int ty1 = std::min(tilesPerSide - 1, (int)maxV / TileSize);
+			for (int ty = ty0; ty <= ty1; ty++)
+				for (int tx = tx0; tx <= tx1; tx++)
+					bins[ty * tilesPerSide + tx].push_back({ mi, t });
+		}
+	}
+
+	std::vector<unsigned char> coverage(resolution * resolution, 0);
+
+#ifdef _PPL_H
+	concurrency::combinable<TileScratch> scratches;
+	concurrency::parallel_for(0, tilesPerSide * tilesPerSide, [&](int tile) {
+		ShadeTile(tile % tilesPerSide, tile / tilesPerSide, bins[tile], frames, images, scratches.local(), coverage);
+	});
+#else
+	TileScratch scratch;
+	for (int tile = 0; tile < tilesPerSide * tilesPerSide; tile++)
+		ShadeTile(tile % tilesPerSide, tile / tilesPerSide, bins[tile], frames, images, scratch, coverage);
+#endif
+
+	std::vector<unsigned char> tilesDrawn(bins.size());
+	for (int tile = 0; tile < bins.size(); tile++)
+		tilesDrawn[tile] = !bins[tile].empty();
+
+	FillBorders(coverage, tilesDrawn);
+	return true;
+}
+
+bool NormalMapCompositor::LoadLayerImage(const std::string& fileName, Image& outImage) {
+	if (fileName.empty() || !wxFileName::FileExists(fileName))
+		return false;
+
+	// Missing layer files are skipped, so the errors of the image handlers aren't shown
+	wxLogNull logNo;
+	wxImage image;
+	if (!image.LoadFile(fileName) || !image.IsOk())
+		return false;
+
+	outImage.width = image.GetWidth();
+	outImage.height = image.GetHeight();
+
+	unsigned char* data = image.GetData();
+	outImage.pixels.assign(data, data + outImage.width * outImage.height * 3);
+	return true;
+}
+
+bool NormalMapCompositor::SaveFile(const std::string& fileName) {
+	if (!output.IsOk())
+		return false;
+
+	wxImage image(output.width, output.height, output.pixels.data(), true);
+	return image.SaveFile(fileName);
+}
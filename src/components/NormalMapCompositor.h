@@ -0,0 +1,86 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "NormalGenLayers.h"
+#include "Mesh.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class NifFile;
+
+// Software version of the normals generation of the preview window, so that it can run without OpenGL.
+// The layers are composited in UV space of the meshes into a model space normal map. The texture is split
+// into tiles that are rasterized and shaded in parallel, using the same tangent frames as the preview shader.
+// Texels outside of the UVs are filled from the nearest texels inside of them like the preview's post processing.
+class NormalMapCompositor {
+public:
+	// RGB pixels, rows from V = 0 to V = 1
+	struct Image {
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned char> pixels;
+
+		bool IsOk() const { return width > 0 && height > 0; }
+	};
+
+private:
+	// Derivatives of the position over the UVs of a triangle, for the cotangent frame
+	struct TriFrame {
+		Vector3 dPdu;
+		Vector3 dPdv;
+	};
+
+	struct TriRef {
+		int mesh;
+		int tri;
+	};
+
+	struct LayerImages {
+		Image source;
+		Image mask;
+	};
+
+	// Last triangle drawn per texel of a tile with its barycentric coordinates, reused for all tiles of a thread
+	struct TileScratch {
+		std::vector<int> texelTri;
+		std::vector<float> texelBary;
+	};
+
+	std::vector<NormalGenLayer> layers;
+	std::vector<mesh*> meshes;
+	std::vector<std::unique_ptr<mesh>> ownedMeshes;
+	int resolution = 4096;
+	Image output;
+
+	static const int TileSize = 64;
+
+	bool LoadLayerImage(const std::string& fileName, Image& outImage);
+	void ShadeTile(const int tileX, const int tileY, const std::vector<TriRef>& bin, const std::vector<std::vector<TriFrame>>& frames,
+		const std::vector<LayerImages>& images, TileScratch& scratch, std::vector<unsigned char>& coverage);
+	void FillBorders(const std::vector<unsigned char>& coverage, const std::vector<unsigned char>& tilesDrawn);
+
+public:
+	NormalMapCompositor(const std::vector<NormalGenLayer>& layers);
+
+	// The mesh is used as it is, it has to stay valid until Composite returns.
+	void AddMesh(mesh* m);
+
+	// Adds the shapes of the file with the same conversion to the editor space as the preview.
+	// Returns the number of shapes added.
+	int AddMeshes(NifFile& nif, const std::vector<std::string>& shapes);
+
+	// Output texture dimensions, from the background layer
+	int GetResolution() { return resolution; }
+
+	bool Composite();
+
+	const Image& GetOutput() { return output; }
+	bool SaveFile(const std::string& fileName);
+};
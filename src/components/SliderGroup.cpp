@@ -6,8 +6,11 @@ See the included LICENSE file
 
 #include "SliderGroup.h"
 
+#include <algorithm>
+
 int SliderSetGroupCollection::LoadGroups(const std::string& basePath) {
 	groups.clear();
+	outfitGroups.clear();
 
 	wxArrayString files;
 	wxDir::GetAllFiles(basePath, &files, "*.xml");
@@ -19,16 +22,42 @@ int SliderSetGroupCollection::LoadGroups(const std::string& basePath) {
 		for (auto &group : groupNames) {
 			SliderSetGroup ssg;
 			groupFile.GetGroup(group, ssg);
-			if (groups.find(group) != groups.end())
-				groups[group].MergeMembers(ssg);
-			else
-				groups[group] = std::move(ssg);
+			MergeGroup(std::move(ssg));
 		}
 	}
 
 	return 0;
 }
 
+int SliderSetGroupCollection::AddMembers(const std::string& groupName, const std::vector<std::string>& inMembers) {
+	SliderSetGroup& group = groups[groupName];
+	group.SetName(groupName);
+
+	for (auto &m : inMembers)
+		IndexMember(m, groupName);
+
+	return group.AddMembers(inMembers);
+}
+
+void SliderSetGroupCollection::MergeGroup(SliderSetGroup&& sourceGroup) {
+	for (auto &m : sourceGroup.members)
+		IndexMember(m, sourceGroup.name);
+
+	auto git = groups.find(sourceGroup.name);
+	if (git != groups.end())
+		git->second.MergeMembers(sourceGroup);
+	else
+		groups[sourceGroup.name] = std::move(sourceGroup);
+}
+
+void SliderSetGroupCollection::IndexMember(const std::string& member, const std::string& groupName) {
+	// Groups of an outfit are kept in the same order as the group map
+	std::vector<std::string>& memberGroups = outfitGroups[member];
+	auto it = std::lower_bound(memberGroups.begin(), memberGroups.end(), groupName);
+	if (it == memberGroups.end() || *it != groupName)
+		memberGroups.insert(it, groupName);
+}
+
 int SliderSetGroupCollection::GetAllGroups(std::set<std::string>& outGroups) {
 	outGroups.clear();
 	for (auto &g : groups)
@@ -39,9 +68,9 @@ int SliderSetGroupCollection::GetAllGroups(std::set<std::string>& outGroups) {
 
 int SliderSetGroupCollection::GetOutfitGroups(const std::string& outfitName, std::vector<std::string>& outGroups) {
 	outGroups.clear();
-	for (auto &g : groups)
-		if (g.second.HasMember(outfitName))
-			outGroups.push_back(g.first);
+	auto result = outfitGroups.find(outfitName);
+	if (result != outfitGroups.end())
+		outGroups = result->second;
 
 	return outGroups.size();
 }
@@ -66,7 +95,8 @@ int SliderSetGroupCollection::GetGroupMembers(const std::string& groupName, std:
 void SliderSetGroup::MergeMembers(const SliderSetGroup& sourceGroup) {
 	for (size_t i = 0; i < sourceGroup.members.size(); i++) {
 		members.push_back(sourceGroup.members[i]);
-		sourceFiles.push_back(sourceGroup.sourceFiles[i]);
+		if (i < sourceGroup.sourceFiles.size())
+			sourceFiles.push_back(sourceGroup.sourceFiles[i]);
 	}
 }
 
@@ -12,6 +12,7 @@ See the included LICENSE file
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace tinyxml2;
@@ -21,6 +22,8 @@ class SliderSetGroup {
 	std::vector<std::string> members;
 	std::vector<std::string> sourceFiles;
 
+	friend class SliderSetGroupCollection;
+
 public:
 	SliderSetGroup() { }
 	SliderSetGroup(XMLElement * srcGroupElement) {
@@ -49,11 +52,20 @@ public:
 
 class SliderSetGroupCollection {
 	std::map<std::string, SliderSetGroup> groups;
+	std::unordered_map<std::string, std::vector<std::string>> outfitGroups;	// Outfit names mapped to the names of their groups, in order.
+
+	void IndexMember(const std::string& member, const std::string& groupName);
 
 public:
-	// Loads all groups in the specified folder.
+	// Loads all groups in the specified folder, merging groups of the same name in file order.
 	int LoadGroups(const std::string& basePath);
 
+	// Adds the members to the group, creating it if it doesn't exist yet.
+	int AddMembers(const std::string& groupName, const std::vector<std::string>& inMembers);
+
+	// Combines the members of the group with the collection's group of the same name, or adds it.
+	void MergeGroup(SliderSetGroup&& sourceGroup);
+
 	int GetAllGroups(std::set<std::string>& outGroups);
 	int GetOutfitGroups(const std::string& outfitName, std::vector<std::string>& outGroups);
 
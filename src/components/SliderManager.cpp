@@ -55,8 +55,7 @@ void SliderManager::AddSlider(const std::string& name, bool invert, const std::s
 	s.uv = false;
 	s.changed = false;
 
-	slidersSmall.push_back(s);
-	slidersBig.push_back(s);
+	PushSlider(s);
 	mSliderCount++;
 }
 
@@ -74,8 +73,7 @@ void SliderManager::AddUVSlider(const std::string& name, bool invert, bool isZap
 	s.uv = true;
 	s.changed = false;
 
-	slidersSmall.push_back(s);
-	slidersBig.push_back(s);
+	PushSlider(s);
 	mSliderCount++;
 }
 
@@ -94,8 +92,7 @@ void SliderManager::AddZapSlider(const std::string& name, const std::vector<std:
 	s.zapToggles = zapToggles;
 	s.changed = false;
 
-	slidersSmall.push_back(s);
-	slidersBig.push_back(s);
+	PushSlider(s);
 	mSliderCount++;
 }
 
@@ -113,108 +110,87 @@ void SliderManager::AddHiddenSlider(const std::string& name, bool invert, bool i
 	s.uv = isUv;
 	s.changed = false;
 
+	PushSlider(s);
+}
+
+void SliderManager::PushSlider(const Slider& s) {
+	// Name lookups find the first slider with the name, like a search through the list would
+	sliderIndices.emplace(s.name, (int)slidersBig.size());
+
 	slidersSmall.push_back(s);
 	slidersBig.push_back(s);
 }
 
+int SliderManager::GetSliderIndex(const std::string& slider) {
+	auto it = sliderIndices.find(slider);
+	if (it == sliderIndices.end())
+		return -1;
+
+	return it->second;
+}
+
 void SliderManager::SetSliderDefaults(const std::string& slider, float bigVal, float smallVal) {
-	for (int i = 0; i < slidersBig.size(); i++)
-		if (slidersBig[i].name == slider)
-			slidersBig[i].defValue = bigVal;
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return;
 
-	for (int i = 0; i < slidersSmall.size(); i++)
-		if (slidersSmall[i].name == slider)
-			slidersSmall[i].defValue = smallVal;
+	slidersBig[index].defValue = bigVal;
+	slidersSmall[index].defValue = smallVal;
 }
 
 void SliderManager::SetClampSlider(const std::string& slider) {
-	for (int i = 0; i < slidersBig.size(); i++)
-		if (slidersBig[i].name == slider)
-			slidersBig[i].clamp = true;
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return;
 
-	for (int i = 0; i < slidersSmall.size(); i++)
-		if (slidersSmall[i].name == slider)
-			slidersSmall[i].clamp = true;
+	slidersBig[index].clamp = true;
+	slidersSmall[index].clamp = true;
 }
 
 void SliderManager::AddSliderLink(const std::string& slider, const std::string& dataSetName) {
-	for (int i = 0; i < slidersBig.size(); i++)
-		if (slidersBig[i].name == slider)
-			slidersBig[i].linkedDataSets.push_back(dataSetName);
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return;
 
-	for (int i = 0; i < slidersSmall.size(); i++)
-		if (slidersSmall[i].name == slider)
-			slidersSmall[i].linkedDataSets.push_back(dataSetName);
+	slidersBig[index].linkedDataSets.push_back(dataSetName);
+	slidersSmall[index].linkedDataSets.push_back(dataSetName);
 }
 
 float SliderManager::GetSlider(const std::string& slider, bool isSmall) {
-	if (!isSmall) {
-		for (int i = 0; i < slidersBig.size(); i++)
-			if (slidersBig[i].name == slider)
-				return slidersBig[i].value;
-	}
-	else {
-		for (int i = 0; i < slidersSmall.size(); i++)
-			if (slidersSmall[i].name == slider)
-				return slidersSmall[i].value;
-	}
-	return 0.0f;
+	return SliderValue(slider, !isSmall);
 }
 
 std::vector<std::string> SliderManager::GetSliderZapToggles(const std::string& slider) {
-	for (int i = 0; i < slidersBig.size(); i++)
-		if (slidersBig[i].name == slider)
-			return slidersBig[i].zapToggles;
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return std::vector<std::string>();
 
-	return std::vector<std::string>();
+	return slidersBig[index].zapToggles;
 }
 
 void SliderManager::SetSlider(const std::string& slider, bool isSmall, float val) {
-	if (!isSmall) {
-		for (int i = 0; i < slidersBig.size(); i++) {
-			if (slidersBig[i].name == slider) {
-				if (slidersBig[i].zap) {
-					FlagReload(true);
-					if (val > 0.0f)
-						val = 1.0f;
-				}
-				slidersBig[i].value = val;
-				return;
-			}
-		}
-	}
-	else {
-		for (int i = 0; i < slidersSmall.size(); i++) {
-			if (slidersSmall[i].name == slider) {
-				if (slidersSmall[i].zap) {
-					FlagReload(true);
-					if (val > 0.0f)
-						val = 1.0f;
-				}
-				slidersSmall[i].value = val;
-				return;
-			}
-		}
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return;
+
+	Slider& s = isSmall ? slidersSmall[index] : slidersBig[index];
+	if (s.zap) {
+		FlagReload(true);
+		if (val > 0.0f)
+			val = 1.0f;
 	}
+	s.value = val;
 }
 
 void SliderManager::SetChanged(const std::string& slider, bool isSmall) {
-	if (!isSmall) {
-		for (int i = 0; i < slidersBig.size(); i++) {
-			if (slidersBig[i].name == slider) {
-				slidersBig[i].changed = true;
-				return;
-			}
-		}
-	}
-	else {
-		for (int i = 0; i < slidersSmall.size(); i++) {
-			if (slidersSmall[i].name == slider) {
-				slidersSmall[i].changed = true;
-				return;
-			}
-		}
-	}
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return;
+
+	if (!isSmall)
+		slidersBig[index].changed = true;
+	else
+		slidersSmall[index].changed = true;
 }
 
 float SliderManager::GetBigPresetValue(const std::string& presetName, const std::string& sliderName, float defVal) {
@@ -254,31 +230,27 @@ void SliderManager::InitializeSliders(const std::string& presetName) {
 }
 
 bool SliderManager::SliderHasChanged(const std::string& slider, bool getBig) {
-	if (getBig) {
-		for (int i = 0; i < slidersBig.size(); i++)
-			if (slidersBig[i].name == slider)
-				return (slidersBig[i].defValue != slidersBig[i].value || (slidersBig[i].changed && slidersBig[i].zap));
-	}
-	else {
-		for (int i = 0; i < slidersSmall.size(); i++)
-			if (slidersSmall[i].name == slider)
-				return (slidersSmall[i].defValue != slidersSmall[i].value || (slidersSmall[i].changed && slidersSmall[i].zap));
-	}
-	return false;
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return false;
+
+	return SliderHasChanged(index, getBig);
+}
+
+bool SliderManager::SliderHasChanged(const int index, bool getBig) {
+	Slider& s = getBig ? slidersBig[index] : slidersSmall[index];
+	return (s.defValue != s.value || (s.changed && s.zap));
 }
 
 float SliderManager::SliderValue(const std::string& slider, bool getBig) {
-	if (getBig) {
-		for (int i = 0; i < slidersBig.size(); i++)
-			if (slidersBig[i].name == slider)
-				return slidersBig[i].value;
-	}
-	else {
-		for (int i = 0; i < slidersSmall.size(); i++)
-			if (slidersSmall[i].name == slider)
-				return slidersSmall[i].value;
-	}
-	return 0.0f;
+	int index = GetSliderIndex(slider);
+	if (index == -1)
+		return 0.0f;
+
+	if (getBig)
+		return slidersBig[index].value;
+	else
+		return slidersSmall[index].value;
 }
 
 void SliderManager::GetSmallSliderList(std::vector<std::string>& names) {
@@ -9,6 +9,8 @@ See the included LICENSE file
 #include "SliderSet.h"
 #include "SliderPresets.h"
 
+#include <unordered_map>
+
 class Slider {
 public:
 	std::string name;
@@ -28,6 +30,11 @@ class SliderManager {
 	PresetCollection presetCollection;
 	bool bNeedReload;
 
+	// Index of each slider name in slidersBig and slidersSmall, which are always added to in the same order
+	std::unordered_map<std::string, int> sliderIndices;
+
+	void PushSlider(const Slider& s);
+
 public:
 	std::vector<Slider> slidersBig;
 	std::vector<Slider> slidersSmall;
@@ -38,6 +45,7 @@ public:
 	void ClearSliders() {
 		slidersBig.clear();
 		slidersSmall.clear();
+		sliderIndices.clear();
 		mSliderCount = 0;
 	}
 
@@ -46,19 +54,16 @@ public:
 	}
 
 	int SavePreset(const std::string& filePath, const std::string& presetName, const std::string& sliderSetName, std::vector<std::string>& assignGroups) {
-		int index = 0;
-		for (auto &s : slidersBig) {
-			if (SliderHasChanged(s.name, true))
-				presetCollection.SetSliderPreset(presetName, s.name, s.value);
+		for (int i = 0; i < slidersBig.size(); i++) {
+			if (SliderHasChanged(i, true))
+				presetCollection.SetSliderPreset(presetName, slidersBig[i].name, slidersBig[i].value);
 			else
-				presetCollection.ClearSlider(presetName, s.name, true);
+				presetCollection.ClearSlider(presetName, slidersBig[i].name, true);
 
-			if (SliderHasChanged(s.name, false))
-				presetCollection.SetSliderPreset(presetName, slidersSmall[index].name, -10000.0f, slidersSmall[index].value);
+			if (SliderHasChanged(i, false))
+				presetCollection.SetSliderPreset(presetName, slidersSmall[i].name, -10000.0f, slidersSmall[i].value);
 			else
-				presetCollection.ClearSlider(presetName, slidersSmall[index].name, false);
-
-			index++;
+				presetCollection.ClearSlider(presetName, slidersSmall[i].name, false);
 		}
 		return presetCollection.SavePreset(filePath, presetName, sliderSetName, assignGroups);
 	}
@@ -92,6 +97,9 @@ public:
 	void AddHiddenSlider(const std::string& name, bool invert = false, bool isZap = false, bool isUV = false, const std::string& dataSetName = "");
 	void AddZapSlider(const std::string& name, const std::vector<std::string>& zapToggles, const std::string& dataSetName = "");
 	void AddUVSlider(const std::string& name, bool invert = false, bool isZap = false, const std::string& dataSetName = "");
+	// Returns the index of the slider in slidersBig and slidersSmall, or -1 if there is none with that name.
+	int GetSliderIndex(const std::string& slider);
+
 	void SetSliderDefaults(const std::string& slider, float bigVal, float smallVal);
 	void SetClampSlider(const std::string& slider);
 	void AddSliderLink(const std::string& slider, const std::string& dataSetName);
@@ -104,6 +112,7 @@ public:
 	void InitializeSliders(const std::string& presetName = "");
 
 	bool SliderHasChanged(const std::string& slider, bool getBig);
+	bool SliderHasChanged(const int index, bool getBig);
 	float SliderValue(const std::string& slider, bool getBig);
 
 	void FlagReload(bool needReload) {
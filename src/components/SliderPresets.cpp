@@ -8,104 +8,323 @@ See the included LICENSE file
 #include "SliderPresets.h"
 
 #include <wx/dir.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 using namespace tinyxml2;
 
-void PresetCollection::Clear() {
-	namedSliderPresets.clear();
-	presetFileNames.clear();
-	presetGroups.clear();
+struct IndexedPreset {
+	std::string name;
+	PresetCollection::Preset preset;
+};
+
+struct IndexedPresetFile {
+	long long modTime = 0;
+	unsigned long long size = 0;
+	std::vector<IndexedPreset> presets;
+};
+
+// Parsed preset files shared by all collections, with lookup tables from the set and group names
+// to the presets. The tables hold positions in the preset order of the last enumeration of the files.
+struct PresetIndex {
+	std::map<std::string, IndexedPresetFile> files;
+	std::vector<std::string> fileOrder;
+	std::vector<const IndexedPreset*> presets;
+	std::unordered_map<std::string, std::vector<int>> presetsBySet;
+	std::unordered_map<std::string, std::vector<int>> presetsByGroup;
+};
+
+static std::mutex presetIndexMutex;
+static PresetIndex presetIndex;
+
+// Lookups only share the lock, so parallel builds don't wait on each other. New names are rare.
+static std::shared_timed_mutex sliderIdMutex;
+static std::unordered_map<std::string, int> sliderIds;
+static std::vector<std::string> sliderNames;
+
+int PresetCollection::GetSliderId(const std::string& sliderName, const bool add) {
+	{
+		std::shared_lock<std::shared_timed_mutex> lock(sliderIdMutex);
+
+		auto result = sliderIds.find(sliderName);
+		if (result != sliderIds.end())
+			return result->second;
+
+		if (!add)
+			return -1;
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(sliderIdMutex);
+
+	// Added by another thread in the meantime
+	auto result = sliderIds.find(sliderName);
+	if (result != sliderIds.end())
+		return result->second;
+
+	int id = sliderNames.size();
+	sliderNames.push_back(sliderName);
+	sliderIds[sliderName] = id;
+	return id;
 }
 
-void PresetCollection::ClearSlider(const std::string& presetName, const std::string& sliderName, const bool big) {
-	if (namedSliderPresets.find(presetName) != namedSliderPresets.end()) {
-		if (big)
-			namedSliderPresets[presetName][sliderName].big = -10000.0f;
-		else
-			namedSliderPresets[presetName][sliderName].small = -10000.0f;
-	}
+std::string PresetCollection::GetSliderName(const int sliderId) {
+	std::shared_lock<std::shared_timed_mutex> lock(sliderIdMutex);
+
+	if (sliderId < 0 || sliderId >= sliderNames.size())
+		return "";
+
+	return sliderNames[sliderId];
 }
 
-void PresetCollection::GetPresetNames(std::vector<std::string>& outNames) {
-	for (auto &it : namedSliderPresets)
-		outNames.push_back(it.first);
+SliderPreset* PresetCollection::Preset::FindValue(const int sliderId) {
+	auto it = std::lower_bound(sliderIds.begin(), sliderIds.end(), sliderId);
+	if (it == sliderIds.end() || *it != sliderId)
+		return nullptr;
+
+	return &values[it - sliderIds.begin()];
 }
 
-void PresetCollection::SetSliderPreset(const std::string& set, const std::string& slider, float big, float small) {
-	std::map<std::string, SliderPreset> newPreset;
-	SliderPreset sp;
-	if (namedSliderPresets.find(set) == namedSliderPresets.end()) {
+SliderPreset& PresetCollection::Preset::AddValue(const int sliderId) {
+	auto it = std::lower_bound(sliderIds.begin(), sliderIds.end(), sliderId);
+	int index = it - sliderIds.begin();
+	if (it == sliderIds.end() || *it != sliderId) {
+		SliderPreset sp;
 		sp.big = sp.small = -10000.0f;
+		sliderIds.insert(it, sliderId);
+		values.insert(values.begin() + index, sp);
+	}
+
+	return values[index];
+}
+
+static void ParsePresetFile(const std::string& fileName, std::vector<IndexedPreset>& outPresets) {
+	outPresets.clear();
+
+	XMLDocument doc;
+	if (doc.LoadFile(fileName.c_str()) != XML_SUCCESS)
+		return;
+
+	XMLElement* root = doc.FirstChildElement("SliderPresets");
+	if (!root)
+		return;
+
+	XMLElement* element = root->FirstChildElement("Preset");
+	while (element) {
+		const char* presetName = element->Attribute("name");
+		if (!presetName) {
+			element = element->NextSiblingElement("Preset");
+			continue;
+		}
+
+		IndexedPreset ip;
+		ip.name = presetName;
 
-		if (big > -10000.0f)
-			sp.big = big;
-		if (small > -10000.0f)
-			sp.small = small;
+		const char* setName = element->Attribute("set");
+		ip.preset.set = setName ? setName : "";
+		ip.preset.fileName = fileName;
+
+		XMLElement* g = element->FirstChildElement("Group");
+		while (g) {
+			const char* groupName = g->Attribute("name");
+			ip.preset.groups.push_back(groupName ? groupName : "");
+			g = g->NextSiblingElement("Group");
+		}
 
-		newPreset[slider] = sp;
-		namedSliderPresets[set] = newPreset;
+		XMLElement* setSlider = element->FirstChildElement("SetSlider");
+		while (setSlider) {
+			const char* sliderName = setSlider->Attribute("name");
+			const char* applyTo = setSlider->Attribute("size");
+			float o = setSlider->FloatAttribute("value") / 100.0f;
+
+			float b = -10000.0f;
+			float s = -10000.0f;
+			std::string size = applyTo ? applyTo : "";
+			if (size == "small")
+				s = o;
+			else if (size == "big")
+				b = o;
+			else if (size == "both")
+				s = b = o;
+
+			SliderPreset& sp = ip.preset.AddValue(PresetCollection::GetSliderId(sliderName ? sliderName : "", true));
+			if (b > -10000.0f)
+				sp.big = b;
+			if (s > -10000.0f)
+				sp.small = s;
+
+			setSlider = setSlider->NextSiblingElement("SetSlider");
+		}
+
+		outPresets.push_back(std::move(ip));
+		element = element->NextSiblingElement("Preset");
 	}
-	else {
-		if (namedSliderPresets[set].find(slider) == namedSliderPresets[set].end()) {
-			sp.big = sp.small = -10000.0f;
+}
+
+// Brings the index up to date with the files, parsing only new and changed ones
+static void UpdatePresetIndex(const wxArrayString& files) {
+	bool changed = files.size() != presetIndex.fileOrder.size();
+
+	for (int i = 0; i < files.size(); i++) {
+		std::string fileName = files[i].ToStdString();
+		if (!changed && presetIndex.fileOrder[i] != fileName)
+			changed = true;
+
+		wxFileName fn(files[i]);
+		long long modTime = fn.GetModificationTime().GetValue().GetValue();
+		unsigned long long size = fn.GetSize().GetValue();
+
+		auto result = presetIndex.files.find(fileName);
+		if (result != presetIndex.files.end() && result->second.modTime == modTime && result->second.size == size)
+			continue;
 
-			if (big > -10000.0f)
-				sp.big = big;
-			if (small > -10000.0f)
-				sp.small = small;
+		IndexedPresetFile& file = presetIndex.files[fileName];
+		file.modTime = modTime;
+		file.size = size;
+		ParsePresetFile(fileName, file.presets);
+		changed = true;
+	}
+
+	if (!changed)
+		return;
 
-			namedSliderPresets[set][slider] = sp;
+	// Drop files that were removed
+	if (presetIndex.files.size() > files.size()) {
+		std::map<std::string, IndexedPresetFile> existing;
+		for (auto &f : files) {
+			auto result = presetIndex.files.find(f.ToStdString());
+			if (result != presetIndex.files.end())
+				existing[result->first] = std::move(result->second);
 		}
-		else {
-			if (big > -10000.0f)
-				namedSliderPresets[set][slider].big = big;
-			if (small > -10000.0f)
-				namedSliderPresets[set][slider].small = small;
+		presetIndex.files = std::move(existing);
+	}
+
+	presetIndex.fileOrder.clear();
+	presetIndex.presets.clear();
+	presetIndex.presetsBySet.clear();
+	presetIndex.presetsByGroup.clear();
+
+	for (auto &f : files) {
+		std::string fileName = f.ToStdString();
+		presetIndex.fileOrder.push_back(fileName);
+
+		for (auto &ip : presetIndex.files[fileName].presets) {
+			int index = presetIndex.presets.size();
+			presetIndex.presets.push_back(&ip);
+			presetIndex.presetsBySet[ip.preset.set].push_back(index);
+			for (auto &g : ip.preset.groups)
+				presetIndex.presetsByGroup[g].push_back(index);
 		}
 	}
 }
 
-bool PresetCollection::GetSliderExists(const std::string& set, const std::string& slider) {
-	if (namedSliderPresets.find(set) == namedSliderPresets.end())
-		return false;
-	if (namedSliderPresets[set].find(slider) == namedSliderPresets[set].end())
-		return false;
+void PresetCollection::Clear() {
+	presets.clear();
+	presetIndices.clear();
+}
 
-	return true;
+PresetCollection::Preset* PresetCollection::FindPreset(const std::string& presetName) {
+	auto result = presetIndices.find(presetName);
+	if (result == presetIndices.end())
+		return nullptr;
+
+	return &presets[result->second];
+}
+
+SliderPreset* PresetCollection::FindValue(const std::string& presetName, const std::string& sliderName) {
+	Preset* preset = FindPreset(presetName);
+	if (!preset)
+		return nullptr;
+
+	int sliderId = GetSliderId(sliderName);
+	if (sliderId < 0)
+		return nullptr;
+
+	return preset->FindValue(sliderId);
+}
+
+void PresetCollection::AddPreset(const std::string& presetName, const Preset& preset) {
+	Preset* existing = FindPreset(presetName);
+	if (!existing) {
+		presetIndices[presetName] = presets.size();
+		presets.push_back(preset);
+		return;
+	}
+
+	// Presets of the same name are merged, the last one read wins
+	existing->fileName = preset.fileName;
+	existing->groups = preset.groups;
+
+	for (int i = 0; i < preset.sliderIds.size(); i++) {
+		SliderPreset& sp = existing->AddValue(preset.sliderIds[i]);
+		if (preset.values[i].big > -10000.0f)
+			sp.big = preset.values[i].big;
+		if (preset.values[i].small > -10000.0f)
+			sp.small = preset.values[i].small;
+	}
+}
+
+void PresetCollection::ClearSlider(const std::string& presetName, const std::string& sliderName, const bool big) {
+	Preset* preset = FindPreset(presetName);
+	if (preset && preset->IsListed()) {
+		SliderPreset& sp = preset->AddValue(GetSliderId(sliderName, true));
+		if (big)
+			sp.big = -10000.0f;
+		else
+			sp.small = -10000.0f;
+	}
+}
+
+void PresetCollection::GetPresetNames(std::vector<std::string>& outNames) {
+	for (auto &it : presetIndices)
+		if (presets[it.second].IsListed())
+			outNames.push_back(it.first);
+}
+
+void PresetCollection::SetSliderPreset(const std::string& set, const std::string& slider, float big, float small) {
+	Preset* preset = FindPreset(set);
+	if (!preset) {
+		presetIndices[set] = presets.size();
+		presets.emplace_back();
+		preset = &presets.back();
+	}
+
+	SliderPreset& sp = preset->AddValue(GetSliderId(slider, true));
+	if (big > -10000.0f)
+		sp.big = big;
+	if (small > -10000.0f)
+		sp.small = small;
+}
+
+bool PresetCollection::GetSliderExists(const std::string& set, const std::string& slider) {
+	return FindValue(set, slider) != nullptr;
 }
 
 bool PresetCollection::GetBigPreset(const std::string& set, const std::string& slider, float& big) {
-	float b;
-	if (namedSliderPresets.find(set) == namedSliderPresets.end())
-		return false;
-	if (namedSliderPresets[set].find(slider) == namedSliderPresets[set].end())
+	SliderPreset* sp = FindValue(set, slider);
+	if (!sp || sp->big <= -10000.0f)
 		return false;
-	b = namedSliderPresets[set][slider].big;
-	if (b > -10000.0f) {
-		big = b;
-		return true;
-	}
-	return false;
+
+	big = sp->big;
+	return true;
 }
 
 bool PresetCollection::GetSmallPreset(const std::string& set, const std::string& slider, float& small) {
-	float b;
-	if (namedSliderPresets.find(set) == namedSliderPresets.end())
-		return false;
-	if (namedSliderPresets[set].find(slider) == namedSliderPresets[set].end())
+	SliderPreset* sp = FindValue(set, slider);
+	if (!sp || sp->small <= -10000.0f)
 		return false;
-	b = namedSliderPresets[set][slider].small;
-	if (b > -10000.0f) {
-		small = b;
-		return true;
-	}
-	return false;
+
+	small = sp->small;
+	return true;
 }
 
 std::string PresetCollection::GetPresetFileName(const std::string& set) {
-	auto result = presetFileNames.find(set);
-	if (result != presetFileNames.end())
-		return result->second;
+	Preset* preset = FindPreset(set);
+	if (preset)
+		return preset->fileName;
 
 	return "";
 }
@@ -113,87 +332,49 @@ std::string PresetCollection::GetPresetFileName(const std::string& set) {
 void PresetCollection::GetPresetGroups(const std::string& set, std::vector<std::string>& outGroups) {
 	outGroups.clear();
 
-	auto result = presetGroups.find(set);
-	if (result != presetGroups.end())
-		outGroups = result->second;
+	Preset* preset = FindPreset(set);
+	if (preset)
+		outGroups = preset->groups;
 }
 
 bool PresetCollection::LoadPresets(const std::string& basePath, const std::string& sliderSet, std::vector<std::string>& groupFilter, bool allPresets) {
-	XMLDocument doc;
-	XMLElement* root;
-	XMLElement* element;
-	XMLElement* g;
-	XMLElement* setSlider;
-
-	std::string presetName, sliderName, applyTo;
-	float o, b, s;
-
 	wxArrayString files;
 	wxDir::GetAllFiles(basePath, &files, "*.xml");
 
-	for (auto &file : files) {
-		if (doc.LoadFile(file) != XML_SUCCESS)
-			continue;
+	std::lock_guard<std::mutex> lock(presetIndexMutex);
+	UpdatePresetIndex(files);
 
-		root = doc.FirstChildElement("SliderPresets");
-		if (!root)
-			continue;
-
-		element = root->FirstChildElement("Preset");
-		while (element) {
-			bool skip = true;
-			std::vector<std::string> groups;
-
-			g = element->FirstChildElement("Group");
-			while (g) {
-				std::string groupName = g->Attribute("name");
-				groups.push_back(groupName);
-
-				for (auto &filter : groupFilter) {
-					if (groupName == filter) {
-						skip = false;
-						break;
-					}
-				}
-				g = g->NextSiblingElement("Group");
-			}
-			if (element->Attribute("set") == sliderSet || allPresets)
-				skip = false;
-
-			if (skip) {
-				element = element->NextSiblingElement("Preset");
-				continue;
-			}
-
-			presetName = element->Attribute("name");
-			presetFileNames[presetName] = file;
-			presetGroups[presetName] = groups;
-
-			setSlider = element->FirstChildElement("SetSlider");
-			while (setSlider) {
-				sliderName = setSlider->Attribute("name");
-				applyTo = setSlider->Attribute("size");
-				o = setSlider->FloatAttribute("value") / 100.0f;
-				s = b = -10000.0f;
-				if (applyTo == "small")
-					s = o;
-				else if (applyTo == "big")
-					b = o;
-				else if (applyTo == "both")
-					s = b = o;
-
-				SetSliderPreset(presetName, sliderName, b, s);
-				setSlider = setSlider->NextSiblingElement("SetSlider");
-			}
-			element = element->NextSiblingElement("Preset");
-		}
+	std::vector<int> matches;
+	if (allPresets) {
+		matches.resize(presetIndex.presets.size());
+		for (int i = 0; i < matches.size(); i++)
+			matches[i] = i;
+	}
+	else {
+		auto addMatches = [&](const std::unordered_map<std::string, std::vector<int>>& table, const std::string& key) {
+			auto result = table.find(key);
+			if (result != table.end())
+				matches.insert(matches.end(), result->second.begin(), result->second.end());
+		};
+
+		addMatches(presetIndex.presetsBySet, sliderSet);
+		for (auto &filter : groupFilter)
+			addMatches(presetIndex.presetsByGroup, filter);
+
+		// Same order as reading the files
+		std::sort(matches.begin(), matches.end());
+		matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
 	}
 
+	for (auto &m : matches)
+		AddPreset(presetIndex.presets[m]->name, presetIndex.presets[m]->preset);
+
 	return 0;
 }
 
 int PresetCollection::SavePreset(const std::string& filePath, const std::string& presetName, const std::string& sliderSetName, std::vector<std::string>& assignGroups) {
-	if (namedSliderPresets.find(presetName) == namedSliderPresets.end())
+	Preset* preset = FindPreset(presetName);
+	if (!preset || !preset->IsListed())
 		return -1;
 
 	XMLElement* newElement = nullptr;
@@ -231,7 +412,12 @@ int PresetCollection::SavePreset(const std::string& filePath, const std::string&
 		sliderElem = presetElem->InsertEndChild(newElement)->ToElement();
 		sliderElem->SetAttribute("name", group.c_str());
 	}
-	for (auto &p : namedSliderPresets[presetName]) {
+	// Sliders are written in name order
+	std::map<std::string, SliderPreset> sliderValues;
+	for (int i = 0; i < preset->sliderIds.size(); i++)
+		sliderValues[GetSliderName(preset->sliderIds[i])] = preset->values[i];
+
+	for (auto &p : sliderValues) {
 		if (p.second.big > -10000.0f) {
 			newElement = outDoc.NewElement("SetSlider");
 			sliderElem = presetElem->InsertEndChild(newElement)->ToElement();
@@ -250,5 +436,12 @@ int PresetCollection::SavePreset(const std::string& filePath, const std::string&
 	if (outDoc.SaveFile(filePath.c_str()) != XML_SUCCESS)
 		return outDoc.ErrorID();
 
+	// Parse the file again on the next load even if its time and size look the same
+	std::lock_guard<std::mutex> lock(presetIndexMutex);
+	presetIndex.files.erase(filePath);
+	presetIndex.fileOrder.clear();
+	presetIndex.presets.clear();
+	presetIndex.presetsBySet.clear();
+	presetIndex.presetsByGroup.clear();
 	return 0;
 }
@@ -7,6 +7,7 @@ See the included LICENSE file
 #pragma once
 
 #include <map>
+#include <string>
 #include <vector>
 
 class SliderPreset {
@@ -16,9 +17,36 @@ public:
 };
 
 class PresetCollection {
-	std::map<std::string, std::map<std::string, SliderPreset>> namedSliderPresets;
-	std::map<std::string, std::string> presetFileNames;
-	std::map<std::string, std::vector<std::string>> presetGroups;
+public:
+	// Slider values of a preset, in flat arrays sorted by slider id.
+	// Slider ids are shared by all collections, see GetSliderId.
+	struct Preset {
+		std::string set;
+		std::string fileName;
+		std::vector<std::string> groups;
+		std::vector<int> sliderIds;
+		std::vector<SliderPreset> values;
+
+		SliderPreset* FindValue(const int sliderId);
+		SliderPreset& AddValue(const int sliderId);
+
+		// Presets read without any slider values only keep their file name and groups, they aren't listed
+		bool IsListed() {
+			return !sliderIds.empty();
+		}
+	};
+
+	// Returns the id of the slider name, adding it if it's new and add is set. Returns -1 for unknown names otherwise.
+	static int GetSliderId(const std::string& sliderName, const bool add = false);
+	static std::string GetSliderName(const int sliderId);
+
+private:
+	std::vector<Preset> presets;
+	std::map<std::string, int> presetIndices;
+
+	Preset* FindPreset(const std::string& presetName);
+	SliderPreset* FindValue(const std::string& presetName, const std::string& sliderName);
+	void AddPreset(const std::string& presetName, const Preset& preset);
 
 public:
 	void Clear();
@@ -33,6 +61,8 @@ public:
 	std::string GetPresetFileName(const std::string& set);
 	void GetPresetGroups(const std::string& set, std::vector<std::string>& outGroups);
 
+	// Presets are read through an index of the parsed files that is shared by all collections.
+	// Only files that changed in modification time or size since the last load are parsed again.
 	bool LoadPresets(const std::string& basePath, const std::string& sliderSet, std::vector<std::string>& groupFilter, bool allPresets = false);
 	int SavePreset(const std::string& filePath, const std::string& presetName, const std::string& sliderSetName, std::vector<std::string>& assignGroups);
 };
@@ -17,21 +17,37 @@ SliderSet::SliderSet(XMLElement* element) {
 }
 
 
+void SliderSet::IndexSliders() {
+	sliderIndices.clear();
+	for (int i = 0; i < sliders.size(); i++)
+		sliderIndices.emplace(sliders[i].name, i);
+}
+
 void SliderSet::DeleteSlider(const std::string& setName) {
-	for (int i = 0; i < sliders.size(); i++) {
-		if (sliders[i].name == setName) {
-			sliders.erase(sliders.begin() + i);
-			return;
-		}
-	}
+	int index = SliderIndex(setName);
+	if (index == -1)
+		return;
+
+	sliders.erase(sliders.begin() + index);
+
+	// Sliders after the deleted one moved down
+	IndexSliders();
+}
+
+void SliderSet::RenameSlider(int index, const std::string& newName) {
+	sliderIndices.erase(sliders[index].name);
+	sliders[index].name = newName;
+	sliderIndices.emplace(newName, index);
 }
 
 int SliderSet::CreateSlider(const std::string& setName) {
+	sliderIndices.emplace(setName, (int)sliders.size());
 	sliders.emplace_back(setName);
 	return sliders.size() - 1;
 }
 
 int SliderSet::CopySlider(SliderData* other) {
+	sliderIndices.emplace(other->name, (int)sliders.size());
 	sliders.emplace_back(other->name);
 	SliderData* ms = &sliders.back();
 	ms->bClamp = other->bClamp;
@@ -98,18 +114,17 @@ int SliderSet::LoadSliderSet(XMLElement* element) {
 		SliderData tmpSlider;
 		if (tmpSlider.LoadSliderData(sliderEntry, genWeights) == 0) {
 			// Check if slider already exists
-			for (auto &s : sliders) {
-				if (s.name == tmpSlider.name) {
-					// Merge data of existing sliders
-					for (auto &df : tmpSlider.dataFiles)
-						s.AddDataFile(df.targetName, df.dataName, df.fileName, df.bLocal);
-
-					break;
-				}
+			int index = SliderIndex(tmpSlider.name);
+			if (index != -1) {
+				// Merge data of existing sliders
+				SliderData& s = sliders[index];
+				for (auto &df : tmpSlider.dataFiles)
+					s.AddDataFile(df.targetName, df.dataName, df.fileName, df.bLocal);
 			}
-
-			if (!SliderExists(tmpSlider.name))
+			else {
+				sliderIndices.emplace(tmpSlider.name, (int)sliders.size());
 				sliders.push_back(std::move(tmpSlider));
+			}
 		}
 
 		sliderEntry = sliderEntry->NextSiblingElement("Slider");
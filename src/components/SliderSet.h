@@ -10,6 +10,8 @@ See the included LICENSE file
 #include "SliderData.h"
 #include "../components/NormalGenLayers.h"
 
+#include <unordered_map>
+
 using namespace tinyxml2;
 
 class SliderSet
@@ -25,10 +27,13 @@ class SliderSet
 	std::map<std::string, std::string> targetdatafolders;
 
 	std::vector<SliderData> sliders;
+	std::unordered_map<std::string, int> sliderIndices;	// Slider names mapped to their position in sliders.
 	std::vector<NormalGenLayer> defNormalGen;
 
 	SliderData Empty;
 
+	void IndexSliders();
+
 public:
 	SliderSet();
 	SliderSet(XMLElement* sliderSetSource);
@@ -61,6 +66,7 @@ public:
 		targetshapenames.clear();
 		targetdatafolders.clear();
 		sliders.clear();
+		sliderIndices.clear();
 	}
 
 
@@ -84,6 +90,9 @@ public:
 
 	void DeleteSlider(const std::string& setName);
 
+	// Renames the slider at the index, the slider names have to stay unique.
+	void RenameSlider(int index, const std::string& newName);
+
 	std::string GetName() {
 		return name;
 	}
@@ -221,19 +230,24 @@ public:
 	}
 
 	SliderData& operator [] (const std::string& sliderName) {
-		for (int i = 0; i < sliders.size(); i++)
-			if (sliders[i].name == sliderName)
-				return sliders[i];
+		int index = SliderIndex(sliderName);
+		if (index != -1)
+			return sliders[index];
 
 		return Empty;			// Err... sorry... this is bad, but I really like returning references.
 	}
 
-	bool SliderExists(const std::string& sliderName) {
-		for (int i = 0; i < sliders.size(); i++)
-			if (sliders[i].name == sliderName)
-				return true;
+	// Returns the index of the slider, or -1 if there is none with that name.
+	int SliderIndex(const std::string& sliderName) {
+		auto it = sliderIndices.find(sliderName);
+		if (it != sliderIndices.end())
+			return it->second;
 
-		return false;
+		return -1;
+	}
+
+	bool SliderExists(const std::string& sliderName) {
+		return sliderIndices.find(sliderName) != sliderIndices.end();
 	}
 };
 
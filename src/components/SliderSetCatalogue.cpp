@@ -0,0 +1,175 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "SliderSetCatalogue.h"
+#include "SliderSet.h"
+
+#include <wx/filename.h>
+
+#include <algorithm>
+
+#ifdef WIN64
+#include <ppl.h>
+#else
+#undef _PPL_H
+#endif
+
+void SliderSetCatalogue::ParseFile(const std::string& fileName, FileInfo& outFile) {
+	outFile.sets.clear();
+
+	SliderSetFile sliderDoc;
+	sliderDoc.Open(fileName);
+	outFile.failed = sliderDoc.fail();
+	if (outFile.failed)
+		return;
+
+	std::vector<std::string> setNames;
+	sliderDoc.GetSetNamesUnsorted(setNames, false);
+
+	outFile.sets.resize(setNames.size());
+	for (int i = 0; i < setNames.size(); i++) {
+		outFile.sets[i].name = setNames[i];
+		sliderDoc.GetSetOutputFilePath(setNames[i], outFile.sets[i].outputFilePath);
+	}
+}
+
+bool SliderSetCatalogue::Update(const std::vector<std::string>& fileNames) {
+	bool changed = fileNames != fileOrder;
+
+	// File times are read up front, only the parsing runs in parallel
+	std::vector<std::string> parseNames;
+	std::vector<FileInfo> parsed;
+	for (auto &fileName : fileNames) {
+		wxFileName fn(fileName);
+		long long modTime = fn.GetModificationTime().GetValue().GetValue();
+		unsigned long long size = fn.GetSize().GetValue();
+
+		auto result = files.find(fileName);
+		if (result != files.end() && result->second.modTime == modTime && result->second.size == size)
+			continue;
+
+		FileInfo file;
+		file.modTime = modTime;
+		file.size = size;
+		parseNames.push_back(fileName);
+		parsed.push_back(std::move(file));
+	}
+
+	auto parseFile = [&](int i) {
+		ParseFile(parseNames[i], parsed[i]);
+	};
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, (int)parseNames.size(), parseFile);
+#else
+	for (int i = 0; i < parseNames.size(); i++)
+		parseFile(i);
+#endif
+
+	for (int i = 0; i < parseNames.size(); i++)
+		files[parseNames[i]] = std::move(parsed[i]);
+
+	if (!parseNames.empty())
+		changed = true;
+
+	// Drop files that were removed
+	if (files.size() > fileNames.size()) {
+		std::map<std::string, FileInfo> existing;
+		for (auto &fileName : fileNames) {
+			auto result = files.find(fileName);
+			if (result != files.end())
+				existing[fileName] = std::move(result->second);
+		}
+		files = std::move(existing);
+		changed = true;
+	}
+
+	fileOrder = fileNames;
+	return changed;
+}
+
+const SliderSetCatalogue::FileInfo* SliderSetCatalogue::GetFile(const std::string& fileName) {
+	auto result = files.find(fileName);
+	if (result == files.end())
+		return nullptr;
+
+	return &result->second;
+}
+
+void SliderSetCatalogue::Clear() {
+	files.clear();
+	fileOrder.clear();
+}
+
+bool SliderSetCatalogue::Load(const std::string& cacheFileName) {
+	Clear();
+
+	XMLDocument doc;
+	if (doc.LoadFile(cacheFileName.c_str()) != XML_SUCCESS)
+		return false;
+
+	XMLElement* root = doc.FirstChildElement("SliderSetCatalogue");
+	if (!root || root->IntAttribute("version") != 1)
+		return false;
+
+	XMLElement* fileElement = root->FirstChildElement("File");
+	while (fileElement) {
+		const char* fileName = fileElement->Attribute("name");
+		if (fileName) {
+			FileInfo& file = files[fileName];
+			file.modTime = fileElement->Int64Attribute("time");
+			file.size = fileElement->Int64Attribute("size");
+			file.failed = fileElement->BoolAttribute("failed");
+
+			XMLElement* setElement = fileElement->FirstChildElement("Set");
+			while (setElement) {
+				const char* setName = setElement->Attribute("name");
+				const char* outputFilePath = setElement->Attribute("output");
+
+				SetInfo set;
+				set.name = setName ? setName : "";
+				set.outputFilePath = outputFilePath ? outputFilePath : "";
+				file.sets.push_back(std::move(set));
+
+				setElement = setElement->NextSiblingElement("Set");
+			}
+
+			fileOrder.push_back(fileName);
+		}
+
+		fileElement = fileElement->NextSiblingElement("File");
+	}
+
+	return true;
+}
+
+bool SliderSetCatalogue::Save(const std::string& cacheFileName) {
+	XMLDocument doc;
+	XMLElement* root = doc.InsertEndChild(doc.NewElement("SliderSetCatalogue"))->ToElement();
+	root->SetAttribute("version", 1);
+
+	for (auto &fileName : fileOrder) {
+		auto result = files.find(fileName);
+		if (result == files.end())
+			continue;
+
+		FileInfo& file = result->second;
+		XMLElement* fileElement = root->InsertEndChild(doc.NewElement("File"))->ToElement();
+		fileElement->SetAttribute("name", fileName.c_str());
+		fileElement->SetAttribute("time", (int64_t)file.modTime);
+		fileElement->SetAttribute("size", (int64_t)file.size);
+		if (file.failed)
+			fileElement->SetAttribute("failed", true);
+
+		for (auto &set : file.sets) {
+			XMLElement* setElement = fileElement->InsertEndChild(doc.NewElement("Set"))->ToElement();
+			setElement->SetAttribute("name", set.name.c_str());
+			setElement->SetAttribute("output", set.outputFilePath.c_str());
+		}
+	}
+
+	return doc.SaveFile(cacheFileName.c_str()) == XML_SUCCESS;
+}
@@ -0,0 +1,53 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Names and output paths of the slider sets in all project files, without keeping the documents around.
+// Files are only parsed again if their modification time or size changed since they were last read.
+// The catalogue can be saved to a cache file, so unchanged files aren't parsed on startup either.
+class SliderSetCatalogue {
+public:
+	struct SetInfo {
+		std::string name;
+		std::string outputFilePath;
+	};
+
+	struct FileInfo {
+		long long modTime = 0;
+		unsigned long long size = 0;
+		bool failed = false;
+		std::vector<SetInfo> sets;
+	};
+
+private:
+	std::map<std::string, FileInfo> files;
+	std::vector<std::string> fileOrder;
+
+	static void ParseFile(const std::string& fileName, FileInfo& outFile);
+
+public:
+	// Brings the catalogue up to date with the files, parsing new and changed ones in parallel.
+	// Returns true if anything changed since the last update.
+	bool Update(const std::vector<std::string>& fileNames);
+
+	// Files of the last update in their order
+	const std::vector<std::string>& GetFiles() {
+		return fileOrder;
+	}
+
+	// Returns nullptr if the file isn't in the catalogue.
+	const FileInfo* GetFile(const std::string& fileName);
+
+	void Clear();
+
+	bool Load(const std::string& cacheFileName);
+	bool Save(const std::string& cacheFileName);
+};
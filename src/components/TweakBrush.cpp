@@ -6,6 +6,12 @@ See the included LICENSE file
 
 #include "TweakBrush.h"
 
+#ifdef WIN64
+	#include <ppl.h>
+#else
+	#undef _PPL_H
+#endif
+
 #pragma warning (disable : 4100)
 
 TweakUndo::TweakUndo() : curState(-1) {
@@ -82,53 +88,46 @@ bool TweakUndo::forwardStroke(const std::vector<mesh*>& validMeshes) {
 
 void TweakStroke::RestoreStartState(mesh* m) {
 	for (auto &stateIt : pointStartState[m]) {
-		if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT)
+		if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT) {
 			m->vcolors[stateIt.first] = stateIt.second;
-		else
+			m->QueueUpdate(mesh::UpdateType::VertexColors, stateIt.first);
+		}
+		else {
 			m->verts[stateIt.first] = stateIt.second;
+			m->QueueUpdate(mesh::UpdateType::Position, stateIt.first);
+		}
 	}
 
 	if (refBrush->Type() != TBT_MASK && refBrush->Type() != TBT_WEIGHT) {
 		m->SmoothNormals();
 
-		if (startBVH[m] == endBVH[m]) {
-			for (auto &bvhNode : affectedNodes[m])
-				bvhNode->UpdateAABB();
-		}
+		if (startBVH[m] == endBVH[m])
+			m->bvh->Refit(affectedNodes[m]);
 		else
 			m->bvh = startBVH[m];
 	}
-
-	if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT)
-		m->QueueUpdate(mesh::UpdateType::VertexColors);
-	else
-		m->QueueUpdate(mesh::UpdateType::Position);
-
 }
 
 void TweakStroke::RestoreEndState(mesh* m) {
 	for (auto &stateIt : pointEndState[m]) {
-		if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT)
+		if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT) {
 			m->vcolors[stateIt.first] = stateIt.second;
-		else
+			m->QueueUpdate(mesh::UpdateType::VertexColors, stateIt.first);
+		}
+		else {
 			m->verts[stateIt.first] = stateIt.second;
+			m->QueueUpdate(mesh::UpdateType::Position, stateIt.first);
+		}
 	}
 
 	if (refBrush->Type() != TBT_MASK && refBrush->Type() != TBT_WEIGHT) {
 		m->SmoothNormals();
 
-		if (startBVH[m] == endBVH[m]) {
-			for (auto &bvhNode : affectedNodes[m])
-				bvhNode->UpdateAABB();
-		}
+		if (startBVH[m] == endBVH[m])
+			m->bvh->Refit(affectedNodes[m]);
 		else
 			m->bvh = endBVH[m];
 	}
-
-	if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT)
-		m->QueueUpdate(mesh::UpdateType::VertexColors);
-	else
-		m->QueueUpdate(mesh::UpdateType::Position);
 }
 
 void TweakStroke::beginStroke(TweakPickInfo& pickInfo) {
@@ -152,8 +151,6 @@ void TweakStroke::beginStroke(TweakPickInfo& pickInfo) {
 }
 
 void TweakStroke::updateStroke(TweakPickInfo& pickInfo) {
-	int brushType = refBrush->Type();
-
 	TweakPickInfo mirrorPick = pickInfo;
 	mirrorPick.origin.x *= -1;
 	mirrorPick.normal.x *= -1;
@@ -174,70 +171,101 @@ void TweakStroke::updateStroke(TweakPickInfo& pickInfo) {
 		}
 	}
 	
+	// Every mesh gets its state up front, so the meshes can be updated in parallel without locking
+	for (auto &m : refMeshes) {
+		refBrush->getCache(m);
+		pointStartState[m];
+		pointEndState[m];
+		affectedNodes[m];
+	}
+
+	std::vector<std::vector<std::future<void>>> meshNormalUpdates(refMeshes.size());
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, (int)refMeshes.size(), [&](int i) {
+		updateMesh(refMeshes[i], pickInfo, mirrorPick, meshNormalUpdates[i]);
+	});
+#else
+	for (int i = 0; i < refMeshes.size(); i++)
+		updateMesh(refMeshes[i], pickInfo, mirrorPick, meshNormalUpdates[i]);
+#endif
+
+	for (auto &updates : meshNormalUpdates)
+		for (auto &pending : updates)
+			normalUpdates.push_back(std::move(pending));
+
+	lastPoint = pickInfo.origin;
+}
+
+void TweakStroke::updateMesh(mesh* m, TweakPickInfo& pickInfo, TweakPickInfo& mirrorPick, std::vector<std::future<void>>& outNormalUpdates) {
+	int brushType = refBrush->Type();
+
+	// Only look up entries that exist already, other meshes are updated at the same time
+	auto& startState = pointStartState.find(m)->second;
+	auto& endState = pointEndState.find(m)->second;
+	auto& nodes = affectedNodes.find(m)->second;
+	Vector3* positions = outPositions.find(m)->second;
+
 	// Move/transform handles most operations differently than other brushes.
 	// Mirroring is done internally, most of the pick info values are ignored.
 	if (brushType == TBT_MOVE || brushType == TBT_XFORM) {
-		for (auto &m : refMeshes) {
-			std::vector<int> facets;
-			int nPts1 = 0;
+		std::vector<int> facets;
+		int nPts1 = 0;
 
-			if (!refBrush->queryPoints(m, pickInfo, nullptr, nPts1, facets, affectedNodes[m]))
-				continue;
+		if (!refBrush->queryPoints(m, pickInfo, nullptr, nPts1, facets, nodes))
+			return;
 
-			refBrush->brushAction(m, pickInfo, nullptr, nPts1, outPositions[m]);
+		refBrush->brushAction(m, pickInfo, nullptr, nPts1, positions);
 
-			int cachedPointIndex = 0;
-			for (int i = 0; i < nPts1; i++) {
-				cachedPointIndex = refBrush->CachedPointIndex(m, i);
-				addPoint(m, cachedPointIndex, outPositions[m][cachedPointIndex]);
-			}
+		int cachedPointIndex = 0;
+		for (int i = 0; i < nPts1; i++) {
+			cachedPointIndex = refBrush->CachedPointIndex(m, i);
+			addPoint(startState, endState, m, cachedPointIndex, positions[cachedPointIndex]);
+		}
 
-			if (refBrush->LiveNormals()) {
-				auto pending = async(std::launch::async, mesh::SmoothNormalsStaticMap, m, pointStartState[m]);
-				normalUpdates.push_back(std::move(pending));
-			}
+		if (refBrush->LiveNormals()) {
+			auto pending = async(std::launch::async, mesh::SmoothNormalsStaticMap, m, startState);
+			outNormalUpdates.push_back(std::move(pending));
 		}
 	}
 	else {
-		for (auto &m : refMeshes) {
-			std::vector<int> facets;
-			std::vector<int> facets2;
-			int nPts1 = 0;
-			int nPts2 = 0;
+		std::vector<int> facets;
+		std::vector<int> facets2;
+		int nPts1 = 0;
+		int nPts2 = 0;
 
-			if (!refBrush->queryPoints(m, pickInfo, pts1[m], nPts1, facets, affectedNodes[m]))
-				continue;
+		int* meshPts1 = pts1.find(m)->second;
+		int* meshPts2 = refBrush->isMirrored() ? pts2.find(m)->second : nullptr;
+
+		if (!refBrush->queryPoints(m, pickInfo, meshPts1, nPts1, facets, nodes))
+			return;
 
-			if (refBrush->isMirrored())
-				refBrush->queryPoints(m, mirrorPick, pts2[m], nPts2, facets2, affectedNodes[m]);
+		if (refBrush->isMirrored())
+			refBrush->queryPoints(m, mirrorPick, meshPts2, nPts2, facets2, nodes);
 
-			refBrush->brushAction(m, pickInfo, pts1[m], nPts1, outPositions[m]);
-			for (int i = 0; i < nPts1; i++)
-				addPoint(m, pts1[m][i], outPositions[m][i]);
+		refBrush->brushAction(m, pickInfo, meshPts1, nPts1, positions);
+		for (int i = 0; i < nPts1; i++)
+			addPoint(startState, endState, m, meshPts1[i], positions[i]);
 
-			if (refBrush->isMirrored())  {
-				refBrush->brushAction(m, mirrorPick, pts2[m], nPts2, outPositions[m]);
-				for (int i = 0; i < nPts2; i++)
-					addPoint(m, pts2[m][i], outPositions[m][i]);
-			}
+		if (refBrush->isMirrored())  {
+			refBrush->brushAction(m, mirrorPick, meshPts2, nPts2, positions);
+			for (int i = 0; i < nPts2; i++)
+				addPoint(startState, endState, m, meshPts2[i], positions[i]);
+		}
 
-			if (refBrush->LiveNormals() && brushType != TBT_WEIGHT && brushType != TBT_MASK) {
-				auto pending1 = std::async(std::launch::async, mesh::SmoothNormalsStaticArray, m, pts1[m], nPts1);
-				normalUpdates.push_back(std::move(pending1));
+		if (refBrush->LiveNormals() && brushType != TBT_WEIGHT && brushType != TBT_MASK) {
+			auto pending1 = std::async(std::launch::async, mesh::SmoothNormalsStaticArray, m, meshPts1, nPts1);
+			outNormalUpdates.push_back(std::move(pending1));
 
-				auto pending2 = async(std::launch::async, mesh::SmoothNormalsStaticArray, m, pts2[m], nPts2);
-				normalUpdates.push_back(std::move(pending2));
+			if (meshPts2) {
+				auto pending2 = async(std::launch::async, mesh::SmoothNormalsStaticArray, m, meshPts2, nPts2);
+				outNormalUpdates.push_back(std::move(pending2));
 			}
 		}
 	}
 
-	lastPoint = pickInfo.origin;
-
-	if (refBrush->LiveBVH() && brushType != TBT_WEIGHT && brushType != TBT_MASK) {
-		for (auto &m : refMeshes)
-			for (auto &bvhNode : affectedNodes[m])
-				bvhNode->UpdateAABB();
-	}
+	if (refBrush->LiveBVH() && brushType != TBT_WEIGHT && brushType != TBT_MASK)
+		m->bvh->Refit(nodes);
 }
 
 void TweakStroke::endStroke() {
@@ -256,8 +284,7 @@ void TweakStroke::endStroke() {
 
 	if (refBrush->Type() != TBT_WEIGHT)
 		for (auto &m : refMeshes)
-			for (auto &bvhNode : affectedNodes[m])
-				bvhNode->UpdateAABB();
+			m->bvh->Refit(affectedNodes[m]);
 
 	if (!refBrush->LiveNormals() || refBrush->Type() == TBT_WEIGHT) {
 		for (auto &m : refMeshes) {
@@ -293,14 +320,17 @@ void TweakStroke::endStroke() {
 }
 
 void TweakStroke::addPoint(mesh* m, int point, Vector3& newPos) {
-	auto& startState = pointStartState[m];
+	addPoint(pointStartState[m], pointEndState[m], m, point, newPos);
+}
+
+void TweakStroke::addPoint(std::unordered_map<int, Vector3>& startState, std::unordered_map<int, Vector3>& endState, mesh* m, int point, Vector3& newPos) {
 	if (startState.find(point) == startState.end())
 		startState[point] = newPos;
 
 	if (refBrush->Type() == TBT_MASK || refBrush->Type() == TBT_WEIGHT)
-		pointEndState[m][point] = m->vcolors[point];
+		endState[point] = m->vcolors[point];
 	else
-		pointEndState[m][point] = m->verts[point];
+		endState[point] = m->verts[point];
 }
 
 TweakBrush::TweakBrush() : radius(0.45f), focus(1.00f), inset(0.00f), strength(0.0015f), spacing(0.015f) {
@@ -367,42 +397,36 @@ void TweakBrush::applyFalloff(Vector3 &deltaVec, float dist) {
 	deltaVec *= p;
 }
 
-bool TweakBrush::queryPoints(mesh *refmesh, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<AABBTree::AABBTreeNode*> &affectedNodes) {
+bool TweakBrush::queryPoints(mesh *refmesh, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<int> &affectedNodes) {
 	std::vector<IntersectResult> IResults;
 
 	if (!refmesh->bvh->IntersectSphere(pickInfo.origin, radius, &IResults))
 		return false;
 
-	bool* pointVisit = (bool*)calloc(refmesh->nVerts, sizeof(bool));
-
-	if (bConnected)
-		refmesh->ConnectedPointsInSphere(pickInfo.origin, radius * radius, pickInfo.facet, nullptr, pointVisit, resultPoints, outResultCount, resultFacets);
-	else
+	if (bConnected) {
+		refmesh->ConnectedPointsInSphere(pickInfo.origin, radius * radius, pickInfo.facet, resultPoints, outResultCount, resultFacets);
+	}
+	else {
+		refmesh->BeginVisit();
 		outResultCount = 0;
+	}
 
 	Triangle t;
 	for (unsigned int i = 0; i < IResults.size(); i++) {
 		if (!bConnected) {
 			resultFacets.push_back(IResults[i].HitFacet);
 			t = refmesh->tris[IResults[i].HitFacet];
-			if (!pointVisit[t.p1]) {
+			if (refmesh->VisitPoint(t.p1))
 				resultPoints[outResultCount++] = t.p1;
-				pointVisit[t.p1] = true;
-			}
-			if (!pointVisit[t.p2]) {
+			if (refmesh->VisitPoint(t.p2))
 				resultPoints[outResultCount++] = t.p2;
-				pointVisit[t.p2] = true;
-			}
-			if (!pointVisit[t.p3]) {
+			if (refmesh->VisitPoint(t.p3))
 				resultPoints[outResultCount++] = t.p3;
-				pointVisit[t.p3] = true;
-			}
 
 		}
 		affectedNodes.insert(IResults[i].bvhNode);
 	}
 
-	free(pointVisit);
 	return true;
 }
 
@@ -427,7 +451,7 @@ void TweakBrush::brushAction(mesh *refmesh, TweakPickInfo& pickInfo, int* points
 		refmesh->verts[points[i]] = (vf);
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::Position);
+	refmesh->QueueUpdate(mesh::UpdateType::Position, points, nPoints);
 }
 
 void TweakBrush::brushAction(mesh *refmesh, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints) {
@@ -451,7 +475,7 @@ void TweakBrush::brushAction(mesh *refmesh, TweakPickInfo& pickInfo, int* points
 		refmesh->verts[points[i]] = (vf);
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::Position);
+	refmesh->QueueUpdate(mesh::UpdateType::Position, points, nPoints);
 }
 
 TB_Mask::TB_Mask() :TweakBrush() {
@@ -492,7 +516,7 @@ void TB_Mask::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points, i
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 	
 void TB_Mask::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints) {
@@ -523,7 +547,7 @@ void TB_Mask::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points, i
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 
 TB_Unmask::TB_Unmask() :TweakBrush() {
@@ -564,7 +588,7 @@ void TB_Unmask::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points,
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 
 void TB_Unmask::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints) {
@@ -595,7 +619,7 @@ void TB_Unmask::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points,
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 	
 TB_Deflate::TB_Deflate() :TweakBrush() {
@@ -621,7 +645,6 @@ TB_Smooth::TB_Smooth() :TweakBrush() {
 	hcAlpha = 0.2f;
 	hcBeta = 0.5f;
 	bMirror = false;
-	lastMesh = nullptr;
 	brushName = "Smooth Brush";
 }
 
@@ -667,11 +690,9 @@ void TB_Smooth::lapFilter(mesh* refmesh, int* points, int nPoints, std::unordere
 void TB_Smooth::hclapFilter(mesh* refmesh, int* points, int nPoints, std::unordered_map <int, Vector3>& wv) {
 	std::unordered_map<int, Vector3>::iterator mi;
 
-	b.resize(refmesh->nVerts);
-	if (refmesh != lastMesh)
-		lastMesh = refmesh;
-	else
-		memset(b.data(), 0, b.size() * sizeof(Vector3));
+	// Per mesh, so different meshes can be smoothed at the same time
+	std::vector<Vector3>& b = getCache(refmesh)->smoothScratch;
+	b.assign(refmesh->nVerts, Vector3());
 
 	Vector3 d;
 	Vector3 q;
@@ -768,7 +789,7 @@ void TB_Smooth::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points,
 			refmesh->verts[i] += delta;
 		}
 
-		refmesh->QueueUpdate(mesh::UpdateType::Position);
+		refmesh->QueueUpdate(mesh::UpdateType::Position, points, nPoints);
 	}
 }
 
@@ -802,7 +823,7 @@ void TB_Smooth::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points,
 			refmesh->verts[i] += delta;
 		}
 
-		refmesh->QueueUpdate(mesh::UpdateType::Position);
+		refmesh->QueueUpdate(mesh::UpdateType::Position, points, nPoints);
 	}
 }
 
@@ -854,8 +875,8 @@ bool TB_Move::strokeInit(const std::vector<mesh*>& refMeshes, TweakPickInfo& pic
 	return true;
 }
 
-bool TB_Move::queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<AABBTree::AABBTreeNode*>& affectedNodes) {
-	TweakBrushMeshCache* meshCache = &cache[m];
+bool TB_Move::queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<int>& affectedNodes) {
+	TweakBrushMeshCache* meshCache = getCache(m);
 	if (meshCache->nCachedPoints == 0)
 		return false;
 
@@ -880,7 +901,7 @@ void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPo
 	Vector3 ve;
 	Vector3 vf;
 
-	TweakBrushMeshCache* meshCache = &cache[m];
+	TweakBrushMeshCache* meshCache = getCache(m);
 	if (bMirror) {
 		Vector3 lmo;
 		lmo.x = -pickInfo.origin.x;	lmo.y = pickInfo.origin.y; lmo.z = pickInfo.origin.z;
@@ -903,6 +924,8 @@ void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPo
 
 			m->verts[i] = (vf);
 		}
+
+		m->QueueUpdate(mesh::UpdateType::Position, meshCache->cachedPointsM, meshCache->nCachedPointsM);
 	}
 
 	for (int p = 0; p < meshCache->nCachedPoints; p++) {
@@ -919,7 +942,7 @@ void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPo
 		m->verts[i] = (vf);
 	}
 
-	m->QueueUpdate(mesh::UpdateType::Position);
+	m->QueueUpdate(mesh::UpdateType::Position, meshCache->cachedPoints, meshCache->nCachedPoints);
 }
 
 void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints) {
@@ -933,7 +956,7 @@ void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPo
 	Vector3 ve;
 	Vector3 vf;
 
-	TweakBrushMeshCache* meshCache = &cache[m];
+	TweakBrushMeshCache* meshCache = getCache(m);
 	if (bMirror) {
 		Vector3 lmo;
 		lmo.x = -pickInfo.origin.x;
@@ -958,6 +981,8 @@ void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPo
 
 			m->verts[i] = (vf);
 		}
+
+		m->QueueUpdate(mesh::UpdateType::Position, meshCache->cachedPointsM, meshCache->nCachedPointsM);
 	}
 
 	for (int p = 0; p < meshCache->nCachedPoints; p++) {
@@ -974,7 +999,7 @@ void TB_Move::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPo
 		m->verts[i] = (vf);
 	}
 
-	m->QueueUpdate(mesh::UpdateType::Position);
+	m->QueueUpdate(mesh::UpdateType::Position, meshCache->cachedPoints, meshCache->nCachedPoints);
 }
 
 void TB_Move::GetWorkingPlane(Vector3& outPlaneNormal, float& outPlaneDist) {
@@ -1013,8 +1038,8 @@ bool TB_XForm::strokeInit(const std::vector<mesh*>& refMeshes, TweakPickInfo& pi
 	return true;
 }
 
-bool TB_XForm::queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<AABBTree::AABBTreeNode*>& affectedNodes) {
-	TweakBrushMeshCache* meshCache = &cache[m];
+bool TB_XForm::queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<int>& affectedNodes) {
+	TweakBrushMeshCache* meshCache = getCache(m);
 	if (meshCache->nCachedPoints == 0)
 		return false;
 
@@ -1043,7 +1068,7 @@ void TB_XForm::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nP
 	Vector3 ve;
 	Vector3 vf;
 
-	TweakBrushMeshCache* meshCache = &cache[m];
+	TweakBrushMeshCache* meshCache = getCache(m);
 	for (int p = 0; p < meshCache->nCachedPoints; p++) {
 		vs = meshCache->cachedPositions[p];
 		movedpoints[p] = vs;
@@ -1116,7 +1141,7 @@ void TB_XForm::brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nP
 	Vector3 ve;
 	Vector3 vf;
 
-	TweakBrushMeshCache* meshCache = &cache[m];
+	TweakBrushMeshCache* meshCache = getCache(m);
 	for (int p = 0; p < meshCache->nCachedPoints; p++) {
 		vs = meshCache->cachedPositions[p];
 		movedpoints[p] = vs;
@@ -1164,7 +1189,7 @@ void TB_Weight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points,
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 
 void TB_Weight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints) {
@@ -1189,7 +1214,7 @@ void TB_Weight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points,
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 
 TB_Unweight::TB_Unweight() :TweakBrush() {
@@ -1223,7 +1248,7 @@ void TB_Unweight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* point
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 
 void TB_Unweight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints) {
@@ -1248,7 +1273,7 @@ void TB_Unweight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* point
 		refmesh->vcolors[points[i]] = vf;
 	}
 
-	refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+	refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 }
 
 TB_SmoothWeight::TB_SmoothWeight() :TweakBrush() {
@@ -1259,7 +1284,6 @@ TB_SmoothWeight::TB_SmoothWeight() :TweakBrush() {
 	hcAlpha = 0.2f;
 	hcBeta = 0.5f;
 	bMirror = false;
-	lastMesh = nullptr;
 	brushName = "Weight Smooth";
 }
 
@@ -1303,11 +1327,9 @@ void TB_SmoothWeight::lapFilter(mesh* refmesh, int* points, int nPoints, std::un
 void TB_SmoothWeight::hclapFilter(mesh* refmesh, int* points, int nPoints, std::unordered_map<int, Vector3>& wv) {
 	std::unordered_map<int, Vector3>::iterator mi;
 
-	b.resize(refmesh->nVerts);
-	if (refmesh != lastMesh)
-		lastMesh = refmesh;
-	else
-		memset(b.data(), 0, b.size() * sizeof(Vector3));
+	// Per mesh, so different meshes can be smoothed at the same time
+	std::vector<Vector3>& b = getCache(refmesh)->smoothScratch;
+	b.assign(refmesh->nVerts, Vector3());
 
 	Vector3 d;
 	Vector3 q;
@@ -1409,7 +1431,7 @@ void TB_SmoothWeight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* p
 			refmesh->vcolors[i].y = vc.y;
 		}
 
-		refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+		refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 	}
 }
 
@@ -1449,6 +1471,6 @@ void TB_SmoothWeight::brushAction(mesh* refmesh, TweakPickInfo& pickInfo, int* p
 			refmesh->vcolors[i].y = vc.y;
 		}
 
-		refmesh->QueueUpdate(mesh::UpdateType::VertexColors);
+		refmesh->QueueUpdate(mesh::UpdateType::VertexColors, points, nPoints);
 	}
 }
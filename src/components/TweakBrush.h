@@ -93,8 +93,9 @@ public:
 	int nCachedPointsM = 0;
 	std::vector<int> cachedFacetsM;
 	std::unordered_map<int, Vector3> cachedPositions;
-	std::unordered_set<AABBTree::AABBTreeNode*> cachedNodes;
-	std::unordered_set<AABBTree::AABBTreeNode*> cachedNodesM;
+	std::unordered_set<int> cachedNodes;
+	std::unordered_set<int> cachedNodesM;
+	std::vector<Vector3> smoothScratch;		// Scratch space used in the hc-lap smooth filters.
 
 	TweakBrushMeshCache() {}
 
@@ -134,7 +135,12 @@ public:
 		return brushName;
 	}
 
+	// Only inserts on the first call for a mesh. After that, different meshes can use their caches in parallel.
 	TweakBrushMeshCache* getCache(mesh* m) {
+		auto it = cache.find(m);
+		if (it != cache.end())
+			return &it->second;
+
 		return &cache[m];
 	}
 
@@ -206,7 +212,7 @@ public:
 	// Also optionally, the query can return only connected points within the sphere.
 	//virtual bool queryPoints (mesh* refmesh, TweakPickInfo& pickInfo, set<int>& resultPoints, vector<int>& resultFacets, set<AABBTree::AABBTreeNode*>& affectedNodes);
 
-	virtual bool queryPoints(mesh *refmesh, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<AABBTree::AABBTreeNode*> &affectedNodes);
+	virtual bool queryPoints(mesh *refmesh, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<int> &affectedNodes);
 
 	// Apply the brush effect to the mesh, modifying the points in the set provided.
 	// Overridden versions should return the original point positions in the movedpoints map.
@@ -265,9 +271,6 @@ class TB_Smooth : public TweakBrush {
 	float hcAlpha;				// Blending constants.
 	float hcBeta;
 
-	std::vector<Vector3> b;		// Scratch space used in the hc-lap smooth filter.
-	mesh* lastMesh;				// Last mesh smoothed, used to sync the hc-lap smooth scratch space.
-
 	// Laplacian smoothing filter. Points are the set of point indices into refmesh to smooth.
 	// wv is the current position of those points. This function can be called iteratively, reusing wv.
 	void lapFilter(mesh* refmesh, int* points, int nPoints, std::unordered_map<int, Vector3>& wv);
@@ -302,7 +305,7 @@ public:
 	virtual ~TB_Move();
 
 	virtual bool strokeInit(const std::vector<mesh*>& refMeshes, TweakPickInfo& pickInfo);
-	virtual bool queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<AABBTree::AABBTreeNode*>& affectedNodes);
+	virtual bool queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<int>& affectedNodes);
 	virtual void brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPoints, std::unordered_map<int, Vector3>& movedpoints);
 	virtual void brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints);
 	virtual bool checkSpacing(Vector3&, Vector3&) {
@@ -311,7 +314,7 @@ public:
 
 	void GetWorkingPlane(Vector3& outPlaneNormal, float& outPlaneDist);
 	int CachedPointIndex(mesh* m, int query) {
-		TweakBrushMeshCache* meshCache = &cache[m];
+		TweakBrushMeshCache* meshCache = getCache(m);
 		if (query >= meshCache->nCachedPoints)
 			return meshCache->cachedPointsM[query - meshCache->nCachedPoints];
 		else
@@ -337,7 +340,7 @@ public:
 	}
 
 	virtual bool strokeInit(const std::vector<mesh*>& refMeshes, TweakPickInfo& pickInfo);
-	virtual bool queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<AABBTree::AABBTreeNode*>& affectedNodes);
+	virtual bool queryPoints(mesh* m, TweakPickInfo& pickInfo, int* resultPoints, int& outResultCount, std::vector<int>& resultFacets, std::unordered_set<int>& affectedNodes);
 	virtual void brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPoints, std::unordered_map<int, Vector3>& movedpoints);
 	virtual void brushAction(mesh* m, TweakPickInfo& pickInfo, int* points, int nPoints, Vector3* movedpoints);
 	virtual bool checkSpacing(Vector3&, Vector3&) {
@@ -384,9 +387,6 @@ public:
 	float hcAlpha;				// Blending constants.
 	float hcBeta;
 
-	std::vector<Vector3> b;		// Scratch space used in the hc-lap smooth filter.
-	mesh* lastMesh;				// Last mesh smoothed, used to sync the hc-lap smooth scratch space.
-
 	void lapFilter(mesh* refmesh, int* points, int nPoints, std::unordered_map<int, Vector3>& wv);
 	void hclapFilter(mesh* refmesh, int* points, int nPoints, std::unordered_map<int, Vector3>& wv);
 
@@ -419,6 +419,11 @@ class TweakStroke {
 	std::unordered_map<mesh*, int*> pts1;
 	std::unordered_map<mesh*, int*> pts2;
 
+	// Queries, deforms and refits one mesh of the stroke. Only touches the state of that mesh,
+	// so the meshes of a stroke are updated in parallel.
+	void updateMesh(mesh* m, TweakPickInfo& pickInfo, TweakPickInfo& mirrorPick, std::vector<std::future<void>>& outNormalUpdates);
+	void addPoint(std::unordered_map<int, Vector3>& startState, std::unordered_map<int, Vector3>& endState, mesh* m, int point, Vector3& newPos);
+
 	// When the mesh BVH is recalculated, historical BVH nodes are broken.
 	// This lets us keep the undo history at the cost of forcing a full recalc for each undo/redo.
 	bool bvhValid = true;
@@ -443,7 +448,7 @@ public:
 
 	std::unordered_map<mesh*, std::unordered_map<int, Vector3>> pointStartState;
 	std::unordered_map<mesh*, std::unordered_map<int, Vector3>> pointEndState;
-	std::unordered_map<mesh*, std::unordered_set<AABBTree::AABBTreeNode*>> affectedNodes;
+	std::unordered_map<mesh*, std::unordered_set<int>> affectedNodes;
 
 	void addPoint(mesh* m, int point, Vector3& newPos);
 
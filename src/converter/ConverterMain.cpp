@@ -0,0 +1,82 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "SSEConverter.h"
+
+#include <wx/init.h>
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+	{ wxCMD_LINE_PARAM, nullptr, nullptr, "directory or archive with the meshes to convert to Skyrim Special Edition", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "o", "out", "output directory of the conversion, defaults to the input path with _SSE appended", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "t", "threads", "number of files converted at the same time, defaults to the number of hardware threads", wxCMD_LINE_VAL_NUMBER },
+	{ wxCMD_LINE_SWITCH, "hp", "headparts", "treats the converted meshes as head parts" },
+	{ wxCMD_LINE_NONE }
+};
+
+// Converts the meshes of a directory or archive, exits with 1 if any of them failed.
+int main(int argc, char** argv) {
+	wxInitializer initializer(argc, argv);
+	if (!initializer.IsOk())
+		return 1;
+
+	wxCmdLineParser parser(g_cmdLineDesc, argc, argv);
+	if (parser.Parse() != 0)
+		return 1;
+
+	wxString input = parser.GetParam(0);
+	wxFileName inputFile(input);
+	bool isArchive = inputFile.FileExists();
+
+	wxString outputDir;
+	if (!parser.Found("o", &outputDir)) {
+		if (isArchive)
+			outputDir = inputFile.GetPath() + "\\" + inputFile.GetName() + "_SSE";
+		else
+			outputDir = input.BeforeLast('\\') + "\\" + input.AfterLast('\\') + "_SSE";
+	}
+
+	long threads = 0;
+	parser.Found("t", &threads);
+
+	OptOptionsSSE options;
+	options.headParts = parser.Found("hp");
+
+	SSEConverter converter(outputDir.ToStdString(), options, threads);
+	if (isArchive) {
+		if (converter.AddArchive(input.ToStdString()) < 0) {
+			wxLogError("Failed to open archive '%s'.", input);
+			return 1;
+		}
+	}
+	else
+		converter.AddDirectory(input.ToStdString());
+
+	// The report of the previous run is used to skip unchanged files
+	wxString reportFile = outputDir + "\\SSEConversion.xml";
+	converter.LoadReport(reportFile.ToStdString());
+
+	wxLogMessage("Converting meshes in '%s' to '%s'...", input, outputDir);
+	converter.Convert();
+
+	for (auto &r : converter.GetResults()) {
+		if (r.error != SSEConverter::NoError)
+			wxLogWarning("Failed to convert '%s' (%d).", r.fileName, r.error);
+		else if (r.result.versionMismatch)
+			wxLogMessage("Skipped '%s', it's not a Skyrim mesh.", r.fileName);
+	}
+
+	wxLogMessage("Processed %zu meshes, %d unchanged, %d failed.", converter.GetResults().size(), converter.GetSkippedCount(), converter.GetErrorCount());
+
+	if (!converter.SaveReport(reportFile.ToStdString())) {
+		wxLogError("Failed to write conversion report '%s'.", reportFile);
+		return 1;
+	}
+
+	return converter.GetErrorCount() > 0 ? 1 : 0;
+}
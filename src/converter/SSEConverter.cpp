@@ -0,0 +1,285 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "SSEConverter.h"
+#include "../TinyXML-2/tinyxml2.h"
+#include "../FSEngine/FSEngine.h"
+
+#include <wx/dir.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <thread>
+
+using namespace tinyxml2;
+
+SSEConverter::SSEConverter(const std::string& outputDir, const OptOptionsSSE& options, const int maxThreads) {
+	this->outputDir = outputDir;
+	this->options = options;
+
+	if (maxThreads > 0)
+		this->maxThreads = maxThreads;
+	else
+		this->maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+SSEConverter::~SSEConverter() {
+}
+
+bool SSEConverter::IsMeshFile(const std::string& fileName) {
+	size_t dot = fileName.rfind('.');
+	if (dot == std::string::npos)
+		return false;
+
+	std::string ext = fileName.substr(dot);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	return ext == ".nif" || ext == ".bto" || ext == ".btr";
+}
+
+unsigned long long SSEConverter::HashData(const std::vector<char>& data) {
+	// FNV-1a over the file data, followed by the options so that changing them converts everything again
+	unsigned long long hash = 14695981039346656037ULL;
+	for (auto &c : data) {
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	unsigned char opts[] = { options.headParts, options.removeParallax };
+	for (auto &c : opts) {
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+std::string SSEConverter::GetOutputPath(const Source& source) {
+	std::string fileName = source.fileName;
+	std::replace(fileName.begin(), fileName.end(), '/', '\\');
+	return outputDir + "\\" + fileName;
+}
+
+int SSEConverter::AddDirectory(const std::string& dir) {
+	wxString basePath = dir;
+	wxArrayString files;
+	wxDir::GetAllFiles(basePath, &files);
+	files.Sort();
+
+	int added = 0;
+	for (auto &file : files) {
+		std::string filePath = file.ToStdString();
+		if (!IsMeshFile(filePath))
+			continue;
+
+		Source source;
+		source.filePath = filePath;
+		source.fileName = filePath.substr(basePath.length());
+		source.fileName.erase(0, source.fileName.find_first_not_of("\\/"));
+		sources.push_back(source);
+		added++;
+	}
+
+	return added;
+}
+
+int SSEConverter::AddArchive(const std::string& archiveFile) {
+	FSArchiveHandler* handler = FSArchiveHandler::openArchive(archiveFile);
+	if (!handler)
+		return -1;
+
+	archives.emplace_back(handler);
+
+	std::vector<std::string> tree;
+	handler->getArchive()->fileTree(tree);
+	std::sort(tree.begin(), tree.end());
+
+	int added = 0;
+	for (auto &file : tree) {
+		if (!IsMeshFile(file) || !handler->getArchive()->hasFile(file))
+			continue;
+
+		Source source;
+		source.fileName = file;
+		source.archive = handler;
+		sources.push_back(source);
+		added++;
+	}
+
+	return added;
+}
+
+bool SSEConverter::LoadReport(const std::string& reportFile) {
+	XMLDocument doc;
+	if (doc.LoadFile(reportFile.c_str()) != XML_SUCCESS)
+		return false;
+
+	XMLElement* root = doc.FirstChildElement("SSEConversion");
+	if (!root)
+		return false;
+
+	XMLElement* fileElement = root->FirstChildElement("File");
+	while (fileElement) {
+		const char* name = fileElement->Attribute("name");
+		const char* hash = fileElement->Attribute("hash");
+		if (name && hash && fileElement->IntAttribute("error") == NoError)
+			previousHashes[name] = std::strtoull(hash, nullptr, 16);
+
+		fileElement = fileElement->NextSiblingElement("File");
+	}
+
+	return true;
+}
+
+bool SSEConverter::ReadSource(const Source& source, std::vector<char>& outData) {
+	if (source.archive) {
+		// Archive reads are serialized by the archive itself
+		wxMemoryBuffer buffer;
+		if (!source.archive->getArchive()->fileContents(source.fileName, buffer))
+			return false;
+
+		char* data = (char*)buffer.GetData();
+		outData.assign(data, data + buffer.GetDataLen());
+		return true;
+	}
+
+	std::ifstream file(source.filePath, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	outData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+void SSEConverter::ConvertFile(const Source& source, FileResult& result) {
+	result.fileName = source.fileName;
+
+	std::vector<char> data;
+	if (!ReadSource(source, data)) {
+		result.error = ReadError;
+		return;
+	}
+
+	result.hash = HashData(data);
+
+	std::string outputPath = GetOutputPath(source);
+	auto prev = previousHashes.find(source.fileName);
+	if (prev != previousHashes.end() && prev->second == result.hash && wxFileName::FileExists(outputPath)) {
+		result.skipped = true;
+		return;
+	}
+
+	NifFile nif;
+	NiMemoryBuf dataBuf(data.data(), data.size());
+	std::iostream dataStream(&dataBuf);
+	if (nif.Load(dataStream, source.fileName)) {
+		result.error = LoadError;
+		return;
+	}
+
+	// The input data isn't needed anymore while optimizing and saving
+	std::vector<char>().swap(data);
+
+	result.result = nif.OptimizeForSSE(options);
+	if (result.result.versionMismatch)
+		return;
+
+	if (nif.Save(outputPath))
+		result.error = SaveError;
+}
+
+void SSEConverter::Convert() {
+	results.clear();
+	results.resize(sources.size());
+
+	// Output folders are created up front, the workers only write files
+	for (auto &source : sources) {
+		wxFileName outputFile(GetOutputPath(source));
+		if (!outputFile.DirExists())
+			wxFileName::Mkdir(outputFile.GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+	}
+
+	// Make sure the block factories exist before the workers start loading
+	NiFactoryRegister::GetNiFactoryRegister();
+
+	std::atomic<int> nextSource(0);
+	auto worker = [&]() {
+		int i;
+		while ((i = nextSource++) < (int)sources.size())
+			ConvertFile(sources[i], results[i]);
+	};
+
+	int numWorkers = std::min(maxThreads, (int)sources.size());
+	std::vector<std::future<void>> workers;
+	for (int i = 0; i < numWorkers; i++)
+		workers.push_back(std::async(std::launch::async, worker));
+
+	for (auto &w : workers)
+		w.get();
+}
+
+int SSEConverter::GetErrorCount() {
+	int errors = 0;
+	for (auto &r : results)
+		if (r.error != NoError)
+			errors++;
+
+	return errors;
+}
+
+int SSEConverter::GetSkippedCount() {
+	int skipped = 0;
+	for (auto &r : results)
+		if (r.skipped)
+			skipped++;
+
+	return skipped;
+}
+
+bool SSEConverter::SaveReport(const std::string& reportFile) {
+	XMLDocument doc;
+	XMLElement* root = doc.NewElement("SSEConversion");
+	doc.InsertEndChild(root);
+
+	auto addShapes = [&](XMLElement* parent, const char* name, const std::vector<std::string>& shapes) {
+		for (auto &s : shapes) {
+			XMLElement* shapeElement = doc.NewElement(name);
+			shapeElement->SetAttribute("shape", s.c_str());
+			parent->InsertEndChild(shapeElement);
+		}
+	};
+
+	for (auto &r : results) {
+		XMLElement* fileElement = doc.NewElement("File");
+		fileElement->SetAttribute("name", r.fileName.c_str());
+
+		char hash[17];
+		snprintf(hash, sizeof(hash), "%016llx", r.hash);
+		fileElement->SetAttribute("hash", hash);
+		fileElement->SetAttribute("error", r.error);
+
+		if (r.skipped)
+			fileElement->SetAttribute("skipped", "true");
+		if (r.result.versionMismatch)
+			fileElement->SetAttribute("versionMismatch", "true");
+		if (r.result.dupesRenamed)
+			fileElement->SetAttribute("dupesRenamed", "true");
+
+		addShapes(fileElement, "VertexColorsRemoved", r.result.shapesVColorsRemoved);
+		addShapes(fileElement, "NormalsRemoved", r.result.shapesNormalsRemoved);
+		addShapes(fileElement, "PartitionsTriangulated", r.result.shapesPartTriangulated);
+		addShapes(fileElement, "TangentsAdded", r.result.shapesTangentsAdded);
+		addShapes(fileElement, "ParallaxRemoved", r.result.shapesParallaxRemoved);
+
+		root->InsertEndChild(fileElement);
+	}
+
+	return doc.SaveFile(reportFile.c_str()) == XML_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../NIF/NifFile.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class FSArchiveHandler;
+
+// Converts Skyrim meshes to Skyrim Special Edition with NifFile::OptimizeForSSE.
+// A fixed number of workers each read, optimize and save one file at a time, so no more than that many
+// files are held in memory. The report of a run keeps a hash of every input file, and files whose
+// hash didn't change since are skipped when the report is loaded again before the next run.
+class SSEConverter {
+public:
+	enum FileError {
+		NoError,
+		ReadError,
+		LoadError,
+		SaveError
+	};
+
+	struct FileResult {
+		std::string fileName;
+		unsigned long long hash = 0;
+		int error = NoError;
+		bool skipped = false;
+		OptResultSSE result;
+	};
+
+private:
+	struct Source {
+		std::string fileName;		// Relative to the input folder or archive, also used for the output file
+		std::string filePath;		// Loose file, empty for files in archives
+		FSArchiveHandler* archive = nullptr;
+	};
+
+	std::string outputDir;
+	OptOptionsSSE options;
+	int maxThreads = 1;
+
+	std::vector<Source> sources;
+	std::vector<std::unique_ptr<FSArchiveHandler>> archives;
+	std::map<std::string, unsigned long long> previousHashes;
+	std::vector<FileResult> results;
+
+	static bool IsMeshFile(const std::string& fileName);
+	unsigned long long HashData(const std::vector<char>& data);
+	std::string GetOutputPath(const Source& source);
+	bool ReadSource(const Source& source, std::vector<char>& outData);
+	void ConvertFile(const Source& source, FileResult& result);
+
+public:
+	// With maxThreads at 0, one worker per hardware thread is used.
+	SSEConverter(const std::string& outputDir, const OptOptionsSSE& options = OptOptionsSSE(), const int maxThreads = 0);
+	~SSEConverter();
+
+	// Adds all meshes in the folder and its subfolders. Returns the number of files added.
+	int AddDirectory(const std::string& dir);
+
+	// Adds all meshes in a BSA or BA2 archive. Returns the number of files added, or -1 if the archive can't be opened.
+	int AddArchive(const std::string& archiveFile);
+
+	// Reads the file hashes of a previous report, files that still match them are skipped.
+	bool LoadReport(const std::string& reportFile);
+
+	// Converts all added files. Results are in the order the files were added.
+	void Convert();
+
+	const std::vector<FileResult>& GetResults() { return results; }
+	int GetErrorCount();
+	int GetSkippedCount();
+
+	bool SaveReport(const std::string& reportFile);
+};
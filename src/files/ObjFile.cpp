@@ -6,6 +6,16 @@ See the included LICENSE file
 
 #include "ObjFile.h"
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#ifdef WIN64
+	#include <ppl.h>
+#else
+	#undef _PPL_H
+#endif
+
 ObjFile::ObjFile() {
 	scale = Vector3(1.0f, 1.0f, 1.0f);
 	uvDupThreshold = 0.005f;
@@ -41,139 +51,411 @@ int ObjFile::LoadForNif(const std::string& fileName) {
 }
 
 int ObjFile::LoadForNif(std::fstream& base) {
-	ObjData* di = new ObjData();
+	// Read the rest of the file at once
+	std::streampos start = base.tellg();
+	base.seekg(0, std::ios_base::end);
+	std::streamoff size = base.tellg() - start;
+	base.seekg(start);
+
+	std::vector<char> buffer;
+	if (size > 0) {
+		buffer.resize(size);
+		base.read(&buffer[0], size);
+		buffer.resize(base.gcount());
+	}
 
-	Vector3 v;
-	Vector2 uv;
-	Vector2 uv2;
-	Triangle t;
-
-	std::string dump;
-	std::string curgrp;
-	std::string facept1;
-	std::string facept2;
-	std::string facept3;
-	std::string facept4;
-	int f[4];
-	int ft[4];
-	int nPoints = 0;
-	int v_idx[4];
+	return LoadForNif(buffer.data(), buffer.size());
+}
 
-	std::vector<Vector3> verts;
-	std::vector<Vector2> uvs;
-	size_t pos;
-	std::map<int, std::vector<VertUV>> vertMap;
-	std::map<int, std::vector<VertUV>>::iterator savedVert;
+namespace {
+	struct ObjCorner {
+		int v;
+		int uv;
+	};
+
+	struct ObjGroupStart {
+		std::string name;
+		int face;
+	};
+
+	// Everything read from one range of lines. Indices in faces are still file-wide.
+	struct ObjChunk {
+		std::vector<Vector3> verts;
+		std::vector<Vector2> uvs;
+		std::vector<ObjCorner> corners;
+		std::vector<int> faceSizes;
+		std::vector<ObjGroupStart> groups;
+	};
+
+	inline bool IsSpace(const char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
 
-	bool gotface = false;
+	inline const char* SkipSpace(const char* p, const char* end) {
+		while (p < end && IsSpace(*p))
+			p++;
+		return p;
+	}
 
-	while (!base.eof()) {
-		if (!gotface)
-			base >> dump;
-		else
-			gotface = false;
+	inline const char* TokenEnd(const char* p, const char* end) {
+		while (p < end && !IsSpace(*p))
+			p++;
+		return p;
+	}
 
-		if (dump.compare("v") == 0) {
-			base >> v.x >> v.y >> v.z;
-			verts.push_back(v);
+	const char* ParseInt(const char* p, const char* end, int& out) {
+		bool neg = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			neg = (*p++ == '-');
+
+		const char* digits = p;
+		long long value = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			if (value < 0x7FFFFFFF)
+				value = value * 10 + (*p - '0');
+			p++;
 		}
-		else if (dump.compare("g") == 0 || dump.compare("o") == 0) {
-			base >> curgrp;
 
-			if (!di->name.empty()) {
-				data[di->name] = di;
-				di = new ObjData;
+		if (p == digits)
+			return nullptr;
+
+		out = (int)std::min(value, 0x7FFFFFFFLL);
+		if (neg)
+			out = -out;
+		return p;
+	}
+
+	// Locale independent float parsing. Numbers with up to 15 significant digits and a small exponent are
+	// calculated with a single rounded double operation. Rounding that double to a float again only gives a
+	// different result than rounding the number directly if it lies exactly halfway between two floats.
+	// Those and anything else go through a classic locale stream.
+	const char* ParseFloat(const char* p, const char* end, float& out) {
+		static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		const char* start = p;
+		bool neg = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			neg = (*p++ == '-');
+
+		unsigned long long mantissa = 0;
+		int numDigits = 0;
+		int exponent = 0;
+		bool anyDigits = false;
+
+		while (p < end && *p == '0') {
+			anyDigits = true;
+			p++;
+		}
+
+		while (p < end && *p >= '0' && *p <= '9') {
+			if (numDigits < 19)
+				mantissa = mantissa * 10 + (*p - '0');
+			else
+				exponent++;
+			numDigits++;
+			anyDigits = true;
+			p++;
+		}
+
+		if (p < end && *p == '.') {
+			p++;
+			if (mantissa == 0) {
+				while (p < end && *p == '0') {
+					exponent--;
+					anyDigits = true;
+					p++;
+				}
 			}
 
-			di->name = curgrp;
-			objGroups.push_back(curgrp);
+			while (p < end && *p >= '0' && *p <= '9') {
+				if (numDigits < 19) {
+					mantissa = mantissa * 10 + (*p - '0');
+					exponent--;
+				}
+				numDigits++;
+				anyDigits = true;
+				p++;
+			}
 		}
-		else if (dump.compare("vt") == 0) {
-			base >> uv.u >> uv.v;
-			uv.v = 1.0f - uv.v;
-			uvs.push_back(uv);
+
+		if (!anyDigits)
+			return nullptr;
+
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			int expValue = 0;
+			const char* expEnd = ParseInt(p + 1, end, expValue);
+			if (expEnd) {
+				exponent += expValue;
+				p = expEnd;
+			}
 		}
-		else if (dump.compare("f") == 0) {
-			base >> facept1 >> facept2 >> facept3;
-			pos = facept1.find('/');
-			f[0] = atoi(facept1.c_str()) - 1;
-			ft[0] = atoi(facept1.substr(pos + 1).c_str()) - 1;
-			pos = facept2.find('/');
-			f[1] = atoi(facept2.c_str()) - 1;
-			ft[1] = atoi(facept2.substr(pos + 1).c_str()) - 1;
-			pos = facept3.find('/');
-			f[2] = atoi(facept3.c_str()) - 1;
-			ft[2] = atoi(facept3.substr(pos + 1).c_str()) - 1;
-
-			if (f[0] == -1 || f[1] == -1 || f[2] == -1)
-				continue;
 
-			base >> facept4;
-			dump = facept4;
+		if (mantissa == 0) {
+			out = neg ? -0.0f : 0.0f;
+			return p;
+		}
 
-			nPoints = 3;
-			gotface = true;
+		if (numDigits <= 15 && exponent >= -22 && exponent <= 22) {
+			double value = (double)mantissa;
+			if (exponent < 0)
+				value /= pow10[-exponent];
+			else
+				value *= pow10[exponent];
+
+			// The 29 mantissa bits that a float drops
+			unsigned long long bits;
+			memcpy(&bits, &value, sizeof(bits));
+			if ((bits & 0x1FFFFFFF) != 0x10000000) {
+				out = (float)value;
+				if (neg)
+					out = -out;
+				return p;
+			}
+		}
 
-			if (facept4.length() > 0) {
-				f[3] = atoi(facept4.c_str()) - 1;
+		std::istringstream stream(std::string(start, p));
+		stream.imbue(std::locale::classic());
+		stream >> out;
+		return p;
+	}
 
-				if (f[3] != -1) {
-					pos = facept4.find('/');
-					ft[3] = atoi(facept4.substr(pos + 1).c_str()) - 1;
-					nPoints = 4;
-					gotface = false;
+	void ParseObjLines(const char* p, const char* end, ObjChunk& chunk) {
+		while (p < end) {
+			const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+			if (!lineEnd)
+				lineEnd = end;
+
+			const char* key = SkipSpace(p, lineEnd);
+			const char* keyEnd = TokenEnd(key, lineEnd);
+			size_t keyLen = keyEnd - key;
+			const char* c = SkipSpace(keyEnd, lineEnd);
+
+			if (keyLen == 1 && key[0] == 'v') {
+				Vector3 v;
+				const char* n;
+				if ((n = ParseFloat(c, lineEnd, v.x)) != nullptr) {
+					c = SkipSpace(n, lineEnd);
+					if ((n = ParseFloat(c, lineEnd, v.y)) != nullptr) {
+						c = SkipSpace(n, lineEnd);
+						ParseFloat(c, lineEnd, v.z);
+					}
 				}
+				chunk.verts.push_back(v);
 			}
+			else if (keyLen == 2 && key[0] == 'v' && key[1] == 't') {
+				Vector2 uv;
+				const char* n;
+				if ((n = ParseFloat(c, lineEnd, uv.u)) != nullptr) {
+					c = SkipSpace(n, lineEnd);
+					ParseFloat(c, lineEnd, uv.v);
+				}
+				uv.v = 1.0f - uv.v;
+				chunk.uvs.push_back(uv);
+			}
+			else if (keyLen == 1 && key[0] == 'f') {
+				int numPoints = 0;
+				bool valid = true;
+				while (c < lineEnd) {
+					// v, v/vt, v//vn or v/vt/vn
+					ObjCorner corner;
+					const char* n = ParseInt(c, lineEnd, corner.v);
+					if (!n)
+						break;
 
-			bool skipFace = false;
-			for (int i = 0; i < nPoints; i++) {
-				v_idx[i] = di->verts.size();
-				if ((savedVert = vertMap.find(f[i])) != vertMap.end()) {
-					for (int j = 0; j < savedVert->second.size(); j++) {
-						if (savedVert->second[j].uv == ft[i])
-							v_idx[i] = savedVert->second[j].v;
-						else if (uvs.size() > 0) {
-							uv = uvs[ft[i]];
-							uv2 = uvs[savedVert->second[j].uv];
-
-							if (fabs(uv.u - uv2.u) > uvDupThreshold || fabs(uv.v - uv2.v) > uvDupThreshold)
-								continue;
-
-							v_idx[i] = savedVert->second[j].v;
+					corner.v--;
+					corner.uv = -1;
+					if (n < lineEnd && *n == '/') {
+						n++;
+						if (n < lineEnd && *n != '/') {
+							const char* uvEnd = ParseInt(n, lineEnd, corner.uv);
+							if (uvEnd) {
+								corner.uv--;
+								n = uvEnd;
+							}
 						}
 					}
+
+					// Relative indices aren't supported
+					if (corner.v < 0)
+						valid = false;
+
+					chunk.corners.push_back(corner);
+					numPoints++;
+
+					c = SkipSpace(TokenEnd(n, lineEnd), lineEnd);
 				}
 
-				if (v_idx[i] == di->verts.size()) {
-					if (verts.size() > f[i]) {
-						di->verts.push_back(verts[f[i]]);
+				if (valid && numPoints >= 3)
+					chunk.faceSizes.push_back(numPoints);
+				else
+					chunk.corners.resize(chunk.corners.size() - numPoints);
+			}
+			else if (keyLen == 1 && (key[0] == 'g' || key[0] == 'o')) {
+				const char* nameEnd = TokenEnd(c, lineEnd);
+				if (nameEnd > c) {
+					ObjGroupStart group;
+					group.name.assign(c, nameEnd);
+					group.face = chunk.faceSizes.size();
+					chunk.groups.push_back(group);
+				}
+			}
 
-						if (uvs.size() > ft[i]) {
-							vertMap[f[i]].push_back(VertUV(v_idx[i], ft[i]));
-							di->uvs.push_back(uvs[ft[i]]);
-						}
-					}
-					else {
-						skipFace = true;
-						break;
-					}
+			p = lineEnd + 1;
+		}
+	}
+}
+
+int ObjFile::LoadForNif(const char* buffer, const size_t size) {
+	const char* end = buffer + size;
+
+	// Split the file into ranges of whole lines that are parsed independently
+	const size_t chunkSize = 1024 * 1024;
+	std::vector<const char*> chunkStarts;
+	const char* p = buffer;
+	while (p < end) {
+		chunkStarts.push_back(p);
+		if (end - p <= chunkSize)
+			break;
+
+		const char* next = (const char*)memchr(p + chunkSize, '\n', end - p - chunkSize);
+		if (!next)
+			break;
+
+		p = next + 1;
+	}
+	chunkStarts.push_back(end);
+
+	int numChunks = chunkStarts.size() - 1;
+	std::vector<ObjChunk> chunks(numChunks);
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, numChunks, [&](int i) {
+		ParseObjLines(chunkStarts[i], chunkStarts[i + 1], chunks[i]);
+	});
+#else
+	for (int i = 0; i < numChunks; i++)
+		ParseObjLines(chunkStarts[i], chunkStarts[i + 1], chunks[i]);
+#endif
+
+	std::vector<Vector3> verts;
+	std::vector<Vector2> uvs;
+	size_t numVerts = 0;
+	size_t numUVs = 0;
+	for (auto &chunk : chunks) {
+		numVerts += chunk.verts.size();
+		numUVs += chunk.uvs.size();
+	}
+
+	verts.reserve(numVerts);
+	uvs.reserve(numUVs);
+	for (auto &chunk : chunks) {
+		verts.insert(verts.end(), chunk.verts.begin(), chunk.verts.end());
+		uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		std::vector<Vector3>().swap(chunk.verts);
+		std::vector<Vector2>().swap(chunk.uvs);
+	}
+
+	// Corners of a group that use the same position and (nearly) the same uv share a vertex.
+	// Each position index has a chain of the vertices made from it so far in the current group.
+	struct VertUVLink {
+		VertUV vertUV;
+		int next;
+		VertUVLink(int v, int uv, int next) : vertUV(v, uv), next(next) {}
+	};
+
+	std::vector<int> vertHeads(verts.size(), -1);
+	std::vector<VertUVLink> vertLinks;
+	std::vector<int> usedHeads;
+
+	ObjData* di = new ObjData();
+
+	auto startGroup = [&](const std::string& name) {
+		if (!di->name.empty()) {
+			auto existing = data.find(di->name);
+			if (existing != data.end())
+				delete existing->second;
+
+			data[di->name] = di;
+			di = new ObjData();
+
+			for (auto &h : usedHeads)
+				vertHeads[h] = -1;
+
+			usedHeads.clear();
+			vertLinks.clear();
+		}
+
+		di->name = name;
+		objGroups.push_back(name);
+	};
+
+	auto findVertex = [&](const ObjCorner& corner) -> int {
+		// Chains start with the newest vertex, which is preferred if several match
+		for (int l = vertHeads[corner.v]; l != -1; l = vertLinks[l].next) {
+			const VertUV& saved = vertLinks[l].vertUV;
+			if (saved.uv == corner.uv)
+				return saved.v;
+
+			if (corner.uv >= 0 && saved.uv >= 0) {
+				const Vector2& uv = uvs[corner.uv];
+				const Vector2& uv2 = uvs[saved.uv];
+				if (fabs(uv.u - uv2.u) <= uvDupThreshold && fabs(uv.v - uv2.v) <= uvDupThreshold)
+					return saved.v;
+			}
+		}
+
+		int v = di->verts.size();
+		di->verts.push_back(verts[corner.v]);
+		if (!uvs.empty())
+			di->uvs.push_back(corner.uv >= 0 ? uvs[corner.uv] : Vector2());
+
+		if (vertHeads[corner.v] == -1)
+			usedHeads.push_back(corner.v);
+
+		vertLinks.emplace_back(v, corner.uv, vertHeads[corner.v]);
+		vertHeads[corner.v] = vertLinks.size() - 1;
+		return v;
+	};
+
+	std::vector<int> faceVerts;
+	for (auto &chunk : chunks) {
+		int nextGroup = 0;
+		int corner = 0;
+		for (int f = 0; f < chunk.faceSizes.size(); f++) {
+			while (nextGroup < chunk.groups.size() && chunk.groups[nextGroup].face == f)
+				startGroup(chunk.groups[nextGroup++].name);
+
+			int numPoints = chunk.faceSizes[f];
+			ObjCorner* faceCorners = &chunk.corners[corner];
+			corner += numPoints;
+
+			bool skipFace = false;
+			for (int i = 0; i < numPoints; i++) {
+				ObjCorner& fc = faceCorners[i];
+				if (fc.v >= (int)verts.size()) {
+					skipFace = true;
+					break;
 				}
+
+				if (fc.uv >= (int)uvs.size())
+					fc.uv = -1;
 			}
 
 			if (skipFace)
 				continue;
 
-			t.p1 = v_idx[0];
-			t.p2 = v_idx[1];
-			t.p3 = v_idx[2];
-			di->tris.push_back(t);
-			if (nPoints == 4) {
-				t.p1 = v_idx[0];
-				t.p2 = v_idx[2];
-				t.p3 = v_idx[3];
-				di->tris.push_back(t);
-			}
+			faceVerts.resize(numPoints);
+			for (int i = 0; i < numPoints; i++)
+				faceVerts[i] = findVertex(faceCorners[i]);
+
+			// Polygons are split into a fan around the first corner
+			for (int i = 1; i < numPoints - 1; i++)
+				di->tris.push_back(Triangle(faceVerts[0], faceVerts[i], faceVerts[i + 1]));
 		}
+
+		while (nextGroup < chunk.groups.size())
+			startGroup(chunk.groups[nextGroup++].name);
 	}
 
 	if (di->name.empty()) {
@@ -181,6 +463,10 @@ int ObjFile::LoadForNif(std::fstream& base) {
 		objGroups.push_back(di->name);
 	}
 
+	auto existing = data.find(di->name);
+	if (existing != data.end())
+		delete existing->second;
+
 	data[di->name] = di;
 	return 0;
 }
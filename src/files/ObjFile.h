@@ -45,6 +45,7 @@ public:
 
 	int LoadForNif(const std::string& fileName);
 	int LoadForNif(std::fstream& base);
+	int LoadForNif(const char* buffer, const size_t size);
 
 	int Save(const std::string& fileName);
 
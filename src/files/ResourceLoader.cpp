@@ -44,15 +44,18 @@ GLuint ResourceLoader::LoadTexture(const std::string& inFileName, bool isCubeMap
 	if (!textureID)
 		textureID = SOIL_load_OGL_texture(inFileName.c_str(), SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, SOIL_FLAG_TEXTURE_REPEATS | SOIL_FLAG_MIPMAPS | SOIL_FLAG_GL_MIPMAPS);
 
-	if (!textureID && Config.MatchValue("BSATextureScan", "true")) {
-		if (Config["GameDataPath"].empty()) {
+	ConfigurationKey bsaTextureScanKey("BSATextureScan");
+	ConfigurationKey gameDataPathKey("GameDataPath");
+	if (!textureID && Config.MatchValue(bsaTextureScanKey, "true")) {
+		std::string gameDataPath = Config[gameDataPathKey];
+		if (gameDataPath.empty()) {
 			wxLogWarning("Texture file '%s' not found.", inFileName);
 			return 0;
 		}
 
 		wxMemoryBuffer data;
 		wxString texFile = inFileName;
-		texFile.Replace(wxString(Config["GameDataPath"]).MakeLower(), "");
+		texFile.Replace(wxString(gameDataPath).MakeLower(), "");
 		texFile.Replace("\\", "/");
 		for (FSArchiveFile *archive : FSManager::archiveList()) {
 			if (archive) {
@@ -104,26 +104,39 @@ bool TriFile::Write(const std::string& fileName) {
 	std::ofstream triFile(fileName.c_str(), std::ios_base::binary);
 
 	if (triFile.is_open()) {
+		// Assemble the whole file in memory and write it at once
+		std::vector<char> buffer;
+		auto put = [&buffer](const void* data, size_t size) {
+			const char* bytes = static_cast<const char*>(data);
+			buffer.insert(buffer.end(), bytes, bytes + size);
+		};
+
+		size_t bufferSize = 6;
+		for (auto& shape : shapeMorphs) {
+			bufferSize += 3 + shape.first.length();
+			for (auto& morph : shape.second)
+				bufferSize += 7 + morph->name.length() + morph->offsets.size() * 8;
+		}
+		buffer.reserve(bufferSize);
+
 		uint hdr = 'TRIP';
-		triFile.write((char*)&hdr, 4);
+		put(&hdr, 4);
 
 		uint shapeCount = shapeMorphs.size();
-		triFile.write((char*)&shapeCount, 2);
+		put(&shapeCount, 2);
 
 		for (auto& shape : shapeMorphs) {
 			byte shapeLength = shape.first.length();
-			std::string shapeName = shape.first;
-			triFile.write((char*)&shapeLength, 1);
-			triFile.write(shapeName.c_str(), shapeLength);
+			put(&shapeLength, 1);
+			put(shape.first.c_str(), shapeLength);
 
 			uint morphCount = shape.second.size();
-			triFile.write((char*)&morphCount, 2);
+			put(&morphCount, 2);
 
 			for (auto& morph : shape.second) {
 				byte morphLength = morph->name.length();
-				std::string morphName = morph->name;
-				triFile.write((char*)&morphLength, 1);
-				triFile.write(morphName.c_str(), morphLength);
+				put(&morphLength, 1);
+				put(morph->name.c_str(), morphLength);
 
 				float mult = 0.0f;
 				for (auto& v : morph->offsets) {
@@ -136,23 +149,27 @@ bool TriFile::Write(const std::string& fileName) {
 				}
 
 				mult /= 0x7FFF;
-				triFile.write((char*)&mult, 4);
+				put(&mult, 4);
 
 				ushort morphVertCount = morph->offsets.size();
-				triFile.write((char*)&morphVertCount, 2);
+				put(&morphVertCount, 2);
 
 				for (auto& v : morph->offsets) {
 					ushort id = v.first;
 					short x = v.second.x / mult;
 					short y = v.second.y / mult;
 					short z = v.second.z / mult;
-					triFile.write((char*)&id, 2);
-					triFile.write((char*)&x, 2);
-					triFile.write((char*)&y, 2);
-					triFile.write((char*)&z, 2);
+					put(&id, 2);
+					put(&x, 2);
+					put(&y, 2);
+					put(&z, 2);
 				}
 			}
 		}
+
+		triFile.write(buffer.data(), buffer.size());
+		if (!triFile)
+			return false;
 	}
 	else
 		return false;
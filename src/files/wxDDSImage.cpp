@@ -10,9 +10,17 @@ See the included LICENSE file
 #include "gli.hpp"
 #pragma warning (pop)
 
+#include <algorithm>
+
+#ifdef WIN64
+	#include <ppl.h>
+#else
+	#undef _PPL_H
+#endif
+
 wxIMPLEMENT_DYNAMIC_CLASS(wxDDSHandler, wxImageHandler);
 
-bool wxDDSHandler::LoadFile(wxImage *image, wxInputStream& stream, bool WXUNUSED(verbose), int WXUNUSED(index)) {
+bool wxDDSHandler::LoadFile(wxImage *image, wxInputStream& stream, bool WXUNUSED(verbose), int index) {
 	size_t datasize = stream.GetSize();
 	if (datasize <= 0)
 		return false;
@@ -30,61 +38,57 @@ bool wxDDSHandler::LoadFile(wxImage *image, wxInputStream& stream, bool WXUNUSED
 	}
 
 	gli::texture2d tex2d(intex);
-	gli::extent2d dim = tex2d.extent();
-	unsigned char* srcptr = (unsigned char*)tex2d.data();
+
+	size_t level = index > 0 ? index : 0;
+	if (level >= tex2d.levels()) {
+		delete[] buf;
+		return false;
+	}
+
+	gli::extent2d dim = tex2d.extent(level);
+	unsigned char* srcptr = (unsigned char*)tex2d.data(0, 0, level);
 	image->Destroy();
 	image->Create(dim.x, dim.y, false);
 	unsigned char* destPtr = image->GetData();
 
 	uint32_t pxcount = dim.x * dim.y * 3;
-	if (!gli::is_compressed(intex.format())) {
-		for (uint32_t i = 0; i < pxcount; i += 3) {
-			destPtr[i] = *srcptr++;
-			destPtr[i+1] = *srcptr++;
-			destPtr[i+2] = *srcptr++;
-		
-			// skipping alpha
-			srcptr++;
-		}
-	}
-	else {
-		for (uint32_t i = 0; i < pxcount; i += 3) {
-			destPtr[i] = 66;
-			destPtr[i + 1] = 66;
-			destPtr[i + 2] = 66;
-		}
-	}
-
-	delete[] buf;
-	/* Compressed image loading leads to heap corruption... :(
-
-	for (int y = 0; y < dim.y; y += 4) {
-		for (int x= 0; x < dim.x; x += 4) {
-			unsigned char targetcolor[4 * 16];
-			DecompressColor(targetcolor, srcptr, true);
-			unsigned char* sourcePixel = targetcolor;
-			for (int py = 0; py < 4; py++) {
-				for (int px = 0; px < 4; px++) {
-					int sx = x + px;
-					int sy = y + py;
-					if (sx < dim.x && sy < dim.y) {
-						unsigned char* targetPixel = destPtr + 4 * (dim.x*sy + sx);
-						for (int i = 0; i < 4; i++) {
-							*targetPixel++ = *sourcePixel++;
-						}
-					}
-					else {
-						sourcePixel += 4;
-					}
-
+	switch (tex2d.format()) {
+		case gli::FORMAT_RGB_DXT1_UNORM_BLOCK8:
+		case gli::FORMAT_RGB_DXT1_SRGB_BLOCK8:
+		case gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8:
+		case gli::FORMAT_RGBA_DXT1_SRGB_BLOCK8:
+			DecompressColor(destPtr, srcptr, dim.x, dim.y, 8, true);
+			break;
+
+		case gli::FORMAT_RGBA_DXT3_UNORM_BLOCK16:
+		case gli::FORMAT_RGBA_DXT3_SRGB_BLOCK16:
+		case gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16:
+		case gli::FORMAT_RGBA_DXT5_SRGB_BLOCK16:
+			// The color follows the 8 bytes of alpha, which is skipped
+			DecompressColor(destPtr, srcptr + 8, dim.x, dim.y, 16, false);
+			break;
+
+		default:
+			if (!gli::is_compressed(intex.format())) {
+				for (uint32_t i = 0; i < pxcount; i += 3) {
+					destPtr[i] = *srcptr++;
+					destPtr[i+1] = *srcptr++;
+					destPtr[i+2] = *srcptr++;
+
+					// skipping alpha
+					srcptr++;
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < pxcount; i += 3) {
+					destPtr[i] = 66;
+					destPtr[i + 1] = 66;
+					destPtr[i + 2] = 66;
 				}
 			}
-		}
-		srcptr += 8;
 	}
-	*/
-
 
+	delete[] buf;
 	return true;
 }
 
@@ -105,53 +109,40 @@ bool wxDDSHandler::DoCanRead(wxInputStream& stream) {
 
 }
 
-/* Decompression functions cribbed from libsquish */
-void wxDDSHandler::DecompressColor(unsigned char * outPixels, unsigned char * block, bool dxt1)
-{
-	unsigned char codes[16];
-	int a = Unpack565(block, codes);
-	int b = Unpack565(block + 2, codes + 4);
+int wxDDSHandler::DoGetImageCount(wxInputStream& stream) {
+	unsigned char hdr[32];
+	if (stream.Read(hdr, WXSIZEOF(hdr)).LastRead() != WXSIZEOF(hdr) || memcmp(hdr, "DDS ", 4) != 0)
+		return 0;
 
-	for (int i = 0; i < 3; i++) {
-		int c = codes[i];
-		int d = codes[4 + i];
+	uint32_t mipCount = hdr[28] | (hdr[29] << 8) | (hdr[30] << 16) | ((uint32_t)hdr[31] << 24);
+	return mipCount > 0 ? mipCount : 1;
+}
 
-		if (dxt1 && a <= b) {
-			codes[8 + i] = (c + d) / 2;
-			codes[12 + i] = 0;
-		}
-		else {
-			codes[8 + i] = (2*c + d) / 3;
-			codes[12 + i] =(c+2*d) /3;
+int wxDDSHandler::GetMipLevelForSize(wxInputStream& stream, int maxSize) {
+	wxFileOffset pos = stream.TellI();
 
-		}
-	}
+	unsigned char hdr[32];
+	bool valid = stream.Read(hdr, WXSIZEOF(hdr)).LastRead() == WXSIZEOF(hdr) && memcmp(hdr, "DDS ", 4) == 0;
+	stream.SeekI(pos);
+	if (!valid)
+		return 0;
+
+	uint32_t height = hdr[12] | (hdr[13] << 8) | (hdr[14] << 16) | ((uint32_t)hdr[15] << 24);
+	uint32_t width = hdr[16] | (hdr[17] << 8) | (hdr[18] << 16) | ((uint32_t)hdr[19] << 24);
+	uint32_t mipCount = hdr[28] | (hdr[29] << 8) | (hdr[30] << 16) | ((uint32_t)hdr[31] << 24);
 
-	codes[8 + 3] = 255;
-	codes[12 + 3] = (dxt1 && a <= b) ? 0 : 255;
-
-	unsigned char indices[16];
-	for (int i = 0; i < 4; i++) {
-		unsigned char* ind = indices + 4 * i;
-		unsigned char packed = block[4 + i];
-		ind[0] = packed & 0x3;
-		ind[1] = (packed >> 2) & 0x3;
-		ind[2] = (packed >> 4) & 0x3;
-		ind[3] = (packed >> 6) & 0x3;
-
-	}	
-	
-	for (int i = 0; i < 16; ++i)
-	{
-		unsigned char offset = 4 * indices[i];
-		for (int j = 0; j < 4; ++j)
-			outPixels[4 * i + j] = codes[offset + j];
+	int level = 0;
+	while (level + 1 < (int)mipCount && (width > (uint32_t)maxSize || height > (uint32_t)maxSize)) {
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		level++;
 	}
+
+	return level;
 }
 
-/* Decompression functions cribbed from libsquish */
-int wxDDSHandler::Unpack565(unsigned char * bytes, unsigned char * color)
-{
+// Expands a 5:6:5 color to 8 bits per channel. Cribbed from libsquish.
+static inline int Unpack565(const unsigned char* bytes, unsigned char* color) {
 	int value = (int)bytes[0] | ((int)bytes[1] << 8);
 
 	// get the components in the stored range
@@ -163,8 +154,71 @@ int wxDDSHandler::Unpack565(unsigned char * bytes, unsigned char * color)
 	color[0] = (red << 3) | (red >> 2);
 	color[1] = (green << 2) | (green >> 4);
 	color[2] = (blue << 3) | (blue >> 2);
-	color[3] = 255;
 
 	// return the value
 	return value;
 }
+
+// Decodes one row of blocks. The blocks are handled in batches: first the palettes and indices of the whole
+// batch, then the pixels. Neither loop depends on the previous block, so both vectorize.
+static void DecompressColorRow(unsigned char* outRow, const unsigned char* blocks, int width, int rows, int blockSize, bool dxt1) {
+	const int batchSize = 4;
+	const int numBlocks = (width + 3) / 4;
+	const int stride = width * 3;
+
+	unsigned char palette[batchSize][4][3];
+	uint32_t indices[batchSize];
+
+	for (int first = 0; first < numBlocks; first += batchSize) {
+		int count = std::min(batchSize, numBlocks - first);
+
+		for (int b = 0; b < count; b++) {
+			const unsigned char* block = blocks + (first + b) * blockSize;
+			int a = Unpack565(block, palette[b][0]);
+			int c = Unpack565(block + 2, palette[b][1]);
+
+			// DXT1 blocks with a <= c have three colors and black
+			bool threeColor = dxt1 && a <= c;
+			for (int i = 0; i < 3; i++) {
+				int c0 = palette[b][0][i];
+				int c1 = palette[b][1][i];
+				palette[b][2][i] = threeColor ? (c0 + c1) / 2 : (2 * c0 + c1) / 3;
+				palette[b][3][i] = threeColor ? 0 : (c0 + 2 * c1) / 3;
+			}
+
+			indices[b] = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+		}
+
+		for (int y = 0; y < rows; y++) {
+			unsigned char* outPixel = outRow + y * stride + first * 4 * 3;
+			for (int b = 0; b < count; b++) {
+				uint32_t rowIndices = indices[b] >> (8 * y);
+				int pixels = std::min(4, width - (first + b) * 4);
+				for (int x = 0; x < pixels; x++) {
+					const unsigned char* color = palette[b][(rowIndices >> (2 * x)) & 0x3];
+					outPixel[0] = color[0];
+					outPixel[1] = color[1];
+					outPixel[2] = color[2];
+					outPixel += 3;
+				}
+			}
+		}
+	}
+}
+
+void wxDDSHandler::DecompressColor(unsigned char* outPixels, const unsigned char* blocks, int width, int height, int blockSize, bool dxt1) {
+	int blockRows = (height + 3) / 4;
+	size_t rowSize = (size_t)((width + 3) / 4) * blockSize;
+
+	auto decodeRow = [&](int row) {
+		int rows = std::min(4, height - row * 4);
+		DecompressColorRow(outPixels + (size_t)row * 4 * width * 3, blocks + row * rowSize, width, rows, blockSize, dxt1);
+	};
+
+#ifdef _PPL_H
+	concurrency::parallel_for(0, blockRows, decodeRow);
+#else
+	for (int row = 0; row < blockRows; row++)
+		decodeRow(row);
+#endif
+}
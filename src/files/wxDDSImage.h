@@ -22,16 +22,23 @@ public:
 	}
 
 #if wxUSE_STREAMS
+	// The image index is the mip level to load, the first one by default.
 	virtual bool LoadFile(wxImage *image, wxInputStream& stream, bool verbose = true, int index = -1) wxOVERRIDE;
 	virtual bool SaveFile(wxImage *image, wxOutputStream& stream, bool verbose = true) wxOVERRIDE;
+
+	// Returns the first mip level that fits into maxSize x maxSize, or the last one if none does.
+	// Leaves the stream at its position.
+	static int GetMipLevelForSize(wxInputStream& stream, int maxSize);
+
 protected:
 	virtual bool DoCanRead(wxInputStream& stream) wxOVERRIDE;
+	virtual int DoGetImageCount(wxInputStream& stream) wxOVERRIDE;
 #endif
 
 private:
 	wxDECLARE_DYNAMIC_CLASS(wxDDSHandler);
 
-	/* Decompression functions cribbed from libsquish */
-	void DecompressColor(unsigned char* outPixels, unsigned char* block, bool dxt1);
-	int Unpack565(unsigned char* bytes, unsigned char* color);
+	// Decodes the color of DXT1/3/5 blocks to RGB, with the results of libsquish's DecompressColor.
+	// Rows of blocks are decoded in parallel.
+	static void DecompressColor(unsigned char* outPixels, const unsigned char* blocks, int width, int height, int blockSize, bool dxt1);
 };
@@ -94,7 +94,7 @@ bool BodySlideApp::OnInit() {
 
 	Config.LoadConfig();
 
-	logger.Initialize(Config.GetIntValue("LogLevel", -1));
+	logger.Initialize(Config.GetIntValue("LogLevel", -1), "Log.txt", Config.GetIntValue("LogFlushInterval", 1000));
 	wxLogMessage("Initializing BodySlide...");
 
 #ifdef NDEBUG
@@ -168,6 +168,7 @@ bool BodySlideApp::OnCmdLineParsed(wxCmdLineParser& parser) {
 	parser.Found("t", &cmdTargetDir);
 	parser.Found("p", &cmdPreset);
 	cmdTri = parser.Found("tri");
+	cmdNormalMaps = parser.Found("nm");
 	return true;
 }
 
@@ -188,6 +189,7 @@ bool BodySlideApp::OnExceptionInMainLoop() {
 
 	logger.SetFormatter(false);
 	wxLogError("Unexpected exception has occurred: %s, the program will terminate.", error);
+	logger.Flush();
 	wxMessageBox(wxString::Format(_("Unexpected exception has occurred: %s, the program will terminate."), error), _("Unexpected exception"), wxICON_ERROR);
 	return false;
 }
@@ -209,6 +211,7 @@ void BodySlideApp::OnUnhandledException() {
 
 	logger.SetFormatter(false);
 	wxLogError("Unhandled exception has occurred: %s, the program will terminate.", error);
+	logger.Flush();
 	wxMessageBox(wxString::Format(_("Unhandled exception has occurred: %s, the program will terminate."), error), _("Unhandled exception"), wxICON_ERROR);
 }
 
@@ -218,6 +221,7 @@ void BodySlideApp::OnFatalException() {
 
 	logger.SetFormatter(false);
 	wxLogError("Fatal exception has occurred, the program will terminate.");
+	logger.Flush();
 	wxMessageBox(_("Fatal exception has occurred, the program will terminate."), _("Fatal exception"), wxICON_ERROR);
 }
 
@@ -356,23 +360,37 @@ int BodySlideApp::LoadSliderSets() {
 	wxDir::GetAllFiles("SliderSets", &files, "*.osp");
 	wxDir::GetAllFiles("SliderSets", &files, "*.xml");
 
-	for (auto &file : files) {
-		SliderSetFile sliderDoc;
-		sliderDoc.Open(file.ToStdString());
-		if (sliderDoc.fail())
+	std::vector<std::string> fileNames;
+	fileNames.reserve(files.size());
+	for (auto &file : files)
+		fileNames.push_back(file.ToStdString());
+
+	// Only files that changed since the last run or refresh are parsed.
+	// The catalogue is kept in the BodySlide folder next to its other data files.
+	wxFileName catalogueFileName(wxStandardPaths::Get().GetExecutablePath());
+	catalogueFileName.SetFullName("SliderSetCatalogue.xml");
+	const std::string catalogueFile = catalogueFileName.GetFullPath().ToStdString();
+	if (!setCatalogueLoaded) {
+		setCatalogue.Load(catalogueFile);
+		setCatalogueLoaded = true;
+	}
+
+	if (setCatalogue.Update(fileNames))
+		setCatalogue.Save(catalogueFile);
+
+	for (auto &fileName : fileNames) {
+		const SliderSetCatalogue::FileInfo* file = setCatalogue.GetFile(fileName);
+		if (!file || file->failed)
 			continue;
 
-		std::string outFilePath;
-		std::vector<std::string> outfitNames;
-		sliderDoc.GetSetNamesUnsorted(outfitNames, false);
-		for (int i = 0; i < outfitNames.size(); i++) {
-			outfitNameSource[outfitNames[i]] = file.ToStdString();
-			outfitNameOrder.push_back(outfitNames[i]);
+		for (auto &set : file->sets) {
+			outfitNameSource[set.name] = fileName;
+			outfitNameOrder.push_back(set.name);
 
-			sliderDoc.GetSetOutputFilePath(outfitNames[i], outFilePath);
-			if (!outFilePath.empty()) {
+			if (!set.outputFilePath.empty()) {
+				std::string outFilePath = set.outputFilePath;
 				std::transform(outFilePath.begin(), outFilePath.end(), outFilePath.begin(), ::tolower);
-				outFileCount[outFilePath].push_back(outfitNames[i]);
+				outFileCount[outFilePath].push_back(set.name);
 			}
 		}
 	}
@@ -625,53 +643,89 @@ void BodySlideApp::ApplySliders(const std::string& targetShape, std::vector<Slid
 				dataSets.ApplyClamp(slider.linkedDataSets[j], targetShape, &verts);
 }
 
-bool BodySlideApp::WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices) {
-	DiffDataSets currentDiffs;
-	sliderSet.LoadSetDiffData(currentDiffs);
-
+bool BodySlideApp::WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, DiffDataSets& diffs, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices) {
 	TriFile tri;
 	std::string triFilePath = triPath + ".tri";
 
 	for (auto shape = sliderSet.TargetShapesBegin(); shape != sliderSet.TargetShapesEnd(); ++shape) {
-		for (int s = 0; s < sliderSet.size(); s++) {
+		const std::vector<ushort>& shapeZapIndices = zapIndices[shape->second];
+
+		int shapeVertCount = nif.GetVertCountForShape(shape->second);
+		shapeVertCount += shapeZapIndices.size();
+		if (shapeVertCount <= 0)
+			continue;
+
+		// Maps diff indices to vertex indices of the zapped output shape
+		std::vector<int> vertexRemap(shapeVertCount, 0);
+		bool zapValid = true;
+		for (auto &z : shapeZapIndices) {
+			if (z >= shapeVertCount) {
+				zapValid = false;
+				break;
+			}
+			vertexRemap[z] = -1;
+		}
+
+		if (!zapValid)
+			continue;
+
+		int nextIndex = 0;
+		for (auto &r : vertexRemap)
+			if (r != -1)
+				r = nextIndex++;
+
+		std::vector<MorphDataPtr> morphs(sliderSet.size());
+		auto buildMorph = [&](int s) {
+			if (sliderSet[s].bUV || sliderSet[s].bClamp || sliderSet[s].bZap)
+				return;
+
 			std::string dn = sliderSet[s].TargetDataName(shape->first);
-			std::string target = shape->first;
 			if (dn.empty())
-				continue;
+				return;
 
-			if (!sliderSet[s].bUV && !sliderSet[s].bClamp && !sliderSet[s].bZap) {
-				MorphDataPtr morph = std::make_shared<MorphData>();
-				morph->name = sliderSet[s].name;
+			std::unordered_map<ushort, Vector3>* diff = diffs.GetDiffSet(dn, shape->first);
+			if (!diff)
+				return;
 
-				const std::vector<ushort>& shapeZapIndices = zapIndices[shape->second];
+			std::vector<std::pair<int, Vector3>> offsets;
+			offsets.reserve(diff->size());
 
-				std::vector<Vector3> verts;
-				int shapeVertCount = nif.GetVertCountForShape(shape->second);
-				shapeVertCount += shapeZapIndices.size();
-				if (shapeVertCount > 0)
-					verts.resize(shapeVertCount);
-				else
+			for (auto &d : *diff) {
+				if (d.first >= shapeVertCount)
 					continue;
 
-				currentDiffs.ApplyDiff(dn, target, 1.0f, &verts);
-
-				if (shapeZapIndices.size() > 0 && shapeZapIndices.back() >= verts.size())
+				int index = vertexRemap[d.first];
+				if (index < 0 || d.second.IsZero(true))
 					continue;
 
-				for (int i = shapeZapIndices.size() - 1; i >= 0; i--)
-					verts.erase(verts.begin() + shapeZapIndices[i]);
-				
-				int i = 0;
-				for (auto &v : verts) {
-					if (!v.IsZero(true))
-						morph->offsets.emplace(i, v);
-					i++;
-				}
-
-				if (morph->offsets.size() > 0)
-					tri.AddMorph(shape->second, morph);
+				offsets.emplace_back(index, d.second);
 			}
-		}
+
+			if (offsets.empty())
+				return;
+
+			// Sorted input lets the map insert each offset in constant time
+			std::sort(offsets.begin(), offsets.end(), [](const std::pair<int, Vector3>& a, const std::pair<int, Vector3>& b) {
+				return a.first < b.first;
+			});
+
+			MorphDataPtr morph = std::make_shared<MorphData>();
+			morph->name = sliderSet[s].name;
+			morph->offsets.insert(offsets.begin(), offsets.end());
+			morphs[s] = morph;
+		};
+
+#ifdef _PPL_H
+		concurrency::parallel_for(0, (int)sliderSet.size(), buildMorph);
+#else
+		for (int s = 0; s < sliderSet.size(); s++)
+			buildMorph(s);
+#endif
+
+		// Keep the slider order of the set in the file
+		for (auto &morph : morphs)
+			if (morph)
+				tri.AddMorph(shape->second, morph);
 	}
 
 	if (!tri.Write(triFilePath))
@@ -730,6 +784,8 @@ void BodySlideApp::ShowPreview() {
 }
 
 void BodySlideApp::InitPreview() {
+	InvalidatePreviewMorphs();
+
 	if (!preview)
 		return;
 
@@ -740,20 +796,22 @@ void BodySlideApp::InitPreview() {
 
 	if (!previewBaseNif) {
 		previewBaseNif = new NifFile();
-		previewBaseNif->Load(inputFileName);
-		if (PreviewMod.Load(inputFileName))
+		if (previewBaseNif->Load(inputFileName, true))
 			return;
 
+		PreviewMod.CopyFrom(*previewBaseNif);
+
 		freshLoad = true;
 		sliderManager.FlagReload(false);
 	}
 	else if (previewBaseName != inputFileName || previewSetName != inputSetName || sliderManager.NeedReload()) {
 		delete previewBaseNif;
 		previewBaseNif = new NifFile();
-		previewBaseNif->Load(inputFileName);
-		if (PreviewMod.Load(inputFileName) != 0)
+		if (previewBaseNif->Load(inputFileName, true) != 0)
 			return;
 
+		PreviewMod.CopyFrom(*previewBaseNif);
+
 		freshLoad = true;
 		sliderManager.FlagReload(false);
 	}
@@ -814,6 +872,70 @@ void BodySlideApp::InitPreview() {
 	preview->Refresh();
 }
 
+bool BodySlideApp::GetChangedPreviewSliders(std::vector<int>& outChangedBig, std::vector<int>& outChangedSmall) {
+	if (!previewMorphsValid)
+		return false;
+
+	if (previewValuesBig.size() != sliderManager.slidersBig.size() || previewValuesSmall.size() != sliderManager.slidersSmall.size())
+		return false;
+
+	bool clampActive = false;
+	for (int i = 0; i < sliderManager.slidersBig.size(); i++) {
+		Slider& sliderBig = sliderManager.slidersBig[i];
+		Slider& sliderSmall = sliderManager.slidersSmall[i];
+
+		bool changedBig = sliderBig.value != previewValuesBig[i];
+		bool changedSmall = sliderSmall.value != previewValuesSmall[i];
+
+		// Zapped verts change the mesh layout, clamps overwrite all other diffs
+		if (sliderBig.clamp) {
+			if (changedBig || changedSmall)
+				return false;
+
+			if (sliderBig.value > 0.0f || sliderSmall.value > 0.0f)
+				clampActive = true;
+
+			continue;
+		}
+
+		if (sliderBig.zap && !sliderBig.uv) {
+			if (changedBig || changedSmall)
+				return false;
+
+			continue;
+		}
+
+		if (changedBig)
+			outChangedBig.push_back(i);
+		if (changedSmall)
+			outChangedSmall.push_back(i);
+	}
+
+	if (clampActive && (!outChangedBig.empty() || !outChangedSmall.empty()))
+		return false;
+
+	return true;
+}
+
+void BodySlideApp::ApplySliderDelta(const std::string& targetShape, Slider& slider, float oldValue, std::vector<Vector3>& verts, std::vector<Vector2>& uvs, std::vector<ushort>& outTouched) {
+	float newValue = slider.value;
+	if (slider.invert) {
+		newValue = 1.0f - newValue;
+		oldValue = 1.0f - oldValue;
+	}
+
+	float delta = newValue - oldValue;
+	if (delta == 0.0f)
+		return;
+
+	for (int j = 0; j < slider.linkedDataSets.size(); j++) {
+		if (slider.uv)
+			dataSets.ApplyUVDiff(slider.linkedDataSets[j], targetShape, delta, &uvs, &outTouched);
+		else
+			dataSets.ApplyDiff(slider.linkedDataSets[j], targetShape, delta, &verts, &outTouched);
+	}
+}
+
 void BodySlideApp::UpdatePreview() {
 	if (!preview)
 		return;
@@ -822,28 +944,97 @@ void BodySlideApp::UpdatePreview() {
 		return;
 	
 	int weight = preview->GetWeight();
-	std::vector<Vector3> verts, vertsLow, vertsHigh;
-	std::vector<Vector2> uvs, uvsLow, uvsHigh;
+	bool genWeights = activeSet.GenWeights();
+
+	std::vector<int> changedBig;
+	std::vector<int> changedSmall;
+	bool incremental = GetChangedPreviewSliders(changedBig, changedSmall);
+	if (!incremental)
+		previewMorphs.clear();
+
+	std::vector<Vector3> verts;
+	std::vector<Vector2> uvs;
 	std::vector<ushort> zapIdx;
+	std::vector<ushort> touched;
+	std::vector<int> touchedIndices;
 	for (auto it = activeSet.TargetShapesBegin(); it != activeSet.TargetShapesEnd(); ++it) {
+		if (incremental) {
+			auto morphIt = previewMorphs.find(it->first);
+			if (morphIt == previewMorphs.end())
+				continue;
+
+			// Only apply the difference of the sliders that changed
+			PreviewShapeMorph& morph = morphIt->second;
+			touched.clear();
+			for (auto &i : changedBig)
+				ApplySliderDelta(it->first, sliderManager.slidersBig[i], previewValuesBig[i], morph.vertsHigh, morph.uvsHigh, touched);
+
+			if (genWeights)
+				for (auto &i : changedSmall)
+					ApplySliderDelta(it->first, sliderManager.slidersSmall[i], previewValuesSmall[i], morph.vertsLow, morph.uvsLow, touched);
+
+			// Weight changes affect every vertex
+			if (weight != previewMorphWeight) {
+				touched.resize(morph.vertsHigh.size());
+				for (int i = 0; i < touched.size(); i++)
+					touched[i] = i;
+			}
+			else {
+				std::sort(touched.begin(), touched.end());
+				touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+			}
+
+			touchedIndices.clear();
+			verts.clear();
+			uvs.clear();
+			for (auto &i : touched) {
+				if (i >= morph.previewIndex.size() || morph.previewIndex[i] == -1)
+					continue;
+
+				touchedIndices.push_back(morph.previewIndex[i]);
+				verts.push_back((morph.vertsHigh[i] / 100.0f * weight) + (morph.vertsLow[i] / 100.0f * (100.0f - weight)));
+				uvs.push_back((morph.uvsHigh[i] / 100.0f * weight) + (morph.uvsLow[i] / 100.0f * (100.0f - weight)));
+			}
+
+			preview->UpdateMeshes(it->second, touchedIndices, verts, &uvs);
+			continue;
+		}
+
 		zapIdx.clear();
 		if (!previewBaseNif->GetVertsForShape(it->second, verts))
 			continue;
 
 		previewBaseNif->GetUvsForShape(it->second, uvs);
-		vertsHigh = verts;
-		vertsLow = verts;
-		uvsHigh = uvs;
-		uvsLow = uvs;
 
-		ApplySliders(it->first, sliderManager.slidersBig, vertsHigh, zapIdx, &uvsHigh);
-		if (activeSet.GenWeights())
-			ApplySliders(it->first, sliderManager.slidersSmall, vertsLow, zapIdx, &uvsLow);
+		PreviewShapeMorph& morph = previewMorphs[it->first];
+		morph.vertsHigh = verts;
+		morph.vertsLow = verts;
+		morph.uvsHigh = uvs;
+		morph.uvsLow = uvs;
+
+		ApplySliders(it->first, sliderManager.slidersBig, morph.vertsHigh, zapIdx, &morph.uvsHigh);
+		if (genWeights)
+			ApplySliders(it->first, sliderManager.slidersSmall, morph.vertsLow, zapIdx, &morph.uvsLow);
 
 		// Calculate result of weight
 		for (int i = 0; i < verts.size(); i++) {
-			verts[i] = (vertsHigh[i] / 100.0f * weight) + (vertsLow[i] / 100.0f * (100.0f - weight));
-			uvs[i] = (uvsHigh[i] / 100.0f * weight) + (uvsLow[i] / 100.0f * (100.0f - weight));
+			verts[i] = (morph.vertsHigh[i] / 100.0f * weight) + (morph.vertsLow[i] / 100.0f * (100.0f - weight));
+			uvs[i] = (morph.uvsHigh[i] / 100.0f * weight) + (morph.uvsLow[i] / 100.0f * (100.0f - weight));
+		}
+
+		// Map base vertices to their index in the zapped preview mesh
+		std::vector<ushort> zapSorted = zapIdx;
+		std::sort(zapSorted.begin(), zapSorted.end());
+		zapSorted.erase(std::unique(zapSorted.begin(), zapSorted.end()), zapSorted.end());
+
+		morph.previewIndex.resize(verts.size());
+		for (int i = 0, z = 0, p = 0; i < verts.size(); i++) {
+			if (z < zapSorted.size() && zapSorted[z] == i) {
+				morph.previewIndex[i] = -1;
+				z++;
+			}
+			else
+				morph.previewIndex[i] = p++;
 		}
 
 		// Zap deleted verts before applying to the shape
@@ -859,12 +1050,25 @@ void BodySlideApp::UpdatePreview() {
 		preview->UpdateMeshes(it->second, &verts, &uvs);
 	}
 
+	previewValuesBig.resize(sliderManager.slidersBig.size());
+	for (int i = 0; i < sliderManager.slidersBig.size(); i++)
+		previewValuesBig[i] = sliderManager.slidersBig[i].value;
+
+	previewValuesSmall.resize(sliderManager.slidersSmall.size());
+	for (int i = 0; i < sliderManager.slidersSmall.size(); i++)
+		previewValuesSmall[i] = sliderManager.slidersSmall[i].value;
+
+	previewMorphWeight = weight;
+	previewMorphsValid = true;
+
 	preview->SetNormalsGenerationLayers(activeSet.GetNormalsGenLayers());
 
 	preview->Render();
 }
 
 void BodySlideApp::CleanupPreview() {
+	InvalidatePreviewMorphs();
+
 	if (!preview)
 		return;
 
@@ -878,8 +1082,18 @@ void BodySlideApp::RebuildPreviewMeshes() {
 	if (!previewBaseNif)
 		return;
 
+	InvalidatePreviewMorphs();
+
 	int weight = preview->GetWeight();
-	PreviewMod.CopyFrom((*previewBaseNif));
+
+	// Only shapes that had vertices zapped diverge from the base, restore just those
+	bool restored = true;
+	for (auto it = activeSet.TargetShapesBegin(); it != activeSet.TargetShapesEnd() && restored; ++it)
+		if (PreviewMod.GetVertCountForShape(it->second) != previewBaseNif->GetVertCountForShape(it->second))
+			restored = PreviewMod.RestoreShapeFrom(*previewBaseNif, it->second);
+
+	if (!restored)
+		PreviewMod.CopyFrom((*previewBaseNif));
 	
 	std::vector<Vector3> verts, vertsLow, vertsHigh;
 	std::vector<Vector2> uvs, uvsLow, uvsHigh;
@@ -940,6 +1154,7 @@ bool BodySlideApp::SetDefaultConfig() {
 	Config.SetDefaultValue("WarnBatchBuildOverride", "true");
 	Config.SetDefaultValue("BSATextureScan", "true");
 	Config.SetDefaultValue("LogLevel", "3");
+	Config.SetDefaultValue("LogFlushInterval", 1000);
 	Config.SetDefaultValue("UseSystemLanguage", "false");
 	Config.SetDefaultValue("SelectedOutfit", "");
 	Config.SetDefaultValue("SelectedPreset", "");
@@ -947,6 +1162,7 @@ bool BodySlideApp::SetDefaultConfig() {
 	Config.SetDefaultValue("Input/SliderMaximum", 100);
 	Config.SetDefaultValue("Input/LeftMousePan", "false");
 	Config.SetDefaultValue("Editing/CenterMode", "Selected");
+	Config.SetDefaultValue("Rendering/PackedVertices", "false");
 	Config.SetDefaultValue("Lights/Ambient", 10);
 	Config.SetDefaultValue("Lights/Frontal", 20);
 	Config.SetDefaultValue("Lights/Directional0", 60);
@@ -1479,15 +1695,14 @@ int BodySlideApp::BuildBodies(bool localPath, bool clean, bool tri) {
 		return 0;
 	}
 
-	int error = nifBig.Load(inputFileName);
+	int error = nifBig.Load(inputFileName, true);
 	if (error) {
 		wxLogError("Failed to load '%s' (%d)!", inputFileName, error);
 		return 1;
 	}
 
 	if (activeSet.GenWeights())
-		if (nifSmall.Load(inputFileName))
-			return 1;
+		nifSmall.CopyFrom(nifBig);
 
 	std::vector<Vector3> vertsLow;
 	std::vector<Vector3> vertsHigh;
@@ -1539,7 +1754,7 @@ int BodySlideApp::BuildBodies(bool localPath, bool clean, bool tri) {
 		triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex("/+|\\\\+"), "\\");									// Replace multiple slashes or forward slashes with one backslash
 		triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex(".*meshes\\\\", std::regex_constants::icase), "");	// Remove everything before and including the meshes path
 
-		if (!WriteMorphTRI(outFileNameBig, activeSet, nifBig, zapIdxAll)) {
+		if (!WriteMorphTRI(outFileNameBig, activeSet, dataSets, nifBig, zapIdxAll)) {
 			wxLogError("Failed to write TRI file to '%s'!", triPath);
 			wxMessageBox(wxString().Format(_("Failed to write TRI file to the following location\n\n%s"), triPath), _("Unable to process"), wxOK | wxICON_ERROR);
 		}
@@ -1640,12 +1855,12 @@ int BodySlideApp::BuildBodies(bool localPath, bool clean, bool tri) {
 	return 0;
 }
 
-int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map<std::string, std::string>& failedOutfits, bool clean, bool tri, const std::string& custPath) {
+int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map<std::string, std::string>& failedOutfits, bool clean, bool tri, const std::string& custPath, bool normals) {
 	std::string datapath = custPath;
 	wxProgressDialog* progWnd;
 
-	wxLogMessage("Started batch build with options: Custom Path = %s, Cleaning = %s, TRI = %s",
-		custPath.empty() ? "False" : custPath, clean ? "True" : "False", tri ? "True" : "False");
+	wxLogMessage("Started batch build with options: Custom Path = %s, Cleaning = %s, TRI = %s, Normal Maps = %s",
+		custPath.empty() ? "False" : custPath, clean ? "True" : "False", tri ? "True" : "False", normals ? "True" : "False");
 
 	if (clean) {
 		int ret = wxMessageBox(_("WARNING: This will delete the output files from the output folders, potentially causing crashes.\n\nDo you want to continue?"), _("Clean Batch Build"), wxYES_NO | wxCANCEL | wxICON_EXCLAMATION);
@@ -1678,6 +1893,8 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 		datapath = Config["GameDataPath"];
 	}
 
+	std::string shapeDataPath = Config["ShapeDataPath"];
+
 	if (Config.MatchValue("WarnBatchBuildOverride", "true")) {
 		std::vector<wxArrayString> choicesList;
 		for (auto &filePath : outFileCount) {
@@ -1748,6 +1965,7 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 	// Multi-threading for 64-bit only due to memory limits of 32-bit builds
 #ifdef _PPL_H
 	concurrency::critical_section critical;
+	concurrency::critical_section normalsCritical;
 	concurrency::concurrent_unordered_map<std::string, std::string> failedOutfitsCon;
 	concurrency::parallel_for_each(outfitList.begin(), outfitList.end(), [&](const std::string& outfit)
 #else
@@ -1793,7 +2011,7 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 			return;
 		}
 
-		currentSet.SetBaseDataPath(Config["ShapeDataPath"]);
+		currentSet.SetBaseDataPath(shapeDataPath);
 
 		// ALT key
 		if (clean && custPath.empty()) {
@@ -1820,14 +2038,13 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 		/* Load input NIFs */
 		NifFile nifBig;
 		NifFile nifSmall;
-		if (nifBig.Load(currentSet.GetInputFileName())) {
+		if (nifBig.Load(currentSet.GetInputFileName(), true)) {
 			failedOutfitsCon[outfit] = _("Unable to load input nif: ") + currentSet.GetInputFileName();
 			return;
 		}
 
 		if (currentSet.GenWeights())
-			if (nifSmall.Load(currentSet.GetInputFileName()))
-				return;
+			nifSmall.CopyFrom(nifBig);
 
 		currentSet.LoadSetDiffData(currentDiffs);
 
@@ -1839,6 +2056,29 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 		std::vector<ushort> zapIdx;
 		std::unordered_map<std::string, std::vector<ushort>> zapIdxAll;
 
+		// Slider values are the same for all shapes, look them up once per slider
+		std::vector<float> valuesBig(currentSet.size());
+		std::vector<float> valuesSmall(currentSet.size());
+		for (int s = 0; s < currentSet.size(); s++) {
+			int sliderIndex = sliderManager.GetSliderIndex(currentSet[s].name);
+
+			valuesBig[s] = sliderManager.GetBigPresetValue(activePreset, currentSet[s].name, currentSet[s].defBigValue / 100.0f);
+			if (sliderIndex != -1) {
+				Slider& sliderBig = sliderManager.slidersBig[sliderIndex];
+				if (sliderBig.changed && !sliderBig.clamp)
+					valuesBig[s] = sliderBig.value;
+			}
+
+			if (currentSet.GenWeights()) {
+				valuesSmall[s] = sliderManager.GetSmallPresetValue(activePreset, currentSet[s].name, currentSet[s].defSmallValue / 100.0f);
+				if (sliderIndex != -1) {
+					Slider& sliderSmall = sliderManager.slidersSmall[sliderIndex];
+					if (sliderSmall.changed && !sliderSmall.clamp)
+						valuesSmall[s] = sliderSmall.value;
+				}
+			}
+		}
+
 		for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
 			if (!nifBig.GetVertsForShape(it->second, vertsHigh))
 				continue;
@@ -1868,23 +2108,9 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 					continue;
 				}
 
-				vbig = sliderManager.GetBigPresetValue(activePreset, currentSet[s].name, currentSet[s].defBigValue / 100.0f);
-				for (auto &sliderBig : sliderManager.slidersBig) {
-					if (sliderBig.name == currentSet[s].name && sliderBig.changed && !sliderBig.clamp) {
-						vbig = sliderBig.value;
-						break;
-					}
-				}
-
-				if (currentSet.GenWeights()) {
-					vsmall = sliderManager.GetSmallPresetValue(activePreset, currentSet[s].name, currentSet[s].defSmallValue / 100.0f);
-					for (auto &sliderSmall : sliderManager.slidersSmall) {
-						if (sliderSmall.name == currentSet[s].name && sliderSmall.changed && !sliderSmall.clamp) {
-							vsmall = sliderSmall.value;
-							break;
-						}
-					}
-				}
+				vbig = valuesBig[s];
+				if (currentSet.GenWeights())
+					vsmall = valuesSmall[s];
 
 				if (currentSet[s].bInvert) {
 					vbig = 1.0f - vbig;
@@ -1943,8 +2169,6 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 			zapIdx.clear();
 		}
 
-		currentDiffs.Clear();
-
 		/* Create directory for the outfit */
 		wxString dir = datapath + currentSet.GetOutputPath();
 		bool success = wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
@@ -1965,7 +2189,7 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 			triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex("/+|\\\\+"), "\\");									// Replace multiple slashes or forward slashes with one backslash
 			triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex(".*meshes\\\\", std::regex_constants::icase), "");	// Remove everything before and including the meshes path
 
-			if (!WriteMorphTRI(outFileNameBig, currentSet, nifBig, zapIdxAll)) {
+			if (!WriteMorphTRI(outFileNameBig, currentSet, currentDiffs, nifBig, zapIdxAll)) {
 				wxLogError("Failed to create TRI file to '%s'!", triPath);
 				wxLog::FlushActive();
 			}
@@ -2000,6 +2224,8 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 				wxRemoveFile(triPath);
 		}
 
+		currentDiffs.Clear();
+
 		/* Set filenames for the outfit */
 		if (currentSet.GenWeights()) {
 			outFileNameSmall += "_0.nif";
@@ -2024,6 +2250,27 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 			}
 		}
 
+		/* Generate the normal map from the built shapes */
+		if (normals && !currentSet.GetNormalsGenLayers().empty()) {
+			std::vector<std::string> normalShapes;
+			for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it)
+				normalShapes.push_back(it->second);
+
+#ifdef _PPL_H
+			// One normal map at a time, the compositor already runs in parallel and holds a full size texture
+			concurrency::critical_section::scoped_lock normalsLock(normalsCritical);
+#endif
+
+			NormalMapCompositor compositor(currentSet.GetNormalsGenLayers());
+			compositor.AddMeshes(nifBig, normalShapes);
+
+			std::string normalMapFile = datapath + currentSet.GetOutputFilePath() + "_msn.png";
+			if (!compositor.Composite() || !compositor.SaveFile(normalMapFile)) {
+				failedOutfitsCon[outfit] = _("Unable to generate normal map: ") + normalMapFile;
+				return;
+			}
+		}
+
 		return;
 #ifdef _PPL_H
 	});
@@ -2059,7 +2306,7 @@ void BodySlideApp::GroupBuild(const std::string& group) {
 	}
 
 	std::map<std::string, std::string> failedOutfits;
-	int ret = BuildListBodies(outfits, failedOutfits, false, cmdTri, cmdTargetDir.ToStdString());
+	int ret = BuildListBodies(outfits, failedOutfits, false, cmdTri, cmdTargetDir.ToStdString(), cmdNormalMaps);
 
 	if (!cmdPreset.IsEmpty())
 		Config.SetValue("SelectedPreset", preset);
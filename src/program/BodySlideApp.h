@@ -25,7 +25,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../components/SliderData.h"
 #include "../components/SliderManager.h"
 #include "../components/SliderGroup.h"
+#include "../components/SliderSetCatalogue.h"
 #include "../components/SliderCategories.h"
+#include "../components/NormalMapCompositor.h"
 #include "../files/TriFile.h"
 #include "../utils/Log.h"
 
@@ -46,6 +48,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <wx/progdlg.h>
 #include <wx/intl.h>
 #include <wx/clrpicker.h>
+#include <wx/stdpaths.h>
+#include <wx/filename.h>
 
 
 class BodySlideFrame;
@@ -62,6 +66,7 @@ class BodySlideApp : public wxApp {
 	wxString cmdTargetDir;
 	wxString cmdPreset;
 	bool cmdTri = false;
+	bool cmdNormalMaps = false;
 
 	/* Localization */
 	wxLocale* locale = nullptr;
@@ -83,6 +88,8 @@ class BodySlideApp : public wxApp {
 	std::vector<std::string> presetGroups;
 	std::vector<std::string> allGroups;
 	SliderSetGroupCollection gCollection;
+	SliderSetCatalogue setCatalogue;
+	bool setCatalogueLoaded = false;
 
 	std::map<std::string, std::vector<std::string>> outFileCount;	// Counts how many sets write to the same output file
 
@@ -91,6 +98,29 @@ class BodySlideApp : public wxApp {
 	NifFile* previewBaseNif = nullptr;
 	NifFile PreviewMod;
 
+	// Morphed vertex state of a preview shape, so slider changes can be applied as deltas.
+	struct PreviewShapeMorph {
+		std::vector<Vector3> vertsHigh;
+		std::vector<Vector3> vertsLow;
+		std::vector<Vector2> uvsHigh;
+		std::vector<Vector2> uvsLow;
+		std::vector<int> previewIndex;		// Index of each base vertex in the zapped preview mesh, -1 if zapped.
+	};
+
+	std::map<std::string, PreviewShapeMorph> previewMorphs;
+	std::vector<float> previewValuesBig;		// Slider values the preview morphs were evaluated with.
+	std::vector<float> previewValuesSmall;
+	int previewMorphWeight = -1;
+	bool previewMorphsValid = false;
+
+	void InvalidatePreviewMorphs() {
+		previewMorphs.clear();
+		previewMorphsValid = false;
+	}
+
+	bool GetChangedPreviewSliders(std::vector<int>& outChangedBig, std::vector<int>& outChangedSmall);
+	void ApplySliderDelta(const std::string& targetShape, Slider& slider, float oldValue, std::vector<Vector3>& verts, std::vector<Vector2>& uvs, std::vector<ushort>& outTouched);
+
 	int CreateSetSliders(const std::string& outfit);
 
 public:
@@ -174,7 +204,7 @@ public:
 	void LaunchOutfitStudio();
 
 	void ApplySliders(const std::string& targetShape, std::vector<Slider>& sliderSet, std::vector<Vector3>& verts, std::vector<ushort>& zapidx, std::vector<Vector2>* uvs = nullptr);
-	bool WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices);
+	bool WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, DiffDataSets& diffs, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices);
 
 	void CopySliderValues(bool toHigh);
 	void ShowPreview();
@@ -205,7 +235,7 @@ public:
 	void RebuildPreviewMeshes();
 
 	int BuildBodies(bool localPath = false, bool clean = false, bool tri = false);
-	int BuildListBodies(std::vector<std::string>& outfitList, std::map<std::string, std::string>& failedOutfits, bool remove = false, bool tri = false, const std::string& custPath = "");
+	int BuildListBodies(std::vector<std::string>& outfitList, std::map<std::string, std::string>& failedOutfits, bool remove = false, bool tri = false, const std::string& custPath = "", bool normals = false);
 	void GroupBuild(const std::string& group);
 
 	float GetSliderValue(const wxString& sliderName, bool isLo);
@@ -224,6 +254,7 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
 	{ wxCMD_LINE_OPTION, "t", "targetdir", "build target directory, defaults to game data path", wxCMD_LINE_VAL_STRING },
 	{ wxCMD_LINE_OPTION, "p", "preset", "preset used for the build, defaults to last used preset", wxCMD_LINE_VAL_STRING },
 	{ wxCMD_LINE_SWITCH, "tri", "trimorphs", "enables tri morph output for the specified build" },
+	{ wxCMD_LINE_SWITCH, "nm", "normalmaps", "generates the model space normal maps of sets with normals generation layers for the specified build" },
 	{ wxCMD_LINE_NONE }
 };
 
@@ -6,6 +6,48 @@ See the included LICENSE file
 
 #include "NormalsGenDialog.h"
 #include "PreviewWindow.h"
+#include "../utils/ThumbnailCache.h"
+
+CachedImageFileProperty::CachedImageFileProperty(const wxString& label, const wxString& name, const wxString& value)
+	: wxFileProperty(label, name, value)
+{
+	SetAttribute(wxPG_FILE_WILDCARD, wxImage::GetImageExtWildcard());
+	OnSetValue();
+}
+
+void CachedImageFileProperty::OnSetValue()
+{
+	wxFileProperty::OnSetValue();
+
+	static ThumbnailCache thumbnails(wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "BodySlideThumbnails");
+
+	thumbnail = wxImage();
+	thumbnailBitmap = wxBitmap();
+
+	wxString fileName = GetFileName().GetFullPath();
+	if (!fileName.IsEmpty())
+		thumbnails.Load(fileName, thumbnail);
+}
+
+wxSize CachedImageFileProperty::OnMeasureImage(int) const
+{
+	return wxPG_DEFAULT_IMAGE_SIZE;
+}
+
+void CachedImageFileProperty::OnCustomPaint(wxDC& dc, const wxRect& rect, wxPGPaintData&)
+{
+	if (thumbnail.IsOk()) {
+		if (!thumbnailBitmap.IsOk() || thumbnailBitmap.GetWidth() != rect.width || thumbnailBitmap.GetHeight() != rect.height)
+			thumbnailBitmap = wxBitmap(thumbnail.Scale(rect.width, rect.height, wxIMAGE_QUALITY_BOX_AVERAGE));
+
+		dc.DrawBitmap(thumbnailBitmap, rect.x, rect.y, false);
+	}
+	else {
+		// No file set or it couldn't be loaded
+		dc.SetBrush(*wxWHITE_BRUSH);
+		dc.DrawRectangle(rect);
+	}
+}
 
 NormalsGenDialog::NormalsGenDialog(wxWindow* parent, std::vector<NormalGenLayer>& inLayersRef)
 	: wxNormalsGenDlg(parent), refNormalGenLayers(inLayersRef)
@@ -280,7 +322,7 @@ void NormalsGenDialog::addBGLayer(NormalGenLayer & newLayer)
 
 	newCat = pgLayers->Append(new wxPropertyCategory(newLayer.layerName, "Background"));
 
-	newProp = pgLayers->Append(new wxImageFileProperty(_("Background File"), _("Background File"), newLayer.sourceFileName));
+	newProp = pgLayers->Append(new CachedImageFileProperty(_("Background File"), _("Background File"), newLayer.sourceFileName));
 	pgLayers->SetPropertyHelpString(newProp, _("File source for this layer."));
 	newProp = pgLayers->Append(new wxColourProperty(_("Color"), _("Color"), wxColour(newLayer.fillColor[0], newLayer.fillColor[1], newLayer.fillColor[2])));
 	pgLayers->SetPropertyHelpString(newProp, _("Solid background color (if file is not set)."));
@@ -302,14 +344,14 @@ void NormalsGenDialog::addLayer(NormalGenLayer & newLayer, wxPGProperty * before
 	else
 		newCat = pgLayers->Append(new wxPropertyCategory(newLayer.layerName, internalName));
 
-	newProp = newCat->AppendChild(new wxImageFileProperty(_("File"), internalName + "File", newLayer.sourceFileName));
+	newProp = newCat->AppendChild(new CachedImageFileProperty(_("File"), internalName + "File", newLayer.sourceFileName));
 	newProp->SetAttribute("Wildcard", "PNG files (*.png)|*.png");
 	pgLayers->SetPropertyHelpString(newProp, _("File containing normals data to combine. Note this file should fit the mesh UVs."));
 
 	newProp = newCat->AppendChild(new wxBoolProperty(_("Is Tangent Space?"), internalName + "IsTangent", newLayer.isTangentSpace));
 	pgLayers->SetPropertyHelpString(newProp, _("True if the normals data in the layer file is in tangent space, false if they are in model space (msn)."));
 
-	newProp = newCat->AppendChild(new wxImageFileProperty(_("Mask"), internalName + "Mask", newLayer.maskFileName));
+	newProp = newCat->AppendChild(new CachedImageFileProperty(_("Mask"), internalName + "Mask", newLayer.maskFileName));
 	pgLayers->SetPropertyHelpString(newProp, _("A greyscale image used to mask updates to destination image."));
 
 	newProp = newCat->AppendChild(new wxUIntProperty(_("X Offset"), internalName + "XOffset", newLayer.xOffset));
@@ -9,6 +9,22 @@ See the included LICENSE file
 #include "../ui/wxNormalsGenDlg.h"
 #include "../components/NormalGenLayers.h"
 
+// Image file property with the preview image taken from the thumbnail cache,
+// so that large DDS textures aren't decoded in full every time the grid is built.
+class CachedImageFileProperty : public wxFileProperty
+{
+public:
+	CachedImageFileProperty(const wxString& label = wxPG_LABEL, const wxString& name = wxPG_LABEL, const wxString& value = wxEmptyString);
+
+	virtual void OnSetValue() wxOVERRIDE;
+	virtual wxSize OnMeasureImage(int item) const wxOVERRIDE;
+	virtual void OnCustomPaint(wxDC& dc, const wxRect& rect, wxPGPaintData& paintData) wxOVERRIDE;
+
+protected:
+	wxImage thumbnail;
+	wxBitmap thumbnailBitmap;
+};
+
 class NormalsGenDialog : public wxNormalsGenDlg
 {
 protected:
@@ -465,13 +465,13 @@ int OutfitProject::CreateNifShapeFromData(const std::string& shapeName, std::vec
 		}
 
 		NiTriShape* nifTriShape = new NiTriShape();
+		nifTriShape->SetName(shapeName);
 		blank.GetHeader().AddBlock(nifTriShape);
 		if (owner->targetGame < SKYRIM)
 			nifTriShape->propertyRefs.AddBlockRef(shaderID);
 		else
 			nifTriShape->SetShaderPropertyRef(shaderID);
 
-		nifTriShape->SetName(shapeName);
 		nifTriShape->SetDataRef(shapeID);
 		nifTriShape->SetSkinInstanceRef(dismemberID);
 
@@ -482,6 +482,7 @@ int OutfitProject::CreateNifShapeFromData(const std::string& shapeName, std::vec
 		std::string wetShaderName = "template/OutfitTemplate_Wet.bgsm";
 		BSSubIndexTriShape* nifBSTriShape = new BSSubIndexTriShape();
 		nifBSTriShape->Create(&v, &t, &uv, norms);
+		nifBSTriShape->SetName(shapeName);
 		blank.GetHeader().AddBlock(nifBSTriShape);
 
 		BSSkinInstance* nifBSSkinInstance = new BSSkinInstance();
@@ -501,12 +502,12 @@ int OutfitProject::CreateNifShapeFromData(const std::string& shapeName, std::vec
 		nifShader->SetTextureSetRef(blank.GetHeader().AddBlock(nifTexset));
 		nifShader->SetWetMaterialName(wetShaderName);
 
-		triShapeBase->SetName(shapeName);
 		triShapeBase->SetShaderPropertyRef(shaderID);
 	}
 	else {
 		BSTriShape* triShape = new BSTriShape();
 		triShape->Create(&v, &t, &uv, norms);
+		triShape->SetName(shapeName);
 		blank.GetHeader().AddBlock(triShape);
 
 		NiSkinData* nifSkinData = new NiSkinData();
@@ -529,7 +530,6 @@ int OutfitProject::CreateNifShapeFromData(const std::string& shapeName, std::vec
 		int shaderID = blank.GetHeader().AddBlock(nifShader);
 		nifShader->SetTextureSetRef(blank.GetHeader().AddBlock(nifTexset));
 
-		triShape->SetName(shapeName);
 		triShape->SetShaderPropertyRef(shaderID);
 
 		blank.SetDefaultPartition(shapeName);
@@ -652,7 +652,7 @@ void OutfitProject::SetSliderName(int index, const std::string& newName) {
 		activeSet[index].SetLocalData(newDT);
 	}
 
-	activeSet[index].name = newName;
+	activeSet.RenameSlider(index, newName);
 }
 
 float& OutfitProject::SliderValue(int index) {
@@ -1724,7 +1724,7 @@ int OutfitProject::LoadReference(const std::string& fileName, const std::string&
 	for (auto &cloth : clothDataBlocks)
 		clothData[inMeshFile] = cloth->Clone();
 
-	refNif.GetHeader().DeleteBlockByType("BSClothExtraData");
+	refNif.DeleteBlockByType("BSClothExtraData");
 
 	if (workNif.IsValid()) {
 		// Copy only reference shape
@@ -2044,7 +2044,7 @@ int OutfitProject::ImportNIF(const std::string& fileName, bool clear, const std:
 	for (auto &cloth : clothDataBlocks)
 		clothData[fileName] = cloth->Clone();
 
-	nif.GetHeader().DeleteBlockByType("BSClothExtraData");
+	nif.DeleteBlockByType("BSClothExtraData");
 
 	nif.GetShapeList(nifShapes);
 	if (workNif.IsValid()) {
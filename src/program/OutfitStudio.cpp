@@ -5981,6 +5981,7 @@ void wxGLPanel::OnShown() {
 	}
 
 	gls.Initialize(this, context);
+	gls.SetPackedVertices(Config.MatchValue("Rendering/PackedVertices", "true"));
 	auto size = GetSize();
 	gls.SetStartingView(Vector3(0.0f, -5.0f, -15.0f), Vector3(15.0f, 0.0f, 0.0f), size.GetWidth(), size.GetHeight());
 	gls.SetMaskVisible();
@@ -6599,7 +6600,8 @@ bool wxGLPanel::RedoStroke() {
 }
 
 void wxGLPanel::ShowTransformTool(bool show, bool keepVisibility) {
-	std::string mode = Config.GetString("Editing/CenterMode");
+	ConfigurationKey centerModeKey("Editing/CenterMode");
+	std::string mode = Config.GetString(centerModeKey);
 	if (mode == "Object") {
 		if (!gls.GetActiveMeshes().empty())
 			xformCenter = gls.GetActiveMeshes().back()->CreateBVH()->Center();
@@ -6838,7 +6840,8 @@ void wxGLPanel::OnMouseMove(wxMouseEvent& event) {
 			SelectVertex(event.GetPosition());
 		}
 		else {
-			if (Config.MatchValue("Input/LeftMousePan", "true")) {
+			ConfigurationKey leftMousePanKey("Input/LeftMousePan");
+			if (Config.MatchValue(leftMousePanKey, "true")) {
 				gls.PanCamera(x - lastX, y - lastY);
 				UpdateTransformTool();
 			}
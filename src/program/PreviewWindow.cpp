@@ -66,6 +66,7 @@ void PreviewWindow::OnShown() {
 
 	wxLogMessage("Initializing preview window...");
 	gls.Initialize(canvas, context);
+	gls.SetPackedVertices(Config.MatchValue("Rendering/PackedVertices", "true"));
 	auto size = canvas->GetSize();
 	gls.SetStartingView(Vector3(0.0f, -5.0f, -15.0f), Vector3(15.0f, 0.0f, 0.0f), size.GetWidth(), size.GetHeight(), 65.0);
 
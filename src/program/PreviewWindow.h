@@ -83,7 +83,18 @@ public:
 
 		mesh* m = gls.GetMesh(shapeName);
 		if (m)
-			m->SmoothNormals(changed);
+			m->SmoothNormalsLocal(std::vector<int>(changed.begin(), changed.end()));
+	}
+
+	void UpdateMeshes(std::string& shapeName, const std::vector<int>& indices, const std::vector<Vector3>& verts, const std::vector<Vector2>* uvs = nullptr) {
+		if (indices.empty())
+			return;
+
+		gls.Update(gls.GetMeshID(shapeName), indices, verts, uvs);
+
+		mesh* m = gls.GetMesh(shapeName);
+		if (m)
+			m->SmoothNormalsLocal(indices);
 	}
 
 	void SetShapeTextures(const std::string& shapeName, const std::vector<std::string>& textureFiles, const std::string& vShader, const std::string& fShader, const bool hasMatFile = false, const MaterialFile& matFile = MaterialFile()) {
@@ -525,7 +525,7 @@ void ShapeProperties::ChangeExtraDataType(int id) {
 	int selection = extraDataType->GetSelection();
 
 	int index = extraDataIndices[id];
-	nif->GetHeader().DeleteBlock(index);
+	nif->DeleteBlock(index);
 
 	for (int i = 0; i < extraDataIndices.size(); i++)
 		if (extraDataIndices[i] > index)
@@ -562,7 +562,7 @@ void ShapeProperties::RemoveExtraData(int id) {
 	extraDataValue->Destroy();
 
 	int index = extraDataIndices[id];
-	nif->GetHeader().DeleteBlock(index);
+	nif->DeleteBlock(index);
 
 	for (int i = 0; i < extraDataIndices.size(); i++)
 		if (extraDataIndices[i] > index)
@@ -346,9 +346,12 @@ bool GLSurface::CollideMeshes(int ScreenX, int ScreenY, Vector3& outOrigin, Vect
 
 				int min_i = 0;
 				float minDist = results[0].HitDistance;
-				for (int i = 1; i < results.size(); i++)
-					if (results[i].HitDistance < minDist)
+				for (int i = 1; i < results.size(); i++) {
+					if (results[i].HitDistance < minDist) {
+						minDist = results[i].HitDistance;
 						min_i = i;
+					}
+				}
 
 				Vector3 origin = results[min_i].HitCoord;
 
@@ -407,9 +410,12 @@ bool GLSurface::CollideOverlay(int ScreenX, int ScreenY, Vector3& outOrigin, Vec
 
 				int min_i = 0;
 				float minDist = results[0].HitDistance;
-				for (int i = 1; i < results.size(); i++)
-					if (results[i].HitDistance < minDist)
+				for (int i = 1; i < results.size(); i++) {
+					if (results[i].HitDistance < minDist) {
+						minDist = results[i].HitDistance;
 						min_i = i;
+					}
+				}
 
 				Vector3 origin = results[min_i].HitCoord;
 
@@ -488,9 +494,12 @@ bool GLSurface::UpdateCursor(int ScreenX, int ScreenY, bool allMeshes, std::stri
 
 				int min_i = 0;
 				float minDist = results[0].HitDistance;
-				for (int i = 1; i < results.size(); i++)
-					if (results[i].HitDistance < minDist)
+				for (int i = 1; i < results.size(); i++) {
+					if (results[i].HitDistance < minDist) {
+						minDist = results[i].HitDistance;
 						min_i = i;
+					}
+				}
 
 				Vector3 origin = results[min_i].HitCoord;
 
@@ -570,9 +579,12 @@ bool GLSurface::GetCursorVertex(int ScreenX, int ScreenY, int* outIndex) {
 			if (results.size() > 0) {
 				int min_i = 0;
 				float minDist = results[0].HitDistance;
-				for (int i = 1; i < results.size(); i++)
-					if (results[i].HitDistance < minDist)
+				for (int i = 1; i < results.size(); i++) {
+					if (results[i].HitDistance < minDist) {
+						minDist = results[i].HitDistance;
 						min_i = i;
+					}
+				}
 
 				Vector3 origin = results[min_i].HitCoord;
 
@@ -819,13 +831,19 @@ void GLSurface::RenderMesh(mesh* m) {
 
 		if (m->norms) {
 			glBindBuffer(GL_ARRAY_BUFFER, m->vbo[1]);
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);		// Normals
+			if (m->packedVertices)
+				glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 0, (GLvoid*)0);
+			else
+				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);		// Normals
 			glEnableVertexAttribArray(1);
 		}
 
 		if (m->vcolors) {
 			glBindBuffer(GL_ARRAY_BUFFER, m->vbo[2]);
-			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);		// Colors
+			if (m->packedVertices)
+				glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (GLvoid*)0);
+			else
+				glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);		// Colors
 			glEnableVertexAttribArray(2);
 		}
 
@@ -833,7 +851,10 @@ void GLSurface::RenderMesh(mesh* m) {
 			shader.SetAlphaProperties(m->alphaFlags, m->alphaThreshold / 255.0f);
 
 			glBindBuffer(GL_ARRAY_BUFFER, m->vbo[3]);
-			glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);		// Texture Coordinates
+			if (m->packedVertices)
+				glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+			else
+				glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);		// Texture Coordinates
 			glEnableVertexAttribArray(3);
 
 			m->material->BindTextures(largestAF, m->backlight);
@@ -933,6 +954,7 @@ void GLSurface::AddMeshFromNif(NifFile* nif, const std::string& shapeName, Vecto
 	const std::vector<Vector2>* nifUvs = nif->GetUvsForShape(shapeName);
 
 	mesh* m = new mesh();
+	m->packedVertices = bPackedVertices;
 
 	NiShader* shader = nif->GetShader(shapeName);
 	if (shader) {
@@ -1448,23 +1470,54 @@ void GLSurface::Update(int shapeIndex, std::vector<Vector3>* vertices, std::vect
 
 	Vector3 old;
 	for (int i = 0; i < m->nVerts; i++) {
-		if (changed)
-			old = m->verts[i];
+		old = m->verts[i];
 
 		m->verts[i].x = (*vertices)[i].x / -10.0f;
 		m->verts[i].z = (*vertices)[i].y / 10.0f;
 		m->verts[i].y = (*vertices)[i].z / 10.0f;
 
-		if (uvs)
+		if (uvs && m->texcoord[i] != (*uvs)[i]) {
 			m->texcoord[i] = (*uvs)[i];
+			m->QueueUpdate(mesh::UpdateType::TextureCoordinates, i);
+		}
+
+		// Only upload vertices that actually moved
+		if (old != m->verts[i]) {
+			m->QueueUpdate(mesh::UpdateType::Position, i);
 
-		if (changed && old != m->verts[i])
-			(*changed).insert(i);
+			if (changed)
+				(*changed).insert(i);
+		}
 	}
+}
+
+void GLSurface::Update(int shapeIndex, const std::vector<int>& indices, const std::vector<Vector3>& vertices, const std::vector<Vector2>* uvs) {
+	if (shapeIndex < 0 || shapeIndex >= meshes.size())
+		return;
+
+	if (indices.size() != vertices.size())
+		return;
+
+	if (uvs && uvs->size() != indices.size())
+		return;
+
+	mesh* m = meshes[shapeIndex];
+	for (int i = 0; i < indices.size(); i++) {
+		int v = indices[i];
+		if (v < 0 || v >= m->nVerts)
+			continue;
 
-	m->QueueUpdate(mesh::UpdateType::Position);
-	if (uvs)
-		m->QueueUpdate(mesh::UpdateType::TextureCoordinates);
+		m->verts[v].x = vertices[i].x / -10.0f;
+		m->verts[v].z = vertices[i].y / 10.0f;
+		m->verts[v].y = vertices[i].z / 10.0f;
+
+		m->QueueUpdate(mesh::UpdateType::Position, v);
+
+		if (uvs) {
+			m->texcoord[v] = (*uvs)[i];
+			m->QueueUpdate(mesh::UpdateType::TextureCoordinates, v);
+		}
+	}
 }
 
 void GLSurface::RecalculateMeshBVH(const std::string& shapeName) {
@@ -1480,7 +1533,7 @@ void GLSurface::RecalculateMeshBVH(int shapeIndex) {
 		return;
 
 	mesh* m = meshes[shapeIndex];
-	m->CreateBVH();
+	m->UpdateBVH();
 }
 
 void GLSurface::SetMeshVisibility(const std::string& name, bool visible) {
@@ -33,6 +33,7 @@ class GLSurface {
 	bool bMaskVisible = false;
 	bool bWeightColors = false;
 	bool bSegmentColors = false;
+	bool bPackedVertices = false;
 
 	float defLineWidth = 1.0f;
 	float defPointSize = 5.0f;
@@ -257,6 +258,9 @@ public:
 	void AddMeshFromNif(NifFile* nif, const std::string& shapeName, Vector3* color = nullptr, bool smoothNormalSeams = true);
 	void Update(const std::string& shapeName, std::vector<Vector3>* vertices, std::vector<Vector2>* uvs = nullptr, std::set<int>* changed = nullptr);
 	void Update(int shapeIndex, std::vector<Vector3>* vertices, std::vector<Vector2>* uvs = nullptr, std::set<int>* changed = nullptr);
+
+	// Updates only the listed vertices, with vertices[i] and uvs[i] belonging to indices[i].
+	void Update(int shapeIndex, const std::vector<int>& indices, const std::vector<Vector3>& vertices, const std::vector<Vector2>* uvs = nullptr);
 	void ReloadMeshFromNif(NifFile* nif, std::string shapeName);
 	void RecalculateMeshBVH(const std::string& shapeName);
 	void RecalculateMeshBVH(int shapeIndex);
@@ -329,4 +333,9 @@ public:
 		for (auto &m : meshes)
 			UpdateShaders(m);
 	}
+
+	// Meshes added after this use packed normals, colors and texture coordinates on the GPU.
+	void SetPackedVertices(bool bPacked = true) {
+		bPackedVertices = bPacked;
+	}
 };
@@ -6,6 +6,8 @@ See the included LICENSE file
 
 #include "AABBTree.h"
 
+#include <algorithm>
+
 AABB::AABB(const Vector3& newMin, const Vector3& newMax) {
 	min = newMin;
 	max = newMax;
@@ -139,7 +141,7 @@ void AABB::Merge(Vector3* points, ushort* indices, int nPoints) {
 	}
 }
 
-void AABB::Merge(AABB& other) {
+void AABB::Merge(const AABB& other) {
 	if (other.min.x < min.x) min.x = other.min.x;
 	if (other.min.y < min.y) min.y = other.min.y;
 	if (other.min.z < min.z) min.z = other.min.z;
@@ -289,401 +291,277 @@ bool AABB::IntersectSphere(Vector3& Origin, float radius) {
 	return d <= radius * radius;
 }
 
-AABBTree::AABBTreeNode::AABBTreeNode(std::vector<int>& facetIndices, int start, int end, AABBTree* treeRef, AABBTreeNode* parentRef, int depth) {
-	int axis;
-	Vector3 axis_avg;
-	tree = treeRef;
-	parent = parentRef;
-	int moreStart = 0;
+static inline float AxisValue(const Vector3& v, int axis) {
+	if (axis == 0)
+		return v.x;
+	else if (axis == 1)
+		return v.y;
 
-	if (facetIndices.size() < treeRef->MinFacets())
-		return;
+	return v.z;
+}
 
-	// calculate this node's containing AABB and the geometric average
-	treeRef->CalcAABBandGeoAvg(facetIndices, start, end, mBB, axis_avg);
+static inline float SurfaceArea(const AABB& bb) {
+	Vector3 d = bb.max - bb.min;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
 
-	// Force a leaf if the facet count gets below a certain threshold or the depth becomes too large.
-	if ((end - start + 1) <= treeRef->MinFacets() || depth > treeRef->MaxDepth()) {
-		nFacets = end - start + 1;
-		mIFacets = std::make_unique<int[]>(nFacets);
-		int p = 0;
-		for (int f = start; f <= end; f++)
-			mIFacets[p++] = facetIndices[f];
+AABBTree::AABBTree(Vector3* vertices, Triangle* facets, int nFacets, int maxDepth, int minFacets) {
+	triRef = facets;
+	vertexRef = vertices;
+	numFacets = nFacets;
+	max_depth = maxDepth;
+	min_facets = minFacets;
 
-		return;
-	}
+	facetIndices.resize(nFacets);
+	buildCentroids.resize(nFacets);
+	buildBounds.resize(nFacets);
 
-	// determine split axis
-	Vector3 diag = mBB.max - mBB.min;
-	axis = 0;
-	float curmax = diag.x;
-	if (diag.y > curmax) {
-		axis = 1;
-		curmax = diag.y;
+	for (int i = 0; i < nFacets; i++) {
+		facetIndices[i] = i;
+		triRef[i].midpoint(vertexRef, buildCentroids[i]);
+		buildBounds[i] = AABB(vertexRef, (ushort*)&triRef[i], 3);
 	}
 
-	if (diag.z > curmax)
-		axis = 2;
+	// A balanced binary tree needs less than two nodes per facet
+	nodes.reserve(std::max(1, 2 * nFacets / std::max(1, min_facets)));
+	BuildNode(0, nFacets, -1, 0);
 
-	int l = start;
-	float lval;
+	buildCentroids.clear();
+	buildCentroids.shrink_to_fit();
+	buildBounds.clear();
+	buildBounds.shrink_to_fit();
+}
 
-	int r = end;
-	float rval;
+int AABBTree::BuildNode(int start, int end, int parent, int depth) {
+	int index = nodes.size();
+	nodes.emplace_back();
+	nodes[index].parent = parent;
 
-	switch (axis) {
-	case 0:
-		lval = treeRef->triRef[facetIndices[l]].AxisMidPointX(treeRef->vertexRef);
-		rval = treeRef->triRef[facetIndices[r]].AxisMidPointX(treeRef->vertexRef);
-		while (l < r) {
-			while (lval < axis_avg.x && l != r) {
-				lval = treeRef->triRef[facetIndices[++l]].AxisMidPointX(treeRef->vertexRef);
-			}
-			while (rval >= axis_avg.x && r != l) {
-				rval = treeRef->triRef[facetIndices[--r]].AxisMidPointX(treeRef->vertexRef);
-			}
-			moreStart = r;
-			if (r == l) {
-				break;
-			}
-			std::swap(facetIndices[l], facetIndices[r]);
-			lval = treeRef->triRef[facetIndices[++l]].AxisMidPointX(treeRef->vertexRef);
-			rval = treeRef->triRef[facetIndices[--r]].AxisMidPointX(treeRef->vertexRef);
-		}
-		break;
-
-	case 1:
-		lval = treeRef->triRef[facetIndices[l]].AxisMidPointY(treeRef->vertexRef);
-		rval = treeRef->triRef[facetIndices[r]].AxisMidPointY(treeRef->vertexRef);
-		while (l < r) {
-			while (lval < axis_avg.y && l != r) {
-				lval = treeRef->triRef[facetIndices[++l]].AxisMidPointY(treeRef->vertexRef);
-			}
-			while (rval >= axis_avg.y && r != l) {
-				rval = treeRef->triRef[facetIndices[--r]].AxisMidPointY(treeRef->vertexRef);
-			}
-			moreStart = r;
-			if (r == l) {
-				break;
-			}
-			std::swap(facetIndices[l], facetIndices[r]);
-			lval = treeRef->triRef[facetIndices[++l]].AxisMidPointY(treeRef->vertexRef);
-			rval = treeRef->triRef[facetIndices[--r]].AxisMidPointY(treeRef->vertexRef);
-		}
-		break;
-
-	case 2:
-		lval = treeRef->triRef[facetIndices[l]].AxisMidPointZ(treeRef->vertexRef);
-		rval = treeRef->triRef[facetIndices[r]].AxisMidPointZ(treeRef->vertexRef);
-		while (l < r) {
-			while (lval < axis_avg.z && l != r) {
-				lval = treeRef->triRef[facetIndices[++l]].AxisMidPointZ(treeRef->vertexRef);
-			}
-			while (rval >= axis_avg.z && r != l) {
-				rval = treeRef->triRef[facetIndices[--r]].AxisMidPointZ(treeRef->vertexRef);
-			}
-			moreStart = r;
-			if (r == l)
-				break;
+	int count = end - start;
+	if (count > 0) {
+		AABB bb = buildBounds[facetIndices[start]];
+		for (int i = start + 1; i < end; i++)
+			bb.Merge(buildBounds[facetIndices[i]]);
 
-			std::swap(facetIndices[l], facetIndices[r]);
-			lval = treeRef->triRef[facetIndices[++l]].AxisMidPointZ(treeRef->vertexRef);
-			rval = treeRef->triRef[facetIndices[--r]].AxisMidPointZ(treeRef->vertexRef);
-		}
-		break;
+		nodes[index].mBB = bb;
 	}
 
-	if (moreStart == start)
-		moreStart = (end + start) / 2;
-
-	P = std::make_unique<AABBTreeNode>(facetIndices, moreStart, end, treeRef, this, depth + 1);
-	N = std::make_unique<AABBTreeNode>(facetIndices, start, moreStart - 1, treeRef, this, depth + 1);
-}
-
-AABBTree::AABBTreeNode::AABBTreeNode(std::vector<int>& facetIndices, AABBTree* treeRef, AABBTreeNode* parentRef, int depth) {
-	int axis;
-	Vector3 axis_avg;
-	tree = treeRef;
-	parent = parentRef;
-
 	// Force a leaf if the facet count gets below a certain threshold or the depth becomes too large.
-	if (facetIndices.size() <= treeRef->MinFacets() || depth > treeRef->MaxDepth()) {
-		treeRef->CalcAABBandGeoAvg(facetIndices, mBB, axis_avg);
-		nFacets = facetIndices.size();
-		mIFacets = std::make_unique<int[]>(nFacets);
-		for (int f = 0; f < facetIndices.size(); f++)
-			mIFacets[f] = facetIndices[f];
+	if (count <= min_facets || depth > max_depth) {
+		nodes[index].firstFacet = start;
+		nodes[index].nFacets = count;
+		return index;
+	}
+
+	int mid = start;
+	SplitPlane split;
+	if (FindSplit(start, end, split)) {
+		auto it = std::partition(facetIndices.begin() + start, facetIndices.begin() + end, [&](int f) {
+			int b = (int)((AxisValue(buildCentroids[f], split.axis) - split.binMin) * split.binScale);
+			return std::min(b, sahBins - 1) <= split.bin;
+		});
+		mid = it - facetIndices.begin();
+	}
+
+	// Split by count when the centroids can't be separated
+	if (mid == start || mid == end) {
+		Vector3 diag = nodes[index].mBB.max - nodes[index].mBB.min;
+		int axis = 0;
+		if (diag.y > diag.x)
+			axis = 1;
+		if (diag.z > AxisValue(diag, axis))
+			axis = 2;
+
+		mid = (start + end) / 2;
+		std::nth_element(facetIndices.begin() + start, facetIndices.begin() + mid, facetIndices.begin() + end, [&](int a, int b) {
+			return AxisValue(buildCentroids[a], axis) < AxisValue(buildCentroids[b], axis);
+		});
+	}
+
+	BuildNode(start, mid, index, depth + 1);
+	int right = BuildNode(mid, end, index, depth + 1);
+	nodes[index].right = right;
+	return index;
+}
 
-		return;
+bool AABBTree::FindSplit(int start, int end, SplitPlane& outSplit) {
+	AABB centroidBB(buildCentroids[facetIndices[start]], buildCentroids[facetIndices[start]]);
+	for (int i = start + 1; i < end; i++) {
+		Vector3& c = buildCentroids[facetIndices[i]];
+		centroidBB.Merge(AABB(c, c));
 	}
 
-	// less and more indx lists
-	std::vector<int> less;
-	std::vector<int> more;
-
-	// calculate this node's containing AABB and the geometric average
-	treeRef->CalcAABBandGeoAvg(facetIndices, mBB, axis_avg);
-
-	// determine split axis
-	Vector3 diag = mBB.max - mBB.min;
-	axis = 0;
-	float curmax = diag.x;
-	if (diag.y > curmax) {
+	Vector3 extent = centroidBB.max - centroidBB.min;
+	int axis = 0;
+	if (extent.y > extent.x)
 		axis = 1;
-		curmax = diag.y;
-	}
-
-	if (diag.z > curmax)
+	if (extent.z > AxisValue(extent, axis))
 		axis = 2;
 
-	int facetnum;
-	switch (axis) {
-	case 0:
-		for (int i = 0; i < facetIndices.size(); i++) {
-			facetnum = facetIndices[i];
-			if (treeRef->triRef[facetnum].AxisMidPointX(treeRef->vertexRef) < axis_avg.x) {
-				less.push_back(facetnum);
-			}
-			else
-				more.push_back(facetnum);
-		}
-
-		break;
+	float axisExtent = AxisValue(extent, axis);
+	if (axisExtent <= 0.0f)
+		return false;
 
-	case 1:
-		for (int i = 0; i < facetIndices.size(); i++) {
-			facetnum = facetIndices[i];
-			if (treeRef->triRef[facetnum].AxisMidPointY(treeRef->vertexRef) < axis_avg.y) {
-				less.push_back(facetnum);
-			}
+	struct Bin {
+		AABB bb;
+		int count = 0;
+	} bins[sahBins];
+
+	float binMin = AxisValue(centroidBB.min, axis);
+	float binScale = sahBins / axisExtent;
+
+	for (int i = start; i < end; i++) {
+		int f = facetIndices[i];
+		int b = std::min((int)((AxisValue(buildCentroids[f], axis) - binMin) * binScale), sahBins - 1);
+		if (bins[b].count == 0)
+			bins[b].bb = buildBounds[f];
+		else
+			bins[b].bb.Merge(buildBounds[f]);
+
+		bins[b].count++;
+	}
+
+	// Sweep from the right to get the area and count of everything above each split
+	float rightArea[sahBins];
+	int rightCount[sahBins];
+	AABB accum;
+	int accumCount = 0;
+	for (int b = sahBins - 1; b > 0; b--) {
+		if (bins[b].count > 0) {
+			if (accumCount == 0)
+				accum = bins[b].bb;
 			else
-				more.push_back(facetnum);
-		}
-		break;
+				accum.Merge(bins[b].bb);
 
-	case 2:
-		for (int i = 0; i < facetIndices.size(); i++) {
-			facetnum = facetIndices[i];
-			if (treeRef->triRef[facetnum].AxisMidPointZ(treeRef->vertexRef) < axis_avg.z) {
-				less.push_back(facetnum);
-			}
-			else
-				more.push_back(facetnum);
+			accumCount += bins[b].count;
 		}
-		break;
-	}
 
-	//  Split lists when all midpoints fall on one side of axis or the other
-	int sz = more.size();
-	int numFacets = facetIndices.size();
-	if (sz == 0 || sz == numFacets) {
-		if (sz > less.size()) {
-			sz = sz / 2;
-			less.assign(more.begin(), more.begin() + sz);
-			more.erase(more.begin(), more.begin() + sz);
-		}
-		else {
-			sz = less.size() / 2;
-			more.assign(less.begin(), less.begin() + sz);
-			less.erase(less.begin(), less.begin() + sz);
-		}
+		rightArea[b] = accumCount > 0 ? SurfaceArea(accum) : 0.0f;
+		rightCount[b] = accumCount;
 	}
 
-	P = std::make_unique<AABBTreeNode>(more, treeRef, this, depth + 1);
-	N = std::make_unique<AABBTreeNode>(less, treeRef, this, depth + 1);
-}
-
-Vector3 AABBTree::AABBTreeNode::Center() {
-	return ((mBB.max + mBB.min) / 2);
-}
-
-void AABBTree::AABBTreeNode::AddDebugFrames(std::vector<Vector3>& verts, std::vector<Edge>& edges, int maxdepth, int curdepth) {
-	if (curdepth <= maxdepth) {
-		mBB.AddBoxToMesh(verts, edges);
-	} // else return;
-
-	if (P) P->AddDebugFrames(verts, edges, maxdepth, curdepth + 1);
-	if (N) N->AddDebugFrames(verts, edges, maxdepth, curdepth + 1);
-}
+	float bestCost = std::numeric_limits<float>::max();
+	int bestBin = -1;
+	accumCount = 0;
+	for (int b = 0; b < sahBins - 1; b++) {
+		if (bins[b].count > 0) {
+			if (accumCount == 0)
+				accum = bins[b].bb;
+			else
+				accum.Merge(bins[b].bb);
 
-void AABBTree::AABBTreeNode::AddRayIntersectFrames(Vector3& origin, Vector3& direction, std::vector<Vector3>& verts, std::vector<Edge>& edges) {
-	bool collision = mBB.IntersectRay(origin, direction, nullptr);
-	if (collision)
-		mBB.AddBoxToMesh(verts, edges);
-	else
-		return;
+			accumCount += bins[b].count;
+		}
 
-	if (P) P->AddRayIntersectFrames(origin, direction, verts, edges);
-	if (N) N->AddRayIntersectFrames(origin, direction, verts, edges);
-}
+		if (accumCount == 0 || rightCount[b + 1] == 0)
+			continue;
 
-bool AABBTree::AABBTreeNode::IntersectRay(Vector3& origin, Vector3& direction, std::vector<IntersectResult>* results) {
-	IntersectResult r;
-	bool collision = mBB.IntersectRay(origin, direction, nullptr);
-	if (!collision) return false;
-
-	if (!P && !N) {
-		for (int i = 0; i < nFacets; i++) {
-			int f = mIFacets[i];
-			if (tree->triRef[f].IntersectRay(tree->vertexRef, origin, direction, &r.HitDistance, &r.HitCoord)) {
-				if (results) {
-					r.HitFacet = mIFacets[i];
-					r.bvhNode = this;
-					results->push_back(r);
-				}
-				return true;
-			}
+		float cost = accumCount * SurfaceArea(accum) + rightCount[b + 1] * rightArea[b + 1];
+		if (cost < bestCost) {
+			bestCost = cost;
+			bestBin = b;
 		}
-		return false;
 	}
 
-	bool Pcollide = false;
-	bool Ncollide = false;
-	if (P)
-		Pcollide = P->IntersectRay(origin, direction, results);
-
-	if (N)
-		Ncollide = N->IntersectRay(origin, direction, results);
+	if (bestBin < 0)
+		return false;
 
-	return Pcollide || Ncollide;
+	outSplit.axis = axis;
+	outSplit.bin = bestBin;
+	outSplit.binMin = binMin;
+	outSplit.binScale = binScale;
+	return true;
 }
 
-bool AABBTree::AABBTreeNode::IntersectSphere(Vector3 &origin, float radius, std::vector<IntersectResult> *results) {
-	IntersectResult r;
-	bool collision = mBB.IntersectSphere(origin, radius);
-	if (!collision)
-		return false;
-
-	if (!P && !N) {
-		bool found = false;
-		for (int i = 0; i < nFacets; i++) {
-			int f = mIFacets[i];
-			if (tree->triRef[f].IntersectSphere(tree->vertexRef, origin, radius)) {
-				if (results) {
-					r.HitFacet = mIFacets[i];
-					r.bvhNode = this;
-					results->push_back(r);
-					found = true;
-				}
-				else {
-					return true;
-				}
-			}
-		}
-		return found;
-	}
+void AABBTree::RefitLeaf(AABBTreeNode& node) {
+	if (node.nFacets <= 0)
+		return;
 
-	bool Pcollide = false;
-	bool Ncollide = false;
-	if (P)
-		Pcollide = P->IntersectSphere(origin, radius, results);
-	if (N)
-		Ncollide = N->IntersectSphere(origin, radius, results);
+	AABB bb(vertexRef, (ushort*)&triRef[facetIndices[node.firstFacet]], 3);
+	for (int i = node.firstFacet + 1; i < node.firstFacet + node.nFacets; i++)
+		bb.Merge(vertexRef, (ushort*)&triRef[facetIndices[i]], 3);
 
-	return Pcollide || Ncollide;
+	node.mBB = bb;
 }
 
-void AABBTree::AABBTreeNode::UpdateAABB(AABB* childBB) {
-	if (!childBB) {
-		Vector3 bogus;
-		tree->CalcAABBandGeoAvg(mIFacets.get(), 0, nFacets - 1, mBB, bogus);
-	}
-	else
-		mBB.Merge((*childBB));
+int AABBTree::MinFacets() { return min_facets; }
+int AABBTree::MaxDepth() { return max_depth; }
 
-	if (parent)
-		parent->UpdateAABB(&mBB);
+bool AABBTree::IsBuiltFor(Vector3* vertices, Triangle* facets, int nFacets) {
+	return vertexRef == vertices && triRef == facets && numFacets == nFacets;
 }
 
-AABBTree::AABBTree(Vector3* vertices, Triangle* facets, int nFacets, int maxDepth, int minFacets) {
-	triRef = facets;
-	vertexRef = vertices;
-	max_depth = maxDepth;
-	min_facets = minFacets;
-
-	std::vector<int> facetIndices(nFacets, 0);
-	for (int i = 0; i < nFacets; i++)
-		facetIndices[i] = i;
-
-	root = std::make_unique<AABBTreeNode>(facetIndices, 0, nFacets - 1, this, nullptr, 0);
+Vector3 AABBTree::Center() {
+	return nodes[0].Center();
 }
 
-int AABBTree::MinFacets() { return min_facets; }
-int AABBTree::MaxDepth() { return max_depth; }
+AABBTree::AABBTreeNode* AABBTree::GetNode(int index) {
+	if (index < 0 || index >= nodes.size())
+		return nullptr;
 
-Vector3 AABBTree::Center() {
-	return root->Center();
+	return &nodes[index];
 }
 
-void AABBTree::CalcAABBandGeoAvg(std::vector<int>& forFacets, AABB& outBB, Vector3& outAxisAvg) {
-	if (forFacets.empty())
-		return;
+int AABBTree::GetNodeCount() {
+	return nodes.size();
+}
 
-	Vector3 mid;
-	outAxisAvg = Vector3(0.0f, 0.0f, 0.0f);
-	AABB tmpBB(vertexRef, (ushort*)(&triRef[forFacets[0]]), 3);
-	for (int i = 0; i < forFacets.size(); i++) {
-		triRef[forFacets[i]].midpoint(vertexRef, mid);
-		outAxisAvg += (mid / forFacets.size());
-		tmpBB.Merge(vertexRef, (ushort*)&triRef[forFacets[i]], 3);
+void AABBTree::Refit() {
+	// Children are always stored after their parent
+	for (int i = nodes.size() - 1; i >= 0; i--) {
+		AABBTreeNode& node = nodes[i];
+		if (node.IsLeaf()) {
+			RefitLeaf(node);
+		}
+		else {
+			node.mBB = nodes[i + 1].mBB;
+			node.mBB.Merge(nodes[node.right].mBB);
+		}
 	}
-	outBB = tmpBB;
 }
 
-void AABBTree::CalcAABBandGeoAvg(std::vector<int>& forFacets, int start, int end, AABB& outBB, Vector3& outAxisAvg) {
-	if (forFacets.empty())
-		return;
+void AABBTree::Refit(const std::unordered_set<int>& leafNodes) {
+	std::vector<int> ancestors;
+	for (auto &n : leafNodes) {
+		if (n < 0 || n >= nodes.size())
+			continue;
 
-	Vector3 mid;
-	//float ytot = 0;
-	//float yaxis = 0;
-	outAxisAvg = Vector3(0.0f, 0.0f, 0.0f);
-
-	AABB tmpBB(vertexRef, (ushort*)(&triRef[forFacets[start]]), 3);
-	int fcount = end - start + 1;
-	for (int i = start; i <= end; i++) {
-		triRef[forFacets[i]].midpoint(vertexRef, mid);
-		outAxisAvg.x += mid.x;
-		outAxisAvg.y += mid.y;
-		outAxisAvg.z += mid.z;
-		tmpBB.Merge(vertexRef, (ushort*)&triRef[forFacets[i]], 3);
-	}
-	outAxisAvg /= fcount;
-	outBB = tmpBB;
-}
+		RefitLeaf(nodes[n]);
+		for (int p = nodes[n].parent; p >= 0; p = nodes[p].parent)
+			ancestors.push_back(p);
+	}
+
+	// Deepest nodes have the highest indices, update those first
+	std::sort(ancestors.begin(), ancestors.end(), std::greater<int>());
+	ancestors.erase(std::unique(ancestors.begin(), ancestors.end()), ancestors.end());
 
-void AABBTree::CalcAABBandGeoAvg(int forFacets[], int start, int end, AABB& outBB, Vector3& outAxisAvg) {
-	Vector3 mid;
-	//float ytot = 0;
-	//float yaxis = 0;
-	outAxisAvg = Vector3(0.0f, 0.0f, 0.0f);
-
-	AABB tmpBB(vertexRef, (ushort*)(&triRef[forFacets[start]]), 3);
-	int fcount = end - start + 1;
-	for (int i = start; i <= end; i++) {
-		triRef[forFacets[i]].midpoint(vertexRef, mid);
-		outAxisAvg.x += mid.x;
-		outAxisAvg.y += mid.y;
-		outAxisAvg.z += mid.z;
-		tmpBB.Merge(vertexRef, (ushort*)&triRef[forFacets[i]], 3);
-	}
-	outAxisAvg /= fcount;
-	outBB = tmpBB;
+	for (auto &p : ancestors) {
+		AABBTreeNode& node = nodes[p];
+		node.mBB = nodes[p + 1].mBB;
+		node.mBB.Merge(nodes[node.right].mBB);
+	}
 }
 
 void AABBTree::BuildDebugFrames(Vector3** outVerts, int* outNumVerts, Edge** outEdges, int* outNumEdges) {
 	std::vector<Vector3> v;
 	std::vector<Edge> e;
 
-	root->AddDebugFrames(v, e, 8);
+	const int maxDepth = 8;
+	std::vector<std::pair<int, int>> stack;
+	stack.emplace_back(0, 0);
+	while (!stack.empty()) {
+		int n = stack.back().first;
+		int depth = stack.back().second;
+		stack.pop_back();
 
-	//	m->rendermode = 1;
-	//	m->color = Vector3(0,.2,0);
-	//	m->nVerts =  v.size();
-	//	m->verts = new Vector3[m->nVerts];
+		AABBTreeNode& node = nodes[n];
+		node.mBB.AddBoxToMesh(v, e);
 
-	//	m->nEdges = e.size();
-	//	m->edges = new Edge[m->nEdges];
+		if (!node.IsLeaf() && depth < maxDepth) {
+			stack.emplace_back(node.right, depth + 1);
+			stack.emplace_back(n + 1, depth + 1);
+		}
+	}
 
 	int vc = v.size();
 	(*outNumVerts) = vc;
@@ -693,13 +571,10 @@ void AABBTree::BuildDebugFrames(Vector3** outVerts, int* outNumVerts, Edge** out
 	(*outNumEdges) = ec;
 	(*outEdges) = new Edge[ec];
 
-	for (int i = 0; i < vc; i++){
-		//m->verts[i] = v[i];
+	for (int i = 0; i < vc; i++)
 		(*outVerts)[i] = v[i];
-	}
+
 	for (int i = 0; i < ec; i++) {
-		//m->edges[i].p1 = e[i].p1;
-		//m->edges[i].p2 = e[i].p2;
 		(*outEdges)[i].p1 = e[i].p1;
 		(*outEdges)[i].p2 = e[i].p2;
 	}
@@ -709,24 +584,24 @@ void AABBTree::BuildRayIntersectFrames(Vector3& origin, Vector3& direction, Vect
 	std::vector<Vector3> v;
 	std::vector<Edge> e;
 	bFlag = false;
-	root->AddRayIntersectFrames(origin, direction, v, e);
 
-	//m->rendermode = 1;
-	//m->color = Vector3(.8,.8,0);
-	//
-	//m->nVerts =  v.size();
-	//m->verts = new Vector3[m->nVerts];
+	std::vector<int> stack;
+	stack.push_back(0);
+	while (!stack.empty()) {
+		int n = stack.back();
+		stack.pop_back();
 
-	//m->nEdges = e.size();
-	//m->edges = new Edge[m->nEdges];
+		AABBTreeNode& node = nodes[n];
+		if (!node.mBB.IntersectRay(origin, direction, nullptr))
+			continue;
 
-	//for(int i =0 ;i< m->nVerts; i++ ){
-	//	m->verts[i] = v[i];
-	//}
-	//for(int i=0;i<m->nEdges; i++) {
-	//	m->edges[i].p1 = e[i].p1;
-	//	m->edges[i].p2 = e[i].p2;
-	//}
+		node.mBB.AddBoxToMesh(v, e);
+
+		if (!node.IsLeaf()) {
+			stack.push_back(node.right);
+			stack.push_back(n + 1);
+		}
+	}
 
 	int vc = v.size();
 	(*outNumVerts) = vc;
@@ -736,9 +611,9 @@ void AABBTree::BuildRayIntersectFrames(Vector3& origin, Vector3& direction, Vect
 	(*outNumEdges) = ec;
 	(*outEdges) = new Edge[ec];
 
-	for (int i = 0; i < vc; i++){
+	for (int i = 0; i < vc; i++)
 		(*outVerts)[i] = v[i];
-	}
+
 	for (int i = 0; i < ec; i++) {
 		(*outEdges)[i].p1 = e[i].p1;
 		(*outEdges)[i].p2 = e[i].p2;
@@ -746,9 +621,86 @@ void AABBTree::BuildRayIntersectFrames(Vector3& origin, Vector3& direction, Vect
 }
 
 bool AABBTree::IntersectRay(Vector3& origin, Vector3& direction, std::vector<IntersectResult>* results) {
-	return root->IntersectRay(origin, direction, results);
+	if (nodes.empty())
+		return false;
+
+	bool collision = false;
+	IntersectResult r;
+
+	std::vector<int> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		int n = stack.back();
+		stack.pop_back();
+
+		AABBTreeNode& node = nodes[n];
+		if (!node.mBB.IntersectRay(origin, direction, nullptr))
+			continue;
+
+		if (!node.IsLeaf()) {
+			stack.push_back(node.right);
+			stack.push_back(n + 1);
+			continue;
+		}
+
+		for (int i = node.firstFacet; i < node.firstFacet + node.nFacets; i++) {
+			int f = facetIndices[i];
+			if (triRef[f].IntersectRay(vertexRef, origin, direction, &r.HitDistance, &r.HitCoord)) {
+				if (!results)
+					return true;
+
+				r.HitFacet = f;
+				r.bvhNode = n;
+				results->push_back(r);
+				collision = true;
+				break;
+			}
+		}
+	}
+
+	return collision;
 }
 
 bool AABBTree::IntersectSphere(Vector3& origin, float radius, std::vector<IntersectResult>* results) {
-	return root->IntersectSphere(origin, radius, results);
+	if (nodes.empty())
+		return false;
+
+	bool collision = false;
+	IntersectResult r;
+
+	std::vector<int> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		int n = stack.back();
+		stack.pop_back();
+
+		AABBTreeNode& node = nodes[n];
+		if (!node.mBB.IntersectSphere(origin, radius))
+			continue;
+
+		if (!node.IsLeaf()) {
+			stack.push_back(node.right);
+			stack.push_back(n + 1);
+			continue;
+		}
+
+		for (int i = node.firstFacet; i < node.firstFacet + node.nFacets; i++) {
+			int f = facetIndices[i];
+			if (triRef[f].IntersectSphere(vertexRef, origin, radius)) {
+				if (!results)
+					return true;
+
+				r.HitFacet = f;
+				r.bvhNode = n;
+				results->push_back(r);
+				collision = true;
+			}
+		}
+	}
+
+	return collision;
 }
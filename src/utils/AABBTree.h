@@ -3,6 +3,7 @@
 #include "../NIF/utils/Object3d.h"
 
 #include <memory>
+#include <unordered_set>
 
 struct IntersectResult;
 
@@ -19,7 +20,7 @@ struct AABB {
 	void AddBoxToMesh(std::vector<Vector3>& verts, std::vector<Edge>& edges);
 
 	void Merge(Vector3* points, ushort* indices, int nPoints);
-	void Merge(AABB& other);
+	void Merge(const AABB& other);
 
 	bool IntersectAABB(AABB& other);
 
@@ -29,61 +30,81 @@ struct AABB {
 };
 
 class AABBTree {
-	int max_depth = 100;
-	int min_facets = 2;
-	Vector3* vertexRef = nullptr;
-	Triangle* triRef = nullptr;
-
 public:
-	bool bFlag = false;
-	int depthCounter = 0;
-	int sentinel = 0;
-
-	class AABBTreeNode {
-		std::unique_ptr<AABBTreeNode> N;
-		std::unique_ptr<AABBTreeNode> P;
-		AABBTreeNode* parent = nullptr;
+	// Flat tree node. The first child of an inner node always directly follows it in the node array,
+	// the second child is referenced by index. Leaves reference a range of the facet index array.
+	struct AABBTreeNode {
 		AABB mBB;
-		AABBTree* tree = nullptr;
-		std::unique_ptr<int[]> mIFacets;
+		int parent = -1;
+		int right = -1;
+		int firstFacet = 0;
 		int nFacets = 0;
 
-	public:
-		AABBTreeNode() {}
+		bool IsLeaf() const {
+			return right < 0;
+		}
 
-		// Recursively generates AABB Tree nodes using the referenced data.
-		AABBTreeNode(std::vector<int>& facetIndices, AABBTree* treeRef, AABBTreeNode* parentRef, int depth);
+		Vector3 Center() {
+			return ((mBB.max + mBB.min) / 2);
+		}
+	};
 
-		// As above, but facetIndices is modified with in-place sorting rather than using vector::push_back to generate sub lists.
-		// Sorting swaps from front of list to end when pos midpoints are found at the beginning of the list.
-		AABBTreeNode(std::vector<int>& facetIndices, int start, int end, AABBTree* treeRef, AABBTreeNode* parentRef, int depth);
+private:
+	static const int sahBins = 12;
 
-		Vector3 Center();
+	int max_depth = 100;
+	int min_facets = 2;
+	int numFacets = 0;
+	Vector3* vertexRef = nullptr;
+	Triangle* triRef = nullptr;
+
+	std::vector<AABBTreeNode> nodes;
+	std::vector<int> facetIndices;
+
+	// Facet centroids and bounds, only kept around during the build.
+	std::vector<Vector3> buildCentroids;
+	std::vector<AABB> buildBounds;
 
-		void AddDebugFrames(std::vector<Vector3>& verts, std::vector<Edge>& edges, int maxdepth = 0, int curdepth = 0);
-		void AddRayIntersectFrames(Vector3& origin, Vector3& direction, std::vector<Vector3>& verts, std::vector<Edge>& edges);
-		bool IntersectRay(Vector3& origin, Vector3& direction, std::vector<IntersectResult>* results);
-		bool IntersectSphere(Vector3& origin, float radius, std::vector<IntersectResult>* results);
-		void UpdateAABB(AABB* childBB = nullptr);
+	// Builds the subtree for the facet index range [start, end) and returns its node index.
+	int BuildNode(int start, int end, int parent, int depth);
+
+	struct SplitPlane {
+		int axis = 0;
+		int bin = 0;
+		float binMin = 0.0f;
+		float binScale = 0.0f;
 	};
 
-	std::unique_ptr<AABBTreeNode> root;
+	// Finds the cheapest binned SAH split of the facet centroids in the range.
+	// Returns false if the centroids can't be separated.
+	bool FindSplit(int start, int end, SplitPlane& outSplit);
+
+	// Recalculates the bounding box of a leaf from the current vertex positions.
+	void RefitLeaf(AABBTreeNode& node);
 
 public:
+	bool bFlag = false;
+
 	AABBTree() {}
 	AABBTree(Vector3* vertices, Triangle* facets, int nFacets, int maxDepth, int minFacets);
 
 	int MinFacets();
 	int MaxDepth();
 
+	// True if the tree was built for the given geometry and can be refitted instead of rebuilt.
+	bool IsBuiltFor(Vector3* vertices, Triangle* facets, int nFacets);
+
 	Vector3 Center();
 
-	// Calculate bounding box and geometric average.
-	void CalcAABBandGeoAvg(std::vector<int>& forFacets, AABB& outBB, Vector3& outAxisAvg);
+	AABBTreeNode* GetNode(int index);
+	int GetNodeCount();
+
+	// Refits the bounding boxes of all nodes bottom-up after vertices were moved.
+	void Refit();
+
+	// Refits only the given leaves and their ancestors after vertices were moved.
+	void Refit(const std::unordered_set<int>& leafNodes);
 
-	// Calculate bounding box and geometric average for sub list.
-	void CalcAABBandGeoAvg(std::vector<int>& forFacets, int start, int end, AABB& outBB, Vector3& outAxisAvg);
-	void CalcAABBandGeoAvg(int forFacets[], int start, int end, AABB& outBB, Vector3& outAxisAvg);
 	void BuildDebugFrames(Vector3** outVerts, int* outNumVerts, Edge** outEdges, int* outNumEdges);
 	void BuildRayIntersectFrames(Vector3& origin, Vector3& direction, Vector3** outVerts, int* outNumVerts, Edge** outEdges, int* outNumEdges);
 	bool IntersectRay(Vector3& origin, Vector3& direction, std::vector<IntersectResult>* results = nullptr);
@@ -94,5 +115,5 @@ struct IntersectResult {
 	int HitFacet = 0;
 	float HitDistance = 0.0f;
 	Vector3 HitCoord;
-	AABBTree::AABBTreeNode* bvhNode = nullptr;
+	int bvhNode = -1;
 };
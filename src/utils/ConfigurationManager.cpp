@@ -6,6 +6,8 @@ See the included LICENSE file
 
 #include "ConfigurationManager.h"
 
+#include <atomic>
+
 ConfigurationItem::~ConfigurationItem() {
 	for (auto &it : properties)
 		delete it;
@@ -252,6 +254,44 @@ void ConfigurationManager::Clear() {
 		delete ci;
 
 	ciList.clear();
+	UpdateIndex();
+}
+
+// Revisions are unique across all managers, so a key can't mistake one for another
+static std::atomic<unsigned int> lastIndexRevision(0);
+
+void ConfigurationManager::UpdateIndex() {
+	ciIndex.clear();
+	indexRevision = ++lastIndexRevision;
+	IndexItems(ciList, "");
+}
+
+void ConfigurationManager::IndexItems(const std::vector<ConfigurationItem*>& items, const std::string& prefix) {
+	// Lookups pick the last of several items with the same name.
+	// Names containing a separator can't be looked up at all.
+	std::unordered_map<std::string, ConfigurationItem*, ConfigurationKeyHash, ConfigurationKeyEqual> lastItems;
+	for (auto &ci : items) {
+		if (ci->isComment || ci->name.find_first_of("/.") != std::string::npos)
+			continue;
+
+		lastItems[ci->name] = ci;
+	}
+
+	for (auto &last : lastItems) {
+		ConfigurationItem* ci = last.second;
+		std::string key = prefix + ci->name;
+		ciIndex[key] = ci;
+
+		// The first property with a name is found, and property names can contain separators
+		std::vector<ConfigurationItem*> props;
+		ci->EnumerateProperties(props);
+		for (auto &prop : props)
+			ciIndex.emplace(key + "." + prop->name, prop);
+
+		std::vector<ConfigurationItem*> children;
+		ci->EnumerateChildren(children, false, false);
+		IndexItems(children, key + "/");
+	}
 }
 
 int ConfigurationManager::LoadConfig(const std::string& pathToFile, const std::string& rootElement) {
@@ -276,6 +316,8 @@ int ConfigurationManager::LoadConfig(const std::string& pathToFile, const std::s
 
 		child = child->NextSibling();
 	}
+
+	UpdateIndex();
 	return 0;
 }
 
@@ -313,6 +355,23 @@ bool ConfigurationManager::Exists(const std::string& name) {
 }
 
 ConfigurationItem* ConfigurationManager::FindCI(const std::string& inName) {
+	auto it = ciIndex.find(inName);
+	if (it != ciIndex.end())
+		return it->second;
+
+	return nullptr;
+}
+
+ConfigurationItem* ConfigurationManager::FindCI(ConfigurationKey& key) {
+	if (key.revision != indexRevision) {
+		key.item = FindCI(key.name);
+		key.revision = indexRevision;
+	}
+
+	return key.item;
+}
+
+ConfigurationItem* ConfigurationManager::FindCIByTree(const std::string& inName) {
 	ConfigurationItem* found = nullptr;
 	int pos = inName.find_first_of("/.");
 
@@ -341,10 +400,8 @@ ConfigurationItem* ConfigurationManager::FindCI(const std::string& inName) {
 	return found;
 }
 
-int ConfigurationManager::GetIntValue(const std::string& inName, int def) {
+static int ItemIntValue(ConfigurationItem* itemFound, int def) {
 	int res = def;
-
-	ConfigurationItem* itemFound = FindCI(inName);
 	if (itemFound)
 		if (!itemFound->value.empty())
 			res = atoi(itemFound->value.c_str());
@@ -352,10 +409,8 @@ int ConfigurationManager::GetIntValue(const std::string& inName, int def) {
 	return res;
 }
 
-float ConfigurationManager::GetFloatValue(const std::string& inName, float def) {
+static float ItemFloatValue(ConfigurationItem* itemFound, float def) {
 	float res = def;
-
-	ConfigurationItem* itemFound = FindCI(inName);
 	if (itemFound)
 		if (!itemFound->value.empty())
 			res = (float)atof(itemFound->value.c_str());
@@ -363,6 +418,22 @@ float ConfigurationManager::GetFloatValue(const std::string& inName, float def)
 	return res;
 }
 
+int ConfigurationManager::GetIntValue(const std::string& inName, int def) {
+	return ItemIntValue(FindCI(inName), def);
+}
+
+int ConfigurationManager::GetIntValue(ConfigurationKey& key, int def) {
+	return ItemIntValue(FindCI(key), def);
+}
+
+float ConfigurationManager::GetFloatValue(const std::string& inName, float def) {
+	return ItemFloatValue(FindCI(inName), def);
+}
+
+float ConfigurationManager::GetFloatValue(ConfigurationKey& key, float def) {
+	return ItemFloatValue(FindCI(key), def);
+}
+
 std::string ConfigurationManager::GetString(const std::string& inName) {
 	ConfigurationItem* itemFound = FindCI(inName);
 	if (itemFound)
@@ -371,6 +442,14 @@ std::string ConfigurationManager::GetString(const std::string& inName) {
 	return "";
 }
 
+std::string ConfigurationManager::GetString(ConfigurationKey& key) {
+	ConfigurationItem* itemFound = FindCI(key);
+	if (itemFound)
+		return itemFound->value;
+
+	return "";
+}
+
 void ConfigurationManager::SetDefaultValue(const std::string& inName, const std::string& newValue) {
 	if (FindCI(inName))
 		return;
@@ -410,6 +489,7 @@ void ConfigurationManager::SetValue(const std::string& inName, const std::string
 			if (pos == -1) {
 				newCI->value = newValue;
 				newCI->isDefault = flagDefault;
+				UpdateIndex();
 				return;
 			}
 		}
@@ -418,6 +498,8 @@ void ConfigurationManager::SetValue(const std::string& inName, const std::string
 			itemFound->AddChild(search.substr(pos + 1), newValue)->isDefault = flagDefault;
 		else
 			itemFound->AddChild(search.substr(pos + 1), newValue, false)->isDefault = flagDefault;
+
+		UpdateIndex();
 	}
 }
 
@@ -433,8 +515,7 @@ void ConfigurationManager::SetValue(const std::string& inName, float newValue, b
 	SetValue(inName, std::string(intStr), flagDefault);
 }
 
-bool ConfigurationManager::MatchValue(const std::string& inName, const std::string& val, bool useCase) {
-	ConfigurationItem* itemFound = FindCI(inName);
+static bool ItemMatchValue(ConfigurationItem* itemFound, const std::string& val, bool useCase) {
 	if (itemFound) {
 		if (!useCase) {
 			if (!_stricmp(itemFound->value.c_str(), val.c_str()))
@@ -448,6 +529,14 @@ bool ConfigurationManager::MatchValue(const std::string& inName, const std::stri
 	return false;
 }
 
+bool ConfigurationManager::MatchValue(const std::string& inName, const std::string& val, bool useCase) {
+	return ItemMatchValue(FindCI(inName), val, useCase);
+}
+
+bool ConfigurationManager::MatchValue(ConfigurationKey& key, const std::string& val, bool useCase) {
+	return ItemMatchValue(FindCI(key), val, useCase);
+}
+
 void ConfigurationManager::GetFullKey(ConfigurationItem* from, std::string& outStr) {
 	std::vector<std::string> stringStack;
 	outStr.clear();
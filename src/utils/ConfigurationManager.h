@@ -8,6 +8,7 @@ See the included LICENSE file
 
 #include "../TinyXML-2/tinyxml2.h"
 
+#include <cctype>
 #include <vector>
 #include <unordered_map>
 #include <wx/string.h>
@@ -66,11 +67,51 @@ public:
 	}
 };
 
+// Case-insensitive hashing and comparison of configuration paths
+struct ConfigurationKeyHash {
+	size_t operator()(const std::string& key) const {
+		size_t hash = 2166136261U;
+		for (auto &c : key) {
+			hash ^= (size_t)tolower((unsigned char)c);
+			hash *= 16777619U;
+		}
+		return hash;
+	}
+};
+
+struct ConfigurationKeyEqual {
+	bool operator()(const std::string& lhs, const std::string& rhs) const {
+		return lhs.size() == rhs.size() && !_stricmp(lhs.c_str(), rhs.c_str());
+	}
+};
+
+// A configuration path that remembers the item it resolved to. The item is looked up again only
+// after the structure of the configuration changed. Don't share a key between threads.
+class ConfigurationKey {
+	friend class ConfigurationManager;
+
+	std::string name;
+	ConfigurationItem* item = nullptr;
+	unsigned int revision = 0;
+
+public:
+	explicit ConfigurationKey(const std::string& inName) : name(inName) { }
+};
+
 class ConfigurationManager
 {
 	std::vector<ConfigurationItem*> ciList;
 	std::string file;
+
+	// Full path of every reachable item, e.g. "Lights/Directional0.x"
+	std::unordered_map<std::string, ConfigurationItem*, ConfigurationKeyHash, ConfigurationKeyEqual> ciIndex;
+	unsigned int indexRevision = 0;
+
+	void UpdateIndex();
+	void IndexItems(const std::vector<ConfigurationItem*>& items, const std::string& prefix);
+
 	ConfigurationItem* FindCI(const std::string& inName);
+	ConfigurationItem* FindCI(ConfigurationKey& key);
 
 public:
 	ConfigurationManager();
@@ -87,10 +128,16 @@ public:
 
 	bool Exists(const std::string& inName);
 
+	// Looks the name up by walking the item tree instead of using the index.
+	ConfigurationItem* FindCIByTree(const std::string& inName);
+
 	std::string GetString(const std::string& inName);
+	std::string GetString(ConfigurationKey& key);
 
 	int GetIntValue(const std::string& inName, int def = 0);
+	int GetIntValue(ConfigurationKey& key, int def = 0);
 	float GetFloatValue(const std::string& inName, float def = 0.0f);
+	float GetFloatValue(ConfigurationKey& key, float def = 0.0f);
 
 	void SetValue(const std::string& inName, const std::string& newValue, bool flagDefault = false);
 	void SetValue(const std::string& inName, int newValue, bool flagDefault = false);
@@ -100,6 +147,7 @@ public:
 	void SetDefaultValue(const std::string& inName, int newValue);
 
 	bool MatchValue(const std::string& inName, const std::string& val, bool useCase = false);
+	bool MatchValue(ConfigurationKey& key, const std::string& val, bool useCase = false);
 
 	void GetFullKey(ConfigurationItem* from, std::string& outstr);
 
@@ -118,6 +166,10 @@ public:
 		return GetString(inName.ToStdString());
 	}
 
+	std::string operator [] (ConfigurationKey& key) {
+		return GetString(key);
+	}
+
 	/* Utility function to replace variables within a string with matching configuration data.  Variables
 		are surrounded by %.  EG  :  "%GameDataPath%rest of path"  might become "D:\\Skyrim\\Data\\rest of path.
 		a double percent "%%" will be replaced with a single %, while a single % without matching variable will destroy most of the string.
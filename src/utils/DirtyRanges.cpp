@@ -0,0 +1,102 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "DirtyRanges.h"
+
+#include <algorithm>
+
+DirtyRanges::DirtyRanges(int maxRanges, int mergeGap) {
+	this->maxRanges = std::max(1, maxRanges);
+	this->mergeGap = std::max(0, mergeGap);
+}
+
+void DirtyRanges::Add(int index) {
+	Add(index, index + 1);
+}
+
+void DirtyRanges::Add(int start, int end) {
+	if (all || start >= end)
+		return;
+
+	// First range that ends at or after the new start (including the merge gap)
+	auto it = std::lower_bound(ranges.begin(), ranges.end(), start, [&](const Range& r, int s) {
+		return r.end + mergeGap < s;
+	});
+
+	if (it == ranges.end() || it->start > end + mergeGap) {
+		ranges.insert(it, Range(start, end));
+	}
+	else {
+		// Absorb every range the new one touches
+		it->start = std::min(it->start, start);
+		it->end = std::max(it->end, end);
+
+		auto next = it + 1;
+		while (next != ranges.end() && next->start <= it->end + mergeGap) {
+			it->end = std::max(it->end, next->end);
+			++next;
+		}
+		ranges.erase(it + 1, next);
+	}
+
+	while (ranges.size() > maxRanges)
+		MergeClosest();
+}
+
+void DirtyRanges::AddAll() {
+	all = true;
+	ranges.clear();
+}
+
+void DirtyRanges::Clear() {
+	all = false;
+	ranges.clear();
+}
+
+bool DirtyRanges::IsDirty() const {
+	return all || !ranges.empty();
+}
+
+bool DirtyRanges::IsAll() const {
+	return all;
+}
+
+const std::vector<DirtyRanges::Range>& DirtyRanges::GetRanges() const {
+	return ranges;
+}
+
+int DirtyRanges::DirtyCount(int count) const {
+	if (all)
+		return count;
+
+	int dirty = 0;
+	for (auto &r : ranges) {
+		int s = std::max(0, r.start);
+		int e = std::min(count, r.end);
+		if (e > s)
+			dirty += e - s;
+	}
+
+	return dirty;
+}
+
+void DirtyRanges::MergeClosest() {
+	if (ranges.size() < 2)
+		return;
+
+	int best = 0;
+	int bestGap = ranges[1].start - ranges[0].end;
+	for (int i = 1; i < ranges.size() - 1; i++) {
+		int gap = ranges[i + 1].start - ranges[i].end;
+		if (gap < bestGap) {
+			bestGap = gap;
+			best = i;
+		}
+	}
+
+	ranges[best].end = std::max(ranges[best].end, ranges[best + 1].end);
+	ranges.erase(ranges.begin() + best + 1);
+}
@@ -0,0 +1,54 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <vector>
+
+// Tracks modified elements of an array as a short, sorted list of half-open ranges [start, end).
+// Ranges that are close to each other are coalesced, and once the list is full the two ranges
+// with the smallest gap between them are merged, so the list never exceeds maxRanges entries.
+class DirtyRanges {
+public:
+	struct Range {
+		int start = 0;
+		int end = 0;
+
+		Range() {}
+		Range(int s, int e) : start(s), end(e) {}
+	};
+
+private:
+	std::vector<Range> ranges;
+	bool all = false;
+	int maxRanges = 8;
+	int mergeGap = 16;
+
+	void MergeClosest();
+
+public:
+	DirtyRanges(int maxRanges = 8, int mergeGap = 16);
+
+	// Marks a single element.
+	void Add(int index);
+
+	// Marks the elements [start, end).
+	void Add(int start, int end);
+
+	// Marks every element of the array, regardless of its size.
+	void AddAll();
+
+	void Clear();
+
+	bool IsDirty() const;
+	bool IsAll() const;
+
+	// Sorted, non-overlapping ranges. Empty if nothing or everything is dirty.
+	const std::vector<Range>& GetRanges() const;
+
+	// Number of elements covered by the ranges, clamped to count elements.
+	int DirtyCount(int count) const;
+};
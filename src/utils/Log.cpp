@@ -8,6 +8,8 @@ See the included LICENSE file
 
 #include <wx/utils.h>
 
+#include <chrono>
+
 /*
 <LogLevel>
 -1: Off
@@ -17,7 +19,7 @@ See the included LICENSE file
 3: wxLogMessage
 */
 
-void Log::Initialize(int level, const wxString& fileName) {
+void Log::Initialize(int level, const wxString& fileName, int flushInterval) {
 	wxLog::EnableLogging(false);
 
 	if (level >= 0) {
@@ -64,27 +66,26 @@ void Log::Initialize(int level, const wxString& fileName) {
 			truncStream.close();
 		}
 
-		//Open ofstream, creating empty log file
-		stream.open(fileName.ToStdString(), std::ios_base::app);
-		if (stream) {
-			wxLog* log = new wxLogStream(&stream);
+		//Open log file, replacing the old one if part of it was kept
+		AsyncLogSink* log = new AsyncLogSink(fileName, !textCopy.empty(), flushInterval);
+		if (log->IsOk()) {
 			log->SetLogLevel(level);
 
 			//Copy partial contents of old to new log
-			if (!textCopy.empty()) {
-				stream.close();
-				stream.clear();
-				stream.open(fileName.ToStdString());
+			if (!textCopy.empty())
 				log->LogText(textCopy);
-			}
 
 			//Write new signature line with date
 			log->LogText(wxString::Format("%s %s]", signature, wxNow()));
 
+			sink = log;
+			log->owner = this;
 			wxLog::SetActiveTarget(log);
 			wxLog::EnableLogging();
 			SetFormatter();
 		}
+		else
+			delete log;
 	}
 }
 
@@ -99,3 +100,165 @@ void Log::SetFormatter(bool withFile) {
 	if (oldFormatter)
 		delete oldFormatter;
 }
+
+void Log::Flush() {
+	if (sink)
+		sink->Drain();
+}
+
+Log::~Log() {
+	//wxLog keeps the sink alive for lines logged during cleanup
+	if (sink)
+		sink->owner = nullptr;
+}
+
+AsyncLogSink::AsyncLogSink(const wxString& fileName, bool truncate, int flushInterval, size_t maxPending) {
+	stream.open(fileName.ToStdString(), truncate ? std::ios_base::trunc : std::ios_base::app);
+
+	this->maxPending = maxPending > 0 ? maxPending : 1;
+	this->flushInterval = flushInterval;
+
+	if (stream.is_open())
+		writer = std::thread(&AsyncLogSink::WriterLoop, this);
+	else
+		stopped = true;
+}
+
+AsyncLogSink::~AsyncLogSink() {
+	Stop();
+
+	if (owner)
+		owner->sink = nullptr;
+}
+
+void AsyncLogSink::Enqueue(const wxString& msg, bool urgent) {
+	std::string text = msg.ToStdString();
+	text.push_back('\n');
+
+	bool queued = false;
+	bool full = false;
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		//Checked under the lock, so Stop's final pass always sees a queued line
+		if (!stopped) {
+			pending.push_back(std::move(text));
+			queued = true;
+			full = pending.size() >= maxPending;
+			notify = urgent || flushInterval <= 0 || pending.size() > maxPending / 2;
+			if (notify)
+				wakeRequested = true;
+		}
+	}
+
+	if (!queued) {
+		std::lock_guard<std::timed_mutex> lock(writeMutex);
+		WriteQueued();
+		stream << text;
+		stream.flush();
+		return;
+	}
+
+	if (full) {
+		//Too many lines waiting, write them out from this thread
+		std::lock_guard<std::timed_mutex> lock(writeMutex);
+		WriteQueued();
+	}
+	else if (notify)
+		wake.notify_one();
+}
+
+void AsyncLogSink::WakeWriter() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		wakeRequested = true;
+	}
+	wake.notify_one();
+}
+
+void AsyncLogSink::WriteQueued() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		writing.swap(pending);
+	}
+
+	if (writing.empty())
+		return;
+
+	size_t batchSize = 0;
+	for (auto &line : writing)
+		batchSize += line.size();
+
+	std::string batch;
+	batch.reserve(batchSize);
+	for (auto &line : writing)
+		batch.append(line);
+
+	writing.clear();
+
+	stream.write(batch.data(), batch.size());
+	stream.flush();
+}
+
+void AsyncLogSink::WriterLoop() {
+	auto interval = std::chrono::milliseconds(flushInterval > 0 ? flushInterval : 1000);
+
+	for (;;) {
+		bool stop = false;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			wake.wait_for(lock, interval, [&]() { return wakeRequested || stopped; });
+			wakeRequested = false;
+			stop = stopped;
+		}
+
+		std::lock_guard<std::timed_mutex> lock(writeMutex);
+		WriteQueued();
+
+		//Nothing is queued once stopped, this pass wrote the rest
+		if (stop)
+			break;
+	}
+}
+
+void AsyncLogSink::DoLogText(const wxString& msg) {
+	Enqueue(msg, false);
+}
+
+void AsyncLogSink::DoLogTextAtLevel(wxLogLevel level, const wxString& msg) {
+	//Debug output goes where the default target sends it
+	if (level == wxLOG_Debug || level == wxLOG_Trace) {
+		wxLog::DoLogTextAtLevel(level, msg);
+		return;
+	}
+
+	Enqueue(msg, level <= wxLOG_Warning);
+}
+
+void AsyncLogSink::Flush() {
+	wxLog::Flush();
+	WakeWriter();
+}
+
+bool AsyncLogSink::Drain(int timeout) {
+	std::unique_lock<std::timed_mutex> lock(writeMutex, std::defer_lock);
+	if (!lock.try_lock_for(std::chrono::milliseconds(timeout)))
+		return false;
+
+	WriteQueued();
+	return true;
+}
+
+void AsyncLogSink::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopped = true;
+	}
+	wake.notify_one();
+
+	if (writer.joinable())
+		writer.join();
+
+	//Without a writer thread nothing else writes the queue
+	Drain();
+}
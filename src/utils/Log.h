@@ -9,6 +9,10 @@ See the included LICENSE file
 #include <wx/datetime.h>
 #include <wx/log.h>
 #include <fstream>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 //Example
 //[19:30:25][3] Log.h(10): Message here
@@ -32,14 +36,79 @@ class LogFormatterNoFile : public wxLogFormatter {
 	}
 };
 
-class Log {
-	//Stream doing the actual writing
+class Log;
+
+//Log target writing the formatted lines to a file from a background thread.
+//wxLog hands lines from other threads to the main thread, so in practice there is a single producer
+//and a plain mutex guarded queue is enough. Lines are swapped out and written in batches.
+//Errors and warnings wake the writer right away, other lines are written at least every flush interval.
+//If too many lines are waiting, the logging thread writes them itself instead of dropping any.
+class AsyncLogSink : public wxLog {
+	friend class Log;
+
 	std::ofstream stream;
+	//Cleared by the owner when it goes away first
+	Log* owner = nullptr;
+
+	std::vector<std::string> pending;
+	size_t maxPending;
+	bool wakeRequested = false;
+	bool stopped = false;
+	//Guards pending, wakeRequested and stopped
+	std::mutex queueMutex;
+	std::condition_variable wake;
+
+	//Held while lines are written, always taken before queueMutex to keep the order of batches
+	std::timed_mutex writeMutex;
+	//Batch being written, keeps its capacity between passes
+	std::vector<std::string> writing;
+	int flushInterval;
+	std::thread writer;
+
+	void Enqueue(const wxString& msg, bool urgent);
+	void WakeWriter();
+	//Writes all queued lines and flushes the file, requires writeMutex
+	void WriteQueued();
+	void WriterLoop();
+
+protected:
+	virtual void DoLogText(const wxString& msg);
+	virtual void DoLogTextAtLevel(wxLogLevel level, const wxString& msg);
+
+public:
+	//Flush interval in milliseconds, 0 writes every line as soon as possible
+	AsyncLogSink(const wxString& fileName, bool truncate, int flushInterval = 1000, size_t maxPending = 4096);
+	virtual ~AsyncLogSink();
+
+	bool IsOk() {
+		return stream.is_open();
+	}
+
+	virtual void Flush();
+
+	//Writes the queued lines from the calling thread, giving up after the timeout if the writer is stuck
+	bool Drain(int timeout = 1000);
+
+	//Stops the writer thread after writing everything, later lines are written directly
+	void Stop();
+};
+
+class Log {
+	friend class AsyncLogSink;
+
+	//Target doing the actual writing, owned and deleted by wxLog once active.
+	//The sink resets this when it is deleted, so it never dangles.
+	AsyncLogSink* sink = nullptr;
 
 public:
+	~Log();
+
 	//Opens and truncates log file to a maximum of runs
-	void Initialize(int level = -1, const wxString& fileName = "Log.txt");
+	void Initialize(int level = -1, const wxString& fileName = "Log.txt", int flushInterval = 1000);
 
 	//Swaps out log formatter
 	void SetFormatter(bool withFile = true);
+
+	//Writes all pending lines, for crash handlers
+	void Flush();
 };
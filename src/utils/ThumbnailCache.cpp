@@ -0,0 +1,145 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "ThumbnailCache.h"
+#include "../files/wxDDSImage.h"
+
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+
+#include <algorithm>
+#include <vector>
+
+ThumbnailCache::ThumbnailCache(const wxString& cacheDir, const int maxSize, const int maxAgeDays, const unsigned long long maxCacheSize) {
+	this->cacheDir = cacheDir;
+	this->maxSize = maxSize;
+	this->maxAgeDays = maxAgeDays;
+	this->maxCacheSize = maxCacheSize;
+}
+
+wxString ThumbnailCache::GetCacheFile(const wxString& fileName) {
+	wxFileName file(fileName);
+	file.MakeAbsolute();
+
+	// FNV-1a over the lowercase path and the modification time
+	unsigned long long hash = 14695981039346656037ULL;
+	wxScopedCharBuffer path = file.GetFullPath().Lower().utf8_str();
+	for (size_t i = 0; i < path.length(); i++) {
+		hash ^= (unsigned char)path[i];
+		hash *= 1099511628211ULL;
+	}
+
+	wxLongLong ticks = file.GetModificationTime().GetValue();
+	for (int i = 0; i < 8; i++) {
+		hash ^= (unsigned char)((ticks >> (i * 8)).GetLo() & 0xFF);
+		hash *= 1099511628211ULL;
+	}
+
+	return wxString::Format("%s%c%016llx_%d.png", cacheDir, wxFileName::GetPathSeparator(), hash, maxSize);
+}
+
+bool ThumbnailCache::LoadSource(const wxString& fileName, wxImage& outImage) {
+	if (!wxFileName(fileName).GetExt().IsSameAs("dds", false))
+		return outImage.LoadFile(fileName);
+
+	wxFileInputStream stream(fileName);
+	if (!stream.IsOk())
+		return false;
+
+	int level = wxDDSHandler::GetMipLevelForSize(stream, maxSize);
+	return outImage.LoadFile(stream, wxBITMAP_TYPE_ANY, level);
+}
+
+void ThumbnailCache::Prune() {
+	pruned = true;
+	if (!wxDir::Exists(cacheDir))
+		return;
+
+	struct Entry {
+		wxString fileName;
+		long long lastUsed;
+		unsigned long long size;
+	};
+
+	wxArrayString files;
+	wxDir::GetAllFiles(cacheDir, &files, "*.png", wxDIR_FILES);
+
+	long long oldest = (wxDateTime::Now() - wxTimeSpan::Days(maxAgeDays)).GetValue().GetValue();
+	unsigned long long totalSize = 0;
+	std::vector<Entry> entries;
+	for (auto &f : files) {
+		wxFileName fn(f);
+		long long lastUsed = fn.GetModificationTime().GetValue().GetValue();
+		if (lastUsed < oldest) {
+			wxRemoveFile(f);
+			continue;
+		}
+
+		unsigned long long size = fn.GetSize().GetValue();
+		entries.push_back({ f, lastUsed, size });
+		totalSize += size;
+	}
+
+	if (totalSize <= maxCacheSize)
+		return;
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		return a.lastUsed < b.lastUsed;
+	});
+
+	for (auto &e : entries) {
+		if (totalSize <= maxCacheSize)
+			break;
+
+		if (wxRemoveFile(e.fileName))
+			totalSize -= e.size;
+	}
+}
+
+bool ThumbnailCache::Load(const wxString& fileName, wxImage& outImage) {
+	if (!wxFileName::FileExists(fileName))
+		return false;
+
+	if (!pruned)
+		Prune();
+
+	wxString cacheFile = GetCacheFile(fileName);
+	if (wxFileName::FileExists(cacheFile) && outImage.LoadFile(cacheFile, wxBITMAP_TYPE_PNG)) {
+		// The modification time of a thumbnail is when it was last used
+		wxFileName(cacheFile).Touch();
+		return true;
+	}
+
+	wxImage image;
+	if (!LoadSource(fileName, image) || !image.IsOk())
+		return false;
+
+	int width = image.GetWidth();
+	int height = image.GetHeight();
+	if (width > maxSize || height > maxSize) {
+		if (width >= height) {
+			height = std::max(1, height * maxSize / width);
+			width = maxSize;
+		}
+		else {
+			width = std::max(1, width * maxSize / height);
+			height = maxSize;
+		}
+
+		image.Rescale(width, height, wxIMAGE_QUALITY_BOX_AVERAGE);
+	}
+
+	if (!wxFileName::DirExists(cacheDir))
+		wxFileName::Mkdir(cacheDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	// Failing to write the cache only costs the decoding next time
+	if (image.SaveFile(cacheFile, wxBITMAP_TYPE_PNG))
+		Prune();
+
+	outImage = image;
+	return true;
+}
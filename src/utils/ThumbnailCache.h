@@ -0,0 +1,35 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <wx/image.h>
+#include <wx/string.h>
+
+// Small previews of image files, kept as PNG files in a cache folder.
+// Entries are keyed by the path and modification time of the source, so changed files get a new thumbnail.
+// DDS files are decoded from the first mip level that fits the thumbnail instead of the full texture.
+// Thumbnails that weren't used for maxAgeDays are removed, then the least recently used ones until the
+// folder is below maxCacheSize bytes. This happens on first use and whenever a thumbnail is added.
+class ThumbnailCache {
+	wxString cacheDir;
+	int maxSize = 128;
+	int maxAgeDays = 30;
+	unsigned long long maxCacheSize = 32 * 1024 * 1024;
+	bool pruned = false;
+
+	wxString GetCacheFile(const wxString& fileName);
+	bool LoadSource(const wxString& fileName, wxImage& outImage);
+
+public:
+	ThumbnailCache(const wxString& cacheDir, const int maxSize = 128, const int maxAgeDays = 30, const unsigned long long maxCacheSize = 32 * 1024 * 1024);
+
+	// Removes old thumbnails and keeps the cache folder within its size.
+	void Prune();
+
+	// Loads the thumbnail of the file, creating the cache entry if there is none yet.
+	bool Load(const wxString& fileName, wxImage& outImage);
+};
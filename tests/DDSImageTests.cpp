@@ -0,0 +1,129 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TestMain.h"
+#include "../src/files/wxDDSImage.h"
+
+#include <wx/mstream.h>
+
+#include <cstring>
+
+static void WriteUInt(std::vector<unsigned char>& data, const size_t offset, const unsigned int value) {
+	data[offset] = value & 0xFF;
+	data[offset + 1] = (value >> 8) & 0xFF;
+	data[offset + 2] = (value >> 16) & 0xFF;
+	data[offset + 3] = (value >> 24) & 0xFF;
+}
+
+//DDS file with a single level of the blocks, which are given row by row
+static std::vector<unsigned char> MakeDDS(const char* fourCC, const int width, const int height, const std::vector<unsigned char>& blocks) {
+	std::vector<unsigned char> data(128, 0);
+	memcpy(&data[0], "DDS ", 4);
+	WriteUInt(data, 4, 124);
+	WriteUInt(data, 8, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000);	//Caps, height, width, pixel format, linear size
+	WriteUInt(data, 12, height);
+	WriteUInt(data, 16, width);
+	WriteUInt(data, 20, blocks.size());
+	WriteUInt(data, 76, 32);
+	WriteUInt(data, 80, 0x4);	//FourCC
+	memcpy(&data[84], fourCC, 4);
+	WriteUInt(data, 108, 0x1000);	//Texture
+
+	data.insert(data.end(), blocks.begin(), blocks.end());
+	return data;
+}
+
+static bool LoadDDS(const std::vector<unsigned char>& data, wxImage& image) {
+	wxMemoryInputStream stream(data.data(), data.size());
+	wxDDSHandler handler;
+	return handler.LoadFile(&image, stream, false);
+}
+
+static void CheckPixel(wxImage& image, const int x, const int y, const int r, const int g, const int b) {
+	const unsigned char* p = image.GetData() + (y * image.GetWidth() + x) * 3;
+	CHECK_EQUAL(p[0], r);
+	CHECK_EQUAL(p[1], g);
+	CHECK_EQUAL(p[2], b);
+}
+
+//Indices 0, 1, 2, 3 from left to right in every row
+static const unsigned char rampIndices[4] = { 0xE4, 0xE4, 0xE4, 0xE4 };
+
+TEST(DDSDecodesDXT1Blocks) {
+	std::vector<unsigned char> blocks = {
+		//Red > blue, four colors
+		0x00, 0xF8, 0x1F, 0x00, rampIndices[0], rampIndices[1], rampIndices[2], rampIndices[3],
+		//Blue <= red, three colors and transparent black
+		0x1F, 0x00, 0x00, 0xF8, rampIndices[0], rampIndices[1], rampIndices[2], rampIndices[3]
+	};
+
+	wxImage image;
+	CHECK(LoadDDS(MakeDDS("DXT1", 8, 4, blocks), image));
+	CHECK_EQUAL(image.GetWidth(), 8);
+	CHECK_EQUAL(image.GetHeight(), 4);
+	if (!image.IsOk())
+		return;
+
+	for (int y = 0; y < 4; y++) {
+		CheckPixel(image, 0, y, 255, 0, 0);
+		CheckPixel(image, 1, y, 0, 0, 255);
+		CheckPixel(image, 2, y, 170, 0, 85);
+		CheckPixel(image, 3, y, 85, 0, 170);
+
+		CheckPixel(image, 4, y, 0, 0, 255);
+		CheckPixel(image, 5, y, 255, 0, 0);
+		CheckPixel(image, 6, y, 127, 0, 127);
+		CheckPixel(image, 7, y, 0, 0, 0);
+	}
+}
+
+TEST(DDSDecodesDXT3Blocks) {
+	std::vector<unsigned char> blocks = {
+		//Explicit alpha, not decoded
+		0xFF, 0xFF, 0x00, 0x00, 0x0F, 0xF0, 0x12, 0x34,
+		//Green <= red, but only DXT1 blocks have the three color mode
+		0xE0, 0x07, 0x00, 0xF8, rampIndices[0], rampIndices[1], rampIndices[2], rampIndices[3]
+	};
+
+	wxImage image;
+	CHECK(LoadDDS(MakeDDS("DXT3", 4, 4, blocks), image));
+	if (!image.IsOk())
+		return;
+
+	for (int y = 0; y < 4; y++) {
+		CheckPixel(image, 0, y, 0, 255, 0);
+		CheckPixel(image, 1, y, 255, 0, 0);
+		CheckPixel(image, 2, y, 85, 170, 0);
+		CheckPixel(image, 3, y, 170, 85, 0);
+	}
+}
+
+TEST(DDSDecodesDXT5BlocksOfPartialSize) {
+	//White and black with one index per row
+	const unsigned char block[16] = {
+		0xFF, 0x00, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+		0xFF, 0xFF, 0x00, 0x00, 0x00, 0x55, 0xAA, 0xFF
+	};
+
+	//2x2 blocks for 6x6 pixels
+	std::vector<unsigned char> blocks;
+	for (int b = 0; b < 4; b++)
+		blocks.insert(blocks.end(), block, block + 16);
+
+	wxImage image;
+	CHECK(LoadDDS(MakeDDS("DXT5", 6, 6, blocks), image));
+	CHECK_EQUAL(image.GetWidth(), 6);
+	CHECK_EQUAL(image.GetHeight(), 6);
+	if (!image.IsOk())
+		return;
+
+	const int rowColors[4] = { 255, 0, 170, 85 };
+	for (int y = 0; y < 6; y++) {
+		int c = rowColors[y % 4];
+		for (int x = 0; x < 6; x++)
+			CheckPixel(image, x, y, c, c, c);
+	}
+}
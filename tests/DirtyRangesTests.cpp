@@ -0,0 +1,131 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TestMain.h"
+#include "../src/utils/DirtyRanges.h"
+
+static void CheckRange(const DirtyRanges& dirty, const size_t index, const int start, const int end) {
+	CHECK(index < dirty.GetRanges().size());
+	if (index >= dirty.GetRanges().size())
+		return;
+
+	CHECK_EQUAL(dirty.GetRanges()[index].start, start);
+	CHECK_EQUAL(dirty.GetRanges()[index].end, end);
+}
+
+TEST(DirtyRangesStartsClean) {
+	DirtyRanges dirty;
+	CHECK(!dirty.IsDirty());
+	CHECK(!dirty.IsAll());
+	CHECK(dirty.GetRanges().empty());
+	CHECK_EQUAL(dirty.DirtyCount(100), 0);
+
+	//Empty and reversed ranges are ignored
+	dirty.Add(5, 5);
+	dirty.Add(8, 3);
+	CHECK(!dirty.IsDirty());
+}
+
+TEST(DirtyRangesKeepsRangesSorted) {
+	DirtyRanges dirty(8, 0);
+	dirty.Add(20, 22);
+	dirty.Add(0, 2);
+	dirty.Add(10);
+
+	CHECK_EQUAL(dirty.GetRanges().size(), 3);
+	CheckRange(dirty, 0, 0, 2);
+	CheckRange(dirty, 1, 10, 11);
+	CheckRange(dirty, 2, 20, 22);
+	CHECK_EQUAL(dirty.DirtyCount(100), 5);
+}
+
+TEST(DirtyRangesMergesOverlappingRanges) {
+	DirtyRanges dirty(8, 0);
+	dirty.Add(0, 2);
+	dirty.Add(4, 6);
+	dirty.Add(8, 10);
+	dirty.Add(20, 30);
+
+	//Spans the first three ranges
+	dirty.Add(1, 9);
+	CHECK_EQUAL(dirty.GetRanges().size(), 2);
+	CheckRange(dirty, 0, 0, 10);
+	CheckRange(dirty, 1, 20, 30);
+
+	//Touching ranges are merged even without a gap
+	dirty.Add(10, 12);
+	dirty.Add(18, 20);
+	CHECK_EQUAL(dirty.GetRanges().size(), 2);
+	CheckRange(dirty, 0, 0, 12);
+	CheckRange(dirty, 1, 18, 30);
+
+	//Contained ranges don't change anything
+	dirty.Add(22, 25);
+	CHECK_EQUAL(dirty.GetRanges().size(), 2);
+	CheckRange(dirty, 1, 18, 30);
+	CHECK_EQUAL(dirty.DirtyCount(100), 24);
+}
+
+TEST(DirtyRangesCoalescesWithinGap) {
+	DirtyRanges dirty(8, 4);
+	dirty.Add(0, 2);
+	dirty.Add(6);
+	dirty.Add(20);
+
+	CHECK_EQUAL(dirty.GetRanges().size(), 2);
+	CheckRange(dirty, 0, 0, 7);
+	CheckRange(dirty, 1, 20, 21);
+
+	//Closes the gap to both neighbors at once
+	dirty.Add(11, 16);
+	CHECK_EQUAL(dirty.GetRanges().size(), 1);
+	CheckRange(dirty, 0, 0, 21);
+}
+
+TEST(DirtyRangesMergesClosestWhenFull) {
+	DirtyRanges dirty(2, 0);
+	dirty.Add(0);
+	dirty.Add(10);
+	dirty.Add(13);
+
+	CHECK_EQUAL(dirty.GetRanges().size(), 2);
+	CheckRange(dirty, 0, 0, 1);
+	CheckRange(dirty, 1, 10, 14);
+
+	dirty.Add(40);
+	dirty.Add(41);
+	CHECK_EQUAL(dirty.GetRanges().size(), 2);
+	CheckRange(dirty, 0, 0, 14);
+	CheckRange(dirty, 1, 40, 42);
+
+	//Counts are clamped to the size of the array
+	CHECK_EQUAL(dirty.DirtyCount(100), 16);
+	CHECK_EQUAL(dirty.DirtyCount(12), 12);
+}
+
+TEST(DirtyRangesAllAndClear) {
+	DirtyRanges dirty;
+	dirty.Add(3, 7);
+	dirty.AddAll();
+	CHECK(dirty.IsDirty());
+	CHECK(dirty.IsAll());
+	CHECK(dirty.GetRanges().empty());
+	CHECK_EQUAL(dirty.DirtyCount(50), 50);
+
+	//Everything is dirty already
+	dirty.Add(60, 70);
+	CHECK(dirty.GetRanges().empty());
+
+	dirty.Clear();
+	CHECK(!dirty.IsDirty());
+	CHECK(!dirty.IsAll());
+	CHECK_EQUAL(dirty.DirtyCount(50), 0);
+
+	dirty.Add(60, 70);
+	CHECK(!dirty.IsAll());
+	CHECK_EQUAL(dirty.GetRanges().size(), 1);
+	CheckRange(dirty, 0, 60, 70);
+}
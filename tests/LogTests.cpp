@@ -0,0 +1,104 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TestMain.h"
+#include "../src/utils/Log.h"
+
+#include <chrono>
+#include <string>
+
+static std::vector<std::string> ReadLines(const std::string& fileName) {
+	std::vector<std::string> lines;
+	std::ifstream file(fileName);
+	std::string line;
+	while (std::getline(file, line))
+		lines.push_back(line);
+
+	return lines;
+}
+
+TEST(LogSinkKeepsOrderOfEachThread) {
+	const int threadCount = 4;
+	const int lineCount = 2000;
+
+	//Small queue, so the logging threads also write batches themselves
+	AsyncLogSink* sink = new AsyncLogSink("LogTests.txt", true, 0, 16);
+	CHECK(sink->IsOk());
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([=]() {
+			for (int i = 0; i < lineCount; i++)
+				sink->LogTextAtLevel(wxLOG_Message, wxString::Format("%d %d", t, i));
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	delete sink;
+
+	std::vector<int> next(threadCount, 0);
+	int total = 0;
+	for (auto &line : ReadLines("LogTests.txt")) {
+		int t = -1;
+		int i = -1;
+		if (sscanf(line.c_str(), "%d %d", &t, &i) != 2 || t < 0 || t >= threadCount)
+			continue;
+
+		CHECK_EQUAL(i, next[t]);
+		next[t] = i + 1;
+		total++;
+	}
+
+	CHECK_EQUAL(total, threadCount * lineCount);
+}
+
+TEST(LogSinkDrainWritesQueuedLines) {
+	//Long interval, the writer thread doesn't get to the lines on its own
+	AsyncLogSink sink("LogTests.txt", true, 60000);
+	for (int i = 0; i < 10; i++)
+		sink.LogTextAtLevel(wxLOG_Message, wxString::Format("line %d", i));
+
+	CHECK(sink.Drain());
+
+	auto lines = ReadLines("LogTests.txt");
+	CHECK_EQUAL(lines.size(), (size_t)10);
+	if (lines.size() == 10) {
+		CHECK_EQUAL(lines.front(), std::string("line 0"));
+		CHECK_EQUAL(lines.back(), std::string("line 9"));
+	}
+}
+
+TEST(LogSinkWakesWriterForErrors) {
+	AsyncLogSink sink("LogTests.txt", true, 60000);
+	sink.LogTextAtLevel(wxLOG_Message, "message");
+	sink.LogTextAtLevel(wxLOG_Error, "error");
+
+	//Written by the writer thread well before the flush interval
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::string> lines;
+	while (lines.size() < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		lines = ReadLines("LogTests.txt");
+	}
+
+	CHECK_EQUAL(lines.size(), (size_t)2);
+}
+
+TEST(LogSinkWritesLinesAfterStop) {
+	AsyncLogSink sink("LogTests.txt", true, 60000);
+	sink.LogTextAtLevel(wxLOG_Message, "before");
+	sink.Stop();
+	sink.LogTextAtLevel(wxLOG_Message, "after");
+
+	auto lines = ReadLines("LogTests.txt");
+	CHECK_EQUAL(lines.size(), (size_t)2);
+	if (lines.size() == 2) {
+		CHECK_EQUAL(lines[0], std::string("before"));
+		CHECK_EQUAL(lines[1], std::string("after"));
+	}
+}
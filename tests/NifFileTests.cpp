@@ -0,0 +1,164 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TestMain.h"
+#include "../lib/NIF/NifFile.h"
+
+#include <algorithm>
+#include <set>
+
+//Adds an empty shape with the name under the root node
+static NiShape* AddShape(NifFile& nif, const std::string& name) {
+	NiTriShape* shape = new NiTriShape();
+	shape->SetName(name);
+
+	int shapeId = nif.GetHeader().AddBlock(shape);
+	nif.GetHeader().GetBlock<NiNode>(nif.GetRootNodeID())->AddChildRef(shapeId);
+	return shape;
+}
+
+TEST(NifFileFindsRenamedDuplicateShapes) {
+	NifFile nif;
+	CHECK_EQUAL(nif.Load("res/SkeletonBlank_sk.nif"), 0);
+	if (!nif.IsValid())
+		return;
+
+	NiShape* first = AddShape(nif, "Shape");
+	NiShape* second = AddShape(nif, "Shape");
+	NiShape* third = AddShape(nif, "Shape");
+
+	CHECK(nif.RenameDuplicateShapes());
+	CHECK_EQUAL(first->GetName(), "Shape");
+	CHECK_EQUAL(second->GetName(), "Shape_1");
+	CHECK_EQUAL(third->GetName(), "Shape_2");
+
+	//The name index has to follow the renames
+	CHECK(nif.FindShapeByName("Shape") == first);
+	CHECK(nif.FindShapeByName("Shape", 1) == nullptr);
+	CHECK(nif.FindShapeByName("Shape_1") == second);
+	CHECK(nif.FindShapeByName("Shape_2") == third);
+
+	std::vector<std::string> shapes;
+	nif.GetShapeList(shapes);
+	for (auto &s : shapes)
+		CHECK(nif.FindShapeByName(s) != nullptr);
+}
+
+//Sorted references of every block, to compare files block by block
+static std::vector<std::vector<int>> GetBlockRefs(NifFile& nif) {
+	std::vector<std::vector<int>> blockRefs;
+	for (int i = 0; i < nif.GetHeader().GetNumBlocks(); i++) {
+		std::set<int*> refs;
+		nif.GetHeader().GetBlock<NiObject>(i)->GetChildRefs(refs);
+
+		std::vector<int> ids;
+		for (auto &r : refs)
+			ids.push_back(*r);
+
+		std::sort(ids.begin(), ids.end());
+		blockRefs.push_back(ids);
+	}
+	return blockRefs;
+}
+
+TEST(NifFileDeletesBlocksOfPartialLoads) {
+	NifFile partial;
+	CHECK_EQUAL(partial.Load("res/skeleton_fo4.nif", true), 0);
+	if (!partial.IsValid())
+		return;
+
+	NiHeader& hdr = partial.GetHeader();
+	CHECK(hdr.HasDeferredBlocks());
+
+	//The header can't update references inside raw blocks and leaves them alone
+	int numBlocks = hdr.GetNumBlocks();
+	NiObject* lo = hdr.GetBlock<NiObject>(1);
+	NiObject* hi = hdr.GetBlock<NiObject>(2);
+	hdr.DeleteBlock(1);
+	hdr.DeleteBlockByType("NiNode");
+	hdr.SwapBlocks(1, 2);
+	hdr.DeleteUnreferencedBlocks();
+	CHECK_EQUAL(hdr.GetNumBlocks(), numBlocks);
+	CHECK(hdr.GetBlock<NiObject>(1) == lo);
+	CHECK(hdr.GetBlock<NiObject>(2) == hi);
+	CHECK(hdr.IsBlockReferenced(numBlocks - 1));
+
+	//NifFile parses them first, giving the same result as a full load
+	NifFile full;
+	CHECK_EQUAL(full.Load("res/skeleton_fo4.nif"), 0);
+	full.DeleteBlock(1);
+	partial.DeleteBlock(1);
+
+	CHECK(!hdr.HasDeferredBlocks());
+	CHECK_EQUAL(hdr.GetNumBlocks(), numBlocks - 1);
+	CHECK_EQUAL(full.GetHeader().GetNumBlocks(), numBlocks - 1);
+	CHECK(GetBlockRefs(partial) == GetBlockRefs(full));
+}
+
+TEST(NifFileDeleteKeepsUnrelatedBlockTypes) {
+	NifFile nif;
+	CHECK_EQUAL(nif.Load("res/SkeletonBlank_sk.nif"), 0);
+	if (!nif.IsValid())
+		return;
+
+	NiHeader& hdr = nif.GetHeader();
+	NiShape* first = AddShape(nif, "First");
+	NiShape* second = AddShape(nif, "Second");
+
+	//A type without blocks stays until one of its blocks is deleted
+	ushort unusedType = hdr.AddOrFindBlockTypeId("BSUnusedType");
+	int numTypes = hdr.GetBlockTypeCount();
+
+	hdr.DeleteBlock(nif.GetBlockID(first));
+	CHECK_EQUAL(hdr.GetBlockTypeCount(), numTypes);
+
+	//The last block of a type takes the type with it
+	hdr.DeleteBlock(nif.GetBlockID(second));
+	CHECK_EQUAL(hdr.GetBlockTypeCount(), numTypes - 1);
+	CHECK_EQUAL(hdr.AddOrFindBlockTypeId("BSUnusedType"), unusedType - 1);
+
+	hdr.DeleteBlocks({ 1, 2 });
+	numTypes = hdr.GetBlockTypeCount();
+	hdr.AddOrFindBlockTypeId("BSUnusedType");
+	CHECK_EQUAL(hdr.GetBlockTypeCount(), numTypes);
+
+	//The index follows the blocks that moved down
+	for (int i = 0; i < hdr.GetNumBlocks(); i++) {
+		NiObject* block = hdr.GetBlock<NiObject>(i);
+		CHECK_EQUAL(nif.GetBlockID(block), i);
+
+		auto node = dynamic_cast<NiNode*>(block);
+		if (node)
+			CHECK(nif.FindNodeByName(node->GetName()) == node);
+	}
+}
+
+TEST(NifFileSetStringKeepsLookups) {
+	NifFile nif;
+	CHECK_EQUAL(nif.Load("res/SkeletonBlank_sk.nif"), 0);
+	if (!nif.IsValid())
+		return;
+
+	NiHeader& hdr = nif.GetHeader();
+	int first = hdr.AddOrFindStringId("First");
+	int second = hdr.AddOrFindStringId("Second");
+	int numStrings = hdr.GetStringCount();
+
+	hdr.SetStringById(first, "Renamed");
+	CHECK_EQUAL(hdr.FindStringId("First"), 0xFFFFFFFF);
+	CHECK_EQUAL(hdr.FindStringId("Renamed"), first);
+	CHECK_EQUAL(hdr.FindStringId("Second"), second);
+
+	//The first of two equal strings is found
+	hdr.SetStringById(second, "Renamed");
+	CHECK_EQUAL(hdr.FindStringId("Second"), 0xFFFFFFFF);
+	CHECK_EQUAL(hdr.FindStringId("Renamed"), first);
+
+	hdr.SetStringById(second, "Second");
+	CHECK_EQUAL(hdr.AddOrFindStringId("Second"), second);
+	CHECK_EQUAL(hdr.AddOrFindStringId("Renamed"), first);
+	CHECK_EQUAL(hdr.GetStringCount(), numStrings);
+}
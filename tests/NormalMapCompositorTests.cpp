@@ -0,0 +1,115 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TestMain.h"
+#include "../src/components/NormalMapCompositor.h"
+
+#include <wx/image.h>
+
+static void SaveImage(const std::string& fileName, const int width, const int height, const std::vector<unsigned char>& pixels) {
+	wxImage image(width, height, const_cast<unsigned char*>(pixels.data()), true);
+	image.SaveFile(fileName, wxBITMAP_TYPE_BMP);
+}
+
+static std::vector<unsigned char> FillPixels(const int width, const int height, const unsigned char r, const unsigned char g, const unsigned char b) {
+	std::vector<unsigned char> pixels(width * height * 3);
+	for (int i = 0; i < width * height; i++) {
+		pixels[i * 3] = r;
+		pixels[i * 3 + 1] = g;
+		pixels[i * 3 + 2] = b;
+	}
+	return pixels;
+}
+
+static void CheckTexel(const NormalMapCompositor::Image& image, const int x, const int y, const int r, const int g, const int b) {
+	const unsigned char* p = &image.pixels[(y * image.width + x) * 3];
+	CHECK_EQUAL(p[0], r);
+	CHECK_EQUAL(p[1], g);
+	CHECK_EQUAL(p[2], b);
+}
+
+TEST(NormalMapCompositorLayerStack) {
+	const int size = 8;
+
+	//Tangent space layer that tilts the normal along the tangent, masked to the top half of the texture
+	SaveImage("CompositorTilt.bmp", size, size, FillPixels(size, size, 255, 128, 128));
+
+	std::vector<unsigned char> mask = FillPixels(size, size, 0, 0, 0);
+	std::fill(mask.begin(), mask.begin() + size * size / 2 * 3, 255);
+	SaveImage("CompositorMask.bmp", size, size, mask);
+
+	//Unscaled model space layer of 2x2 texels in the bottom left corner
+	SaveImage("CompositorModel.bmp", 2, 2, FillPixels(2, 2, 0, 255, 128));
+
+	std::vector<NormalGenLayer> layers(3);
+	layers[0].layerName = "Background";
+	layers[0].fillColor[0] = 128;
+	layers[0].fillColor[1] = 128;
+	layers[0].fillColor[2] = 255;
+	layers[0].resolution = size;
+
+	layers[1].layerName = "Tilt";
+	layers[1].sourceFileName = "CompositorTilt.bmp";
+	layers[1].maskFileName = "CompositorMask.bmp";
+
+	layers[2].layerName = "Model";
+	layers[2].sourceFileName = "CompositorModel.bmp";
+	layers[2].isTangentSpace = false;
+	layers[2].scaleToResolution = false;
+	layers[2].yOffset = size - 2;
+
+	//Flat quad facing +Z on the left half of the UVs
+	mesh quad;
+	quad.nVerts = 4;
+	quad.nTris = 2;
+	quad.verts = std::make_unique<Vector3[]>(quad.nVerts);
+	quad.norms = std::make_unique<Vector3[]>(quad.nVerts);
+	quad.texcoord = std::make_unique<Vector2[]>(quad.nVerts);
+	quad.tris = std::make_unique<Triangle[]>(quad.nTris);
+	quad.verts[0] = Vector3(0.0f, 0.0f, 0.0f);
+	quad.verts[1] = Vector3(1.0f, 0.0f, 0.0f);
+	quad.verts[2] = Vector3(1.0f, 1.0f, 0.0f);
+	quad.verts[3] = Vector3(0.0f, 1.0f, 0.0f);
+	quad.texcoord[0] = Vector2(0.0f, 0.0f);
+	quad.texcoord[1] = Vector2(0.5f, 0.0f);
+	quad.texcoord[2] = Vector2(0.5f, 1.0f);
+	quad.texcoord[3] = Vector2(0.0f, 1.0f);
+	for (int i = 0; i < quad.nVerts; i++)
+		quad.norms[i] = Vector3(0.0f, 0.0f, 1.0f);
+	quad.tris[0] = Triangle(0, 1, 2);
+	quad.tris[1] = Triangle(0, 2, 3);
+
+	NormalMapCompositor compositor(layers);
+	compositor.AddMesh(&quad);
+	CHECK_EQUAL(compositor.GetResolution(), size);
+	CHECK(compositor.Composite());
+
+	const NormalMapCompositor::Image& output = compositor.GetOutput();
+	CHECK_EQUAL(output.width, size);
+	CHECK_EQUAL(output.height, size);
+	if (!output.IsOk())
+		return;
+
+	//Outside of the UVs the background fill color is kept
+	CheckTexel(output, 6, 1, 128, 128, 255);
+	CheckTexel(output, 4, 7, 128, 128, 255);
+
+	//The tilt layer turns the normal into the tangent, which is -X in the model space of the quad
+	CheckTexel(output, 0, 0, 255, 128, 128);
+	CheckTexel(output, 3, 3, 255, 128, 128);
+
+	//Masked out, the mesh normal stays
+	CheckTexel(output, 2, 5, 128, 128, 255);
+
+	//The model space layer replaces the normal with its own, mirrored on X
+	CheckTexel(output, 0, 6, 37, 218, 128);
+	CheckTexel(output, 1, 7, 37, 218, 128);
+	CheckTexel(output, 2, 7, 128, 128, 255);
+
+	remove("CompositorTilt.bmp");
+	remove("CompositorMask.bmp");
+	remove("CompositorModel.bmp");
+}
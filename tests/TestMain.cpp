@@ -0,0 +1,47 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "TestMain.h"
+
+#include <wx/init.h>
+
+#include <cstring>
+
+int testFailures = 0;
+
+std::vector<TestCase>& GetTestCases() {
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+//Runs all tests, or only those whose name contains the first argument
+int main(int argc, char* argv[]) {
+	//Image handlers and the like need wxWidgets to be initialized
+	wxInitializer initializer(argc, argv);
+	if (!initializer.IsOk())
+		return 1;
+
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int testCount = 0;
+	int failedCount = 0;
+	for (auto &test : GetTestCases()) {
+		if (filter && !strstr(test.name, filter))
+			continue;
+
+		int failuresBefore = testFailures;
+		test.func();
+		testCount++;
+
+		if (testFailures != failuresBefore) {
+			printf("FAILED: %s\n", test.name);
+			failedCount++;
+		}
+	}
+
+	printf("%d of %d tests passed\n", testCount - failedCount, testCount);
+	return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//Tests register themselves and are all run by TestMain.cpp.
+//Failed checks print their location and make the run return a non-zero exit code.
+
+struct TestCase {
+	const char* name;
+	void(*func)();
+};
+
+std::vector<TestCase>& GetTestCases();
+extern int testFailures;
+
+struct TestRegistrar {
+	TestRegistrar(const char* name, void(*func)()) {
+		GetTestCases().push_back({ name, func });
+	}
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+			testFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(a, b) \
+	do { \
+		if (!((a) == (b))) { \
+			printf("%s(%d): CHECK_EQUAL(%s, %s) failed\n", __FILE__, __LINE__, #a, #b); \
+			testFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_CLOSE(a, b, epsilon) \
+	do { \
+		if (std::fabs((a) - (b)) > (epsilon)) { \
+			printf("%s(%d): CHECK_CLOSE(%s, %s) failed: %g != %g\n", __FILE__, __LINE__, #a, #b, (double)(a), (double)(b)); \
+			testFailures++; \
+		} \
+	} while (0)